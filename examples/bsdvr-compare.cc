@@ -0,0 +1,290 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Comparison harness: the same nodes, radio, mobility and traffic routed by
+ * bsdvr, aodv, dsdv or olsr, selected with --protocol.
+ *
+ * Nodes are placed on a grid or uniformly in a disc, as in bsdvr-scaling, and
+ * optionally move with RandomWaypoint when --maxSpeed is positive. The radio
+ * is a unit disk of --range meters. CBR/UDP flows between random node pairs
+ * start at --trafficStart, shortly after the routing protocols, so that route
+ * establishment is part of the measurement.
+ *
+ * Every protocol is measured the same way:
+ *  - control overhead: UDP packets to or from the protocol's port, counted at
+ *    the Ipv4L3Protocol Tx trace of every node, IP header included;
+ *  - PDR and mean delay of the CBR flows, from FlowMonitor;
+ *  - convergence: the time from --trafficStart to the first delivery of each
+ *    flow, mean and max over the flows that were delivered at all;
+ *  - simulator CPU: process CPU seconds and events of Simulator::Run.
+ *
+ * One CSV row is written per run, appended to --output if given, so that
+ *
+ *   for p in bsdvr aodv dsdv olsr; do
+ *     ./waf --run "bsdvr-compare --protocol=$p --nodes=50 --output=compare.csv"
+ *   done
+ *
+ * collects one row per protocol with the same seed, topology and traffic.
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include "ns3/bsdvr-module.h"
+#include "ns3/aodv-module.h"
+#include "ns3/dsdv-module.h"
+#include "ns3/olsr-module.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/flow-monitor-module.h"
+#include "bsdvr-example-common.h"
+#include "bsdvr-example-scenario.h"
+
+using namespace ns3;
+
+/// UDP port of the routing protocol under test
+static uint16_t g_routingPort = 0;
+/// Control packets sent or forwarded by all nodes
+static uint64_t g_controlPackets = 0;
+/// Bytes of the control packets, IP header included
+static uint64_t g_controlBytes = 0;
+/// First delivery of each flow, negative until delivered
+static std::vector<double> g_firstRx;
+
+/// Ipv4L3Protocol Tx trace sink counting the routing protocol packets
+static void
+IpTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  Ptr<Packet> copy = packet->Copy ();
+  Ipv4Header ip;
+  copy->RemoveHeader (ip);
+  if (ip.GetProtocol () != UdpL4Protocol::PROT_NUMBER || ip.GetFragmentOffset () != 0)
+    {
+      return;
+    }
+  UdpHeader udp;
+  copy->PeekHeader (udp);
+  if (udp.GetSourcePort () == g_routingPort || udp.GetDestinationPort () == g_routingPort)
+    {
+      g_controlPackets++;
+      g_controlBytes += packet->GetSize ();
+    }
+}
+
+/// PacketSink Rx trace sink recording the first delivery of a flow
+static void
+FlowRx (std::string context, Ptr<const Packet> packet, Address const & from)
+{
+  uint32_t flow = std::strtoul (context.c_str (), 0, 10);
+  if (g_firstRx[flow] < 0)
+    {
+      g_firstRx[flow] = Simulator::Now ().GetSeconds ();
+    }
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  std::string protocol = "bsdvr";
+  uint32_t size = 50;
+  std::string topology = "disc";
+  double spacing = 80;
+  double range = 100;
+  double density = 8;
+  double maxSpeed = 0;
+  double pause = 0;
+  uint32_t flowCount = 10;
+  double packetRate = 4;
+  uint32_t packetSize = 512;
+  double trafficStart = 1;
+  double duration = 100;
+  uint32_t run = 1;
+  std::string output = "";
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("protocol", "Routing protocol: bsdvr, aodv, dsdv or olsr", protocol);
+  cmd.AddValue ("nodes", "Number of nodes", size);
+  cmd.AddValue ("topology", "Node placement: grid or disc", topology);
+  cmd.AddValue ("spacing", "Distance between grid neighbors, in meters", spacing);
+  cmd.AddValue ("range", "Radio range, in meters", range);
+  cmd.AddValue ("density", "Mean number of neighbors in a disc", density);
+  cmd.AddValue ("maxSpeed", "Highest RandomWaypoint speed in m/s, 0 for static nodes", maxSpeed);
+  cmd.AddValue ("pause", "RandomWaypoint pause, in seconds", pause);
+  cmd.AddValue ("flows", "Number of CBR flows between random node pairs", flowCount);
+  cmd.AddValue ("packetRate", "Packets per second of each flow", packetRate);
+  cmd.AddValue ("packetSize", "Bytes per packet", packetSize);
+  cmd.AddValue ("trafficStart", "Time the flows start, in seconds", trafficStart);
+  cmd.AddValue ("duration", "Simulated seconds", duration);
+  cmd.AddValue ("run", "Random number generator run", run);
+  cmd.AddValue ("output", "CSV file the row is appended to, standard output if empty", output);
+  cmd.Parse (argc, argv);
+  NS_ABORT_MSG_IF (size < 2, "At least two nodes are needed");
+  NS_ABORT_MSG_IF (duration <= trafficStart, "duration must exceed trafficStart");
+
+  RngSeedManager::SetRun (run);
+
+  NodeContainer nodes;
+  nodes.Create (size);
+
+  // Placement, shared by all protocols for a given run
+  MobilityHelper mobility;
+  double side;
+  if (topology == "grid")
+    {
+      uint32_t width = std::ceil (std::sqrt (size));
+      side = spacing * (width - 1);
+      mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                     "MinX", DoubleValue (0.0),
+                                     "MinY", DoubleValue (0.0),
+                                     "DeltaX", DoubleValue (spacing),
+                                     "DeltaY", DoubleValue (spacing),
+                                     "GridWidth", UintegerValue (width),
+                                     "LayoutType", StringValue ("RowFirst"));
+    }
+  else if (topology == "disc")
+    {
+      double radius = range * std::sqrt (size / density);
+      side = 2 * radius;
+      mobility.SetPositionAllocator ("ns3::UniformDiscPositionAllocator",
+                                     "rho", DoubleValue (radius),
+                                     "X", DoubleValue (radius),
+                                     "Y", DoubleValue (radius));
+    }
+  else
+    {
+      NS_FATAL_ERROR ("Unknown topology " << topology << ", expected grid or disc");
+    }
+  if (maxSpeed > 0)
+    {
+      // Waypoints in the square holding the initial placement
+      std::ostringstream coordinate, speed, pauseTime;
+      coordinate << "ns3::UniformRandomVariable[Min=0.0|Max=" << side << "]";
+      speed << "ns3::UniformRandomVariable[Min=" << std::min (1.0, maxSpeed) << "|Max=" << maxSpeed << "]";
+      pauseTime << "ns3::ConstantRandomVariable[Constant=" << pause << "]";
+      ObjectFactory positions;
+      positions.SetTypeId ("ns3::RandomRectanglePositionAllocator");
+      positions.Set ("X", StringValue (coordinate.str ()));
+      positions.Set ("Y", StringValue (coordinate.str ()));
+      Ptr<PositionAllocator> waypoints = positions.Create ()->GetObject<PositionAllocator> ();
+      waypoints->AssignStreams (1000);
+      mobility.SetMobilityModel ("ns3::RandomWaypointMobilityModel",
+                                 "Speed", StringValue (speed.str ()),
+                                 "Pause", StringValue (pauseTime.str ()),
+                                 "PositionAllocator", PointerValue (waypoints));
+    }
+  else
+    {
+      mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+    }
+  mobility.Install (nodes);
+  MobilityHelper::AssignStreams (nodes, 0);
+
+  NetDeviceContainer devices = InstallUnitDiskWifi (nodes, range);
+  WifiHelper ().AssignStreams (devices, 2000);
+
+  // Stream 3000 onwards belongs to the routing protocol, so that placement,
+  // mobility and traffic do not depend on the protocol under test
+  BsdvrHelper bsdvr;
+  AodvHelper aodv;
+  DsdvHelper dsdv;
+  OlsrHelper olsr;
+  InternetStackHelper internet;
+  if (protocol == "bsdvr")
+    {
+      internet.SetRoutingHelper (bsdvr);
+      g_routingPort = bsdvr::RoutingProtocol::BSDVR_PORT;
+    }
+  else if (protocol == "aodv")
+    {
+      internet.SetRoutingHelper (aodv);
+      g_routingPort = 654;
+    }
+  else if (protocol == "dsdv")
+    {
+      internet.SetRoutingHelper (dsdv);
+      g_routingPort = 269;
+    }
+  else if (protocol == "olsr")
+    {
+      internet.SetRoutingHelper (olsr);
+      g_routingPort = 698;
+    }
+  else
+    {
+      NS_FATAL_ERROR ("Unknown protocol " << protocol << ", expected bsdvr, aodv, dsdv or olsr");
+    }
+  internet.Install (nodes);
+  Ipv4InterfaceContainer interfaces = AssignAddresses (devices);
+  if (protocol == "bsdvr")
+    {
+      bsdvr.AssignStreams (nodes, 3000);
+    }
+  else if (protocol == "aodv")
+    {
+      aodv.AssignStreams (nodes, 3000);
+    }
+  else if (protocol == "olsr")
+    {
+      olsr.AssignStreams (nodes, 3000);
+    }
+  Config::ConnectWithoutContext ("/NodeList/*/$ns3::Ipv4L3Protocol/Tx", MakeCallback (&IpTx));
+
+  uint16_t port = 9;
+  Ptr<UniformRandomVariable> pick = CreateObject<UniformRandomVariable> ();
+  pick->SetStream (4000);
+  g_firstRx.assign (flowCount, -1);
+  ApplicationContainer sinks = InstallCbrFlows (nodes, interfaces, flowCount, port, packetRate, packetSize,
+                                                Seconds (trafficStart), Seconds (duration), pick);
+  for (uint32_t f = 0; f < flowCount; f++)
+    {
+      std::ostringstream context;
+      context << f;
+      sinks.Get (f)->TraceConnect ("Rx", context.str (), MakeCallback (&FlowRx));
+    }
+
+  FlowMonitorHelper flowHelper;
+  Ptr<FlowMonitor> monitor = flowHelper.InstallAll ();
+
+  Simulator::Stop (Seconds (duration));
+  double cpu = GetCpuSeconds ();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  Simulator::Run ();
+  double wall = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  cpu = GetCpuSeconds () - cpu;
+
+  CbrFlowTotals flows = GetCbrFlowTotals (flowHelper, monitor, port, flowCount);
+  uint32_t reached = 0;
+  double firstRxTotal = 0;
+  double firstRxMax = 0;
+  for (std::vector<double>::const_iterator f = g_firstRx.begin (); f != g_firstRx.end (); ++f)
+    {
+      if (*f >= 0)
+        {
+          reached++;
+          firstRxTotal += *f - trafficStart;
+          firstRxMax = std::max (firstRxMax, *f - trafficStart);
+        }
+    }
+
+  std::ofstream file;
+  std::ostream & os = OpenCsvOutput (output,
+                                     "protocol,topology,nodes,max_speed,flows,run,tx_packets,rx_packets,pdr,delay_ms,"
+                                     "control_packets,control_bytes,overhead_bytes_per_data_byte,"
+                                     "convergence_mean_s,convergence_max_s,flows_unreached,events,cpu_s,wall_s", file);
+  os << protocol << "," << topology << "," << size << "," << maxSpeed << "," << flowCount << "," << run << ","
+     << flows.m_txPackets << "," << flows.m_rxPackets << ","
+     << (flows.m_txPackets ? double (flows.m_rxPackets) / flows.m_txPackets : 0) << ","
+     << (flows.m_rxPackets ? flows.m_delay.GetSeconds () * 1000 / flows.m_rxPackets : 0) << ","
+     << g_controlPackets << "," << g_controlBytes << ","
+     << (flows.m_rxBytes ? double (g_controlBytes) / flows.m_rxBytes : 0) << ","
+     << (reached ? firstRxTotal / reached : -1) << "," << (reached ? firstRxMax : -1) << ","
+     << flowCount - reached << "," << Simulator::GetEventCount () << "," << cpu << "," << wall << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,47 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "bsdvr-example-common.h"
+#include <iostream>
+#include <sys/resource.h>
+
+namespace ns3 {
+
+std::ostream &
+OpenCsvOutput (std::string const & output, std::string const & header, std::ofstream & file)
+{
+  bool isNew = true;
+  if (!output.empty ())
+    {
+      std::ifstream existing (output.c_str ());
+      isNew = !existing || existing.peek () == std::ifstream::traits_type::eof ();
+      file.open (output.c_str (), std::ios::app);
+    }
+  std::ostream & os = output.empty () ? std::cout : file;
+  if (isNew)
+    {
+      os << header << std::endl;
+    }
+  return os;
+}
+
+double
+GetCpuSeconds ()
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+         + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+uint64_t
+GetPeakRss ()
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+}
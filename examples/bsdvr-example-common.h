@@ -0,0 +1,36 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef BSDVR_EXAMPLE_COMMON_H
+#define BSDVR_EXAMPLE_COMMON_H
+
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <stdint.h>
+
+/*
+ * Scaffolding shared by the BSDVR benchmark programs that only need the core
+ * module: CSV output and process resource usage.
+ */
+
+namespace ns3 {
+
+/**
+ * Open the CSV output of a benchmark. Rows are appended to the file, and the
+ * header line is written first when the file is new or empty, so that a sweep
+ * of runs collects one file.
+ * \param output the CSV file, standard output if empty
+ * \param header the header line, without its end of line
+ * \param file the stream opened on the file, kept open by the caller
+ * \returns the stream the rows are written to
+ */
+std::ostream & OpenCsvOutput (std::string const & output, std::string const & header, std::ofstream & file);
+
+/// \returns the process CPU time, user and system, in seconds
+double GetCpuSeconds ();
+
+/// \returns the peak resident set size of the process, in kilobytes
+uint64_t GetPeakRss ();
+
+}
+
+#endif /* BSDVR_EXAMPLE_COMMON_H */
@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "bsdvr-example-scenario.h"
+
+namespace ns3 {
+
+NetDeviceContainer
+InstallAdhocWifi (NodeContainer nodes, Ptr<YansWifiChannel> channel)
+{
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_STANDARD_80211a);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode", StringValue ("OfdmRate6Mbps"),
+                                "ControlMode", StringValue ("OfdmRate6Mbps"));
+  YansWifiPhyHelper phy;
+  phy.SetChannel (channel);
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  return wifi.Install (phy, mac, nodes);
+}
+
+NetDeviceContainer
+InstallUnitDiskWifi (NodeContainer nodes, double range)
+{
+  YansWifiChannelHelper channel;
+  channel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  channel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (range));
+  return InstallAdhocWifi (nodes, channel.Create ());
+}
+
+Ipv4InterfaceContainer
+AssignAddresses (NetDeviceContainer devices)
+{
+  Ipv4AddressHelper address;
+  address.SetBase ("10.0.0.0", "255.255.0.0");
+  return address.Assign (devices);
+}
+
+ApplicationContainer
+InstallCbrFlows (NodeContainer nodes, Ipv4InterfaceContainer const & interfaces,
+                 uint32_t count, uint16_t port, double packetRate, uint32_t packetSize,
+                 Time start, Time stop, Ptr<UniformRandomVariable> pick)
+{
+  ApplicationContainer sinks;
+  for (uint32_t f = 0; f < count; f++)
+    {
+      uint32_t src = pick->GetInteger (0, nodes.GetN () - 1);
+      uint32_t dst = pick->GetInteger (0, nodes.GetN () - 2);
+      dst += (dst >= src) ? 1 : 0;
+      PacketSinkHelper sink ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port + f));
+      ApplicationContainer sinkApp = sink.Install (nodes.Get (dst));
+      sinkApp.Start (start);
+      sinkApp.Stop (stop);
+      sinks.Add (sinkApp);
+      OnOffHelper onoff ("ns3::UdpSocketFactory", InetSocketAddress (interfaces.GetAddress (dst), port + f));
+      onoff.SetConstantRate (DataRate (uint64_t (packetRate * packetSize * 8)), packetSize);
+      ApplicationContainer app = onoff.Install (nodes.Get (src));
+      app.Start (start + Seconds (pick->GetValue (0, 1 / packetRate)));
+      app.Stop (stop);
+    }
+  return sinks;
+}
+
+CbrFlowTotals
+GetCbrFlowTotals (FlowMonitorHelper & flowHelper, Ptr<FlowMonitor> monitor, uint16_t port, uint32_t count)
+{
+  monitor->CheckForLostPackets ();
+  Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowHelper.GetClassifier ());
+  FlowMonitor::FlowStatsContainer const & flows = monitor->GetFlowStats ();
+  CbrFlowTotals totals;
+  for (FlowMonitor::FlowStatsContainer::const_iterator i = flows.begin (); i != flows.end (); ++i)
+    {
+      Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow (i->first);
+      if (t.protocol != UdpL4Protocol::PROT_NUMBER || t.destinationPort < port || t.destinationPort >= port + count)
+        {
+          continue;
+        }
+      totals.m_txPackets += i->second.txPackets;
+      totals.m_rxPackets += i->second.rxPackets;
+      totals.m_rxBytes += i->second.rxBytes;
+      totals.m_delay += i->second.delaySum;
+    }
+  return totals;
+}
+
+}
@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef BSDVR_EXAMPLE_SCENARIO_H
+#define BSDVR_EXAMPLE_SCENARIO_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/flow-monitor-module.h"
+
+/*
+ * Scaffolding shared by the BSDVR simulation benchmarks: the radio, the
+ * addresses, the CBR traffic and its FlowMonitor totals.
+ */
+
+namespace ns3 {
+
+/**
+ * Install ad-hoc 802.11a WiFi at a constant 6 Mbit/s
+ * \param nodes the nodes
+ * \param channel the channel the devices are attached to
+ * \returns the devices
+ */
+NetDeviceContainer InstallAdhocWifi (NodeContainer nodes, Ptr<YansWifiChannel> channel);
+
+/**
+ * Install ad-hoc WiFi with a unit disk radio: a RangePropagationLossModel
+ * delivers every frame within range and none beyond, which keeps the PHY
+ * cheap and makes the topology exactly the one the placement gives
+ * \param nodes the nodes
+ * \param range the radio range, in meters
+ * \returns the devices
+ */
+NetDeviceContainer InstallUnitDiskWifi (NodeContainer nodes, double range);
+
+/**
+ * Assign the addresses from 10.0.0.0/16, outside the 10.1.1.x range that
+ * RoutingProtocol excludes from link failure handling
+ * \param devices the devices, at most 65000
+ * \returns the interfaces
+ */
+Ipv4InterfaceContainer AssignAddresses (NetDeviceContainer devices);
+
+/**
+ * Install CBR/UDP flows between random node pairs, flow f being received on
+ * UDP port port + f
+ * \param nodes the nodes
+ * \param interfaces the node addresses
+ * \param count the number of flows
+ * \param port the port of the first flow
+ * \param packetRate packets per second of each flow
+ * \param packetSize bytes per packet
+ * \param start the time the sinks start, each source starting within one packet interval after it
+ * \param stop the time the flows stop
+ * \param pick the random variable picking the node pairs and the source start times
+ * \returns the packet sinks, the one of flow f at index f
+ */
+ApplicationContainer InstallCbrFlows (NodeContainer nodes, Ipv4InterfaceContainer const & interfaces,
+                                      uint32_t count, uint16_t port, double packetRate, uint32_t packetSize,
+                                      Time start, Time stop, Ptr<UniformRandomVariable> pick);
+
+/// FlowMonitor totals of the CBR flows
+struct CbrFlowTotals
+{
+  CbrFlowTotals ()
+    : m_txPackets (0),
+      m_rxPackets (0),
+      m_rxBytes (0)
+  {
+  }
+  uint64_t m_txPackets;  ///< packets sent
+  uint64_t m_rxPackets;  ///< packets delivered
+  uint64_t m_rxBytes;    ///< bytes delivered
+  Time m_delay;          ///< summed end-to-end delay of the delivered packets
+};
+
+/**
+ * Sum the FlowMonitor statistics of the CBR flows installed by
+ * InstallCbrFlows; the routing control messages, which are UDP flows too,
+ * are left out
+ * \param flowHelper the helper that installed the monitor
+ * \param monitor the monitor
+ * \param port the port of the first flow
+ * \param count the number of flows
+ * \returns the totals
+ */
+CbrFlowTotals GetCbrFlowTotals (FlowMonitorHelper & flowHelper, Ptr<FlowMonitor> monitor, uint16_t port, uint32_t count);
+
+}
+
+#endif /* BSDVR_EXAMPLE_SCENARIO_H */
@@ -60,7 +60,7 @@ main (int argc, char *argv[])
   // r2.SetRouteState (ns3::bsdvr::ACTIVE);
   r1.Print (&fs, Time::Unit ());
   r2.Print (&fs, Time::Unit ());
-  std::cout << "Threshold for hopCount is: " << bsdvr::constants::BSDVR_THRESHOLD << std::endl;
+  std::cout << "Threshold for hopCount is: " << protocol.GetHopThreshold () << std::endl;
   std::cout<< "r1 is better than r2: " << protocol.isBetterRoute2(r1,r2) << std::endl;
   /* ... */
   protocol.RefreshForwardingTable2 (Ipv4Address (), Ipv4Address ());
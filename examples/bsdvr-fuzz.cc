@@ -0,0 +1,518 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Convergence fuzzer: drives a BsdvrEngineNetwork through random topologies
+ * and random sequences of link and node failures and recoveries, and of
+ * INACTIVE UPDATEs, which have the receivers queue pending replies, and checks
+ * the forwarding tables every time the network is quiet:
+ *
+ *   loop      following ACTIVE next hops towards a destination cycles
+ *   missing   no route to a destination reachable within the threshold
+ *   inactive  an INACTIVE route to a destination reachable within the threshold
+ *   hop       an ACTIVE route whose hop count is not the shortest path length
+ *   stale     an ACTIVE route to an unreachable destination, or through a
+ *             next hop that is not an up neighbor
+ *
+ * Shortest paths are computed over the links that are up. A step applies one
+ * to --maxBatch random actions at once before the network runs, so that
+ * failures overlap; a step that does not converge within --maxEvents is
+ * counted and ends its trial. Trial t uses stream t of run --run, so a
+ * reported violation is reproduced, and its events recorded for
+ * bsdvr-replay, with
+ *
+ *   ./waf --run "bsdvr-fuzz --run=<run> --firstTrial=<t> --trials=1 --record=t.trace"
+ *
+ * Only the engine work is timed: the CSV row reports events per second, which
+ * makes the fuzzer a stress benchmark of the forwarding table computation and
+ * the pending reply queue as well. Build with --build-profile=optimized for
+ * meaningful numbers. The exit status is 1 if any invariant was violated.
+ *
+ *   ./waf --run "bsdvr-fuzz --trials=1000 --maxNodes=60 --output=fuzz.csv"
+ */
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <sstream>
+#include "ns3/bsdvr-module.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "bsdvr-example-common.h"
+
+using namespace ns3;
+using namespace ns3::bsdvr;
+
+namespace {
+
+/// Distance of an unreachable node
+const uint32_t UNREACHABLE = std::numeric_limits<uint32_t>::max ();
+
+/// Violation counts by invariant
+struct Violations
+{
+  Violations ()
+    : m_loops (0),
+      m_missing (0),
+      m_inactive (0),
+      m_hops (0),
+      m_stale (0),
+      m_nonConverged (0)
+  {
+  }
+  /// \returns the number of violations
+  uint64_t GetTotal () const
+  {
+    return m_loops + m_missing + m_inactive + m_hops + m_stale + m_nonConverged;
+  }
+  uint64_t m_loops;         ///< destinations with a forwarding loop
+  uint64_t m_missing;       ///< reachable destinations without a route
+  uint64_t m_inactive;      ///< reachable destinations with an INACTIVE route
+  uint64_t m_hops;          ///< ACTIVE routes longer or shorter than the shortest path
+  uint64_t m_stale;         ///< ACTIVE routes to unreachable destinations or through a down link
+  uint64_t m_nonConverged;  ///< steps stopped at maxEvents
+};
+
+/**
+ * Link the nodes of a network
+ * \param network the network
+ * \param topology disc or random
+ * \param density the mean number of neighbors
+ * \param rng the random variable placing the nodes or drawing the links
+ */
+void
+Build (BsdvrEngineNetwork & network, std::string const & topology, double density, Ptr<UniformRandomVariable> rng)
+{
+  uint32_t size = network.GetSize ();
+  if (topology == "disc")
+    {
+      // Unit range: N / radius^2 neighbors on average, ignoring the border
+      double radius = std::sqrt (size / density);
+      std::vector<double> x (size);
+      std::vector<double> y (size);
+      for (uint32_t i = 0; i < size; i++)
+        {
+          double rho = radius * std::sqrt (rng->GetValue ());
+          double theta = rng->GetValue (0, 2 * M_PI);
+          x[i] = rho * std::cos (theta);
+          y[i] = rho * std::sin (theta);
+        }
+      for (uint32_t i = 0; i < size; i++)
+        {
+          for (uint32_t j = i + 1; j < size; j++)
+            {
+              if ((x[i] - x[j]) * (x[i] - x[j]) + (y[i] - y[j]) * (y[i] - y[j]) <= 1)
+                {
+                  network.AddLink (i, j);
+                }
+            }
+        }
+    }
+  else if (topology == "random")
+    {
+      // Every pair is linked with the same probability
+      double p = std::min (1.0, density / (size - 1));
+      for (uint32_t i = 0; i < size; i++)
+        {
+          for (uint32_t j = i + 1; j < size; j++)
+            {
+              if (rng->GetValue () < p)
+                {
+                  network.AddLink (i, j);
+                }
+            }
+        }
+    }
+  else
+    {
+      NS_FATAL_ERROR ("Unknown topology " << topology << ", expected disc, random or mixed");
+    }
+}
+
+/**
+ * Apply one random action: a link or a node fails or comes back, or a node
+ * sends a neighbor an INACTIVE UPDATE about another node, as it would on
+ * losing its route
+ * \param network the network
+ * \param rng the random variable picking the action
+ * \returns false if the picked action had no candidate
+ */
+bool
+Act (BsdvrEngineNetwork & network, Ptr<UniformRandomVariable> rng)
+{
+  uint32_t a = rng->GetInteger (0, network.GetSize () - 1);
+  double action = rng->GetValue ();
+  if (action < 0.3)
+    {
+      network.IsNodeUp (a) ? network.FailNode (a) : network.RestoreNode (a);
+      return true;
+    }
+  std::vector<uint32_t> const & links = network.GetLinks (a);
+  if (links.empty ())
+    {
+      return false;
+    }
+  uint32_t b = links[rng->GetInteger (0, links.size () - 1)];
+  if (action < 0.45)
+    {
+      uint32_t d = rng->GetInteger (0, network.GetSize () - 1);
+      if (d == a || d == b || !network.IsUp (a, b))
+        {
+          return false;
+        }
+      network.InjectUpdate (a, b, d, UPDATE_STATE_INACTIVE);
+      return true;
+    }
+  if (network.IsUp (a, b))
+    {
+      network.FailLink (a, b);
+    }
+  else
+    {
+      network.RestoreLink (a, b);
+    }
+  return true;
+}
+
+/**
+ * Hop counts of the shortest paths from a node over the links that are up
+ * \param network the network
+ * \param source the node index
+ * \returns the distance of every node, UNREACHABLE if there is no path
+ */
+std::vector<uint32_t>
+ShortestPaths (BsdvrEngineNetwork const & network, uint32_t source)
+{
+  std::vector<uint32_t> distance (network.GetSize (), UNREACHABLE);
+  std::deque<uint32_t> queue;
+  distance[source] = 0;
+  queue.push_back (source);
+  while (!queue.empty ())
+    {
+      uint32_t n = queue.front ();
+      queue.pop_front ();
+      for (std::vector<uint32_t>::const_iterator j = network.GetLinks (n).begin (); j != network.GetLinks (n).end (); ++j)
+        {
+          if (distance[*j] == UNREACHABLE && network.IsUp (n, *j))
+            {
+              distance[*j] = distance[n] + 1;
+              queue.push_back (*j);
+            }
+        }
+    }
+  return distance;
+}
+
+/**
+ * \brief Checks the forwarding tables of a quiet network
+ */
+class Checker
+{
+public:
+  /**
+   * constructor
+   * \param threshold the hop threshold
+   * \param maxReports the number of violations of each invariant printed in full
+   */
+  Checker (uint32_t threshold, uint32_t maxReports)
+    : m_threshold (threshold),
+      m_maxReports (maxReports),
+      m_checks (0)
+  {
+  }
+  /**
+   * Check every forwarding table entry and every destination
+   * \param network the network
+   * \param where the trial and step, prefixed to the reports
+   */
+  void Check (BsdvrEngineNetwork const & network, std::string const & where)
+  {
+    uint32_t size = network.GetSize ();
+    std::vector<std::vector<uint32_t> > distance (size);
+    for (uint32_t d = 0; d < size; d++)
+      {
+        distance[d] = ShortestPaths (network, d);
+      }
+    for (uint32_t i = 0; i < size; i++)
+      {
+        std::map<Ipv4Address, RoutingTableEntry> const * ft = network.GetRoutingTable (i).GetForwardingTable ();
+        for (uint32_t d = 0; d < size; d++)
+          {
+            if (d == i)
+              {
+                continue;
+              }
+            m_checks++;
+            bool reachable = distance[d][i] <= m_threshold;
+            std::map<Ipv4Address, RoutingTableEntry>::const_iterator e = ft->find (BsdvrEngineNetwork::GetAddress (d));
+            if (e == ft->end ())
+              {
+                if (reachable)
+                  {
+                    Report (m_violations.m_missing, where, "missing", i, d, distance[d][i], "no route");
+                  }
+                continue;
+              }
+            RoutingTableEntry const & rt = e->second;
+            std::ostringstream got;
+            got << "next hop " << BsdvrEngineNetwork::GetIndex (rt.GetNextHop ()) << " hops " << rt.GetHop ()
+                << ((rt.GetRouteState () == ACTIVE) ? " ACTIVE" : " INACTIVE");
+            if (rt.GetRouteState () != ACTIVE)
+              {
+                if (reachable)
+                  {
+                    Report (m_violations.m_inactive, where, "inactive", i, d, distance[d][i], got.str ());
+                  }
+                continue;
+              }
+            uint32_t next = BsdvrEngineNetwork::GetIndex (rt.GetNextHop ());
+            if (!reachable || next >= size || !IsNeighbor (network, i, next))
+              {
+                Report (m_violations.m_stale, where, "stale", i, d, distance[d][i], got.str ());
+              }
+            else if (rt.GetHop () != distance[d][i])
+              {
+                Report (m_violations.m_hops, where, "hop", i, d, distance[d][i], got.str ());
+              }
+          }
+      }
+    for (uint32_t d = 0; d < size; d++)
+      {
+        CheckLoops (network, d, distance[d], where);
+      }
+  }
+  /**
+   * Count a step that did not converge
+   * \param where the trial and step
+   * \param maxEvents the event limit
+   */
+  void NotConverged (std::string const & where, uint64_t maxEvents)
+  {
+    if (m_violations.m_nonConverged < m_maxReports)
+      {
+        std::cerr << where << ": no convergence after " << maxEvents << " events" << std::endl;
+      }
+    m_violations.m_nonConverged++;
+  }
+  /// \returns the violations found so far
+  Violations const & GetViolations () const
+  {
+    return m_violations;
+  }
+  /// \returns the number of (node, destination) pairs checked
+  uint64_t GetChecks () const
+  {
+    return m_checks;
+  }
+
+private:
+  /**
+   * \param network the network
+   * \param a a node index
+   * \param b a node index
+   * \returns true if a and b are linked and the link is up
+   */
+  static bool IsNeighbor (BsdvrEngineNetwork const & network, uint32_t a, uint32_t b)
+  {
+    std::vector<uint32_t> const & links = network.GetLinks (a);
+    return std::find (links.begin (), links.end (), b) != links.end () && network.IsUp (a, b);
+  }
+  /**
+   * Follow the ACTIVE next hops towards a destination from every node
+   * \param network the network
+   * \param d the destination index
+   * \param distance the shortest path length from every node to d
+   * \param where the trial and step
+   */
+  void CheckLoops (BsdvrEngineNetwork const & network, uint32_t d, std::vector<uint32_t> const & distance,
+                   std::string const & where)
+  {
+    uint32_t size = network.GetSize ();
+    Ipv4Address dst = BsdvrEngineNetwork::GetAddress (d);
+    // 0 not visited, 1 on the current walk, 2 known to end
+    std::vector<uint8_t> mark (size, 0);
+    mark[d] = 2;
+    for (uint32_t start = 0; start < size; start++)
+      {
+        std::vector<uint32_t> walk;
+        uint32_t n = start;
+        while (n < size && mark[n] == 0)
+          {
+            mark[n] = 1;
+            walk.push_back (n);
+            std::map<Ipv4Address, RoutingTableEntry> const * ft = network.GetRoutingTable (n).GetForwardingTable ();
+            std::map<Ipv4Address, RoutingTableEntry>::const_iterator e = ft->find (dst);
+            n = (e == ft->end () || e->second.GetRouteState () != ACTIVE)
+              ? size : BsdvrEngineNetwork::GetIndex (e->second.GetNextHop ());
+          }
+        if (n < size && mark[n] == 1)
+          {
+            std::ostringstream cycle;
+            for (std::vector<uint32_t>::const_iterator c = std::find (walk.begin (), walk.end (), n);
+                 c != walk.end (); ++c)
+              {
+                cycle << *c << " -> ";
+              }
+            cycle << n;
+            Report (m_violations.m_loops, where, "loop", n, d, distance[n], cycle.str ());
+          }
+        for (std::vector<uint32_t>::const_iterator w = walk.begin (); w != walk.end (); ++w)
+          {
+            mark[*w] = 2;
+          }
+      }
+  }
+  /**
+   * Count a violation and print the first ones
+   * \param counter the counter of the invariant
+   * \param where the trial and step
+   * \param what the invariant
+   * \param node the node index
+   * \param dst the destination index
+   * \param distance the shortest path length
+   * \param got the route found
+   */
+  void Report (uint64_t & counter, std::string const & where, char const * what, uint32_t node, uint32_t dst,
+               uint32_t distance, std::string const & got)
+  {
+    if (counter < m_maxReports)
+      {
+        std::cerr << where << ": " << what << " at node " << node << " to " << dst << ": ";
+        if (distance == UNREACHABLE)
+          {
+            std::cerr << "unreachable";
+          }
+        else
+          {
+            std::cerr << "shortest path " << distance;
+          }
+        std::cerr << ", got " << got << std::endl;
+      }
+    counter++;
+  }
+
+  uint32_t m_threshold;      ///< hop threshold
+  uint32_t m_maxReports;     ///< violations of each invariant printed in full
+  uint64_t m_checks;         ///< pairs checked
+  Violations m_violations;   ///< violations found
+};
+
+}  // unnamed namespace
+
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t trials = 100;
+  uint32_t firstTrial = 0;
+  uint32_t minNodes = 5;
+  uint32_t maxNodes = 40;
+  std::string topology = "mixed";
+  double density = 4;
+  uint32_t steps = 50;
+  uint32_t maxBatch = 3;
+  uint32_t threshold = bsdvr::constants::BSDVR_THRESHOLD;
+  uint64_t maxEvents = 1000000;
+  uint32_t run = 1;
+  uint32_t maxReports = 5;
+  bool stopOnViolation = false;
+  std::string record = "";
+  std::string output = "";
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("trials", "Number of random topologies", trials);
+  cmd.AddValue ("firstTrial", "Index of the first trial, the random stream it uses", firstTrial);
+  cmd.AddValue ("minNodes", "Smallest number of nodes of a trial", minNodes);
+  cmd.AddValue ("maxNodes", "Largest number of nodes of a trial", maxNodes);
+  cmd.AddValue ("topology", "Topology of the trials: disc, random or mixed", topology);
+  cmd.AddValue ("density", "Mean number of neighbors", density);
+  cmd.AddValue ("steps", "Steps of a trial, each followed by a convergence check", steps);
+  cmd.AddValue ("maxBatch", "Largest number of actions applied at once in a step", maxBatch);
+  cmd.AddValue ("threshold", "Hop threshold", threshold);
+  cmd.AddValue ("maxEvents", "Events of a trial after which a step is counted as not converging", maxEvents);
+  cmd.AddValue ("run", "Random number generator run", run);
+  cmd.AddValue ("maxReports", "Number of violations of each invariant printed in full", maxReports);
+  cmd.AddValue ("stopOnViolation", "Stop after the first trial with a violation", stopOnViolation);
+  cmd.AddValue ("record", "Trace file the events of a single trial are written to", record);
+  cmd.AddValue ("output", "CSV file the row is appended to, standard output if empty", output);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (minNodes < 2 || minNodes > maxNodes, "Expected 2 <= minNodes <= maxNodes");
+  NS_ABORT_MSG_IF (maxNodes > 65000, "10.0.0.0/16 holds at most 65000 nodes");
+  NS_ABORT_MSG_IF (maxBatch == 0, "maxBatch must be positive");
+  NS_ABORT_MSG_IF (!record.empty () && trials != 1, "A trace is recorded for a single trial");
+
+  RngSeedManager::SetRun (run);
+  Checker checker (threshold, maxReports);
+  uint64_t actions = 0;
+  uint64_t events = 0;
+  uint64_t messages = 0;
+  uint64_t pendingReplies = 0;
+  Statistics stats;
+  double wall = 0;
+  uint32_t trial = firstTrial;
+  for (; trial < firstTrial + trials; trial++)
+    {
+      Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+      rng->SetStream (trial);
+      uint32_t size = rng->GetInteger (minNodes, maxNodes);
+      std::string shape = topology;
+      if (shape == "mixed")
+        {
+          shape = (rng->GetValue () < 0.5) ? "disc" : "random";
+        }
+      BsdvrEngineNetwork network (size, threshold);
+      Build (network, shape, density, rng);
+      NS_ABORT_MSG_UNLESS (network.Record (record), "Cannot write " << record);
+      uint64_t before = checker.GetViolations ().GetTotal ();
+      network.Start ();
+      for (uint32_t step = 0; step <= steps; step++)
+        {
+          if (step > 0)
+            {
+              for (uint32_t b = rng->GetInteger (1, maxBatch); b > 0; b--)
+                {
+                  actions += Act (network, rng);
+                }
+            }
+          std::ostringstream where;
+          where << "run " << run << " trial " << trial << " (" << shape << ", " << size << " nodes) step " << step;
+          std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+          bool quiet = network.Run (maxEvents);
+          wall += std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+          if (!quiet)
+            {
+              checker.NotConverged (where.str (), maxEvents);
+              break;
+            }
+          checker.Check (network, where.str ());
+        }
+      events += network.GetEvents ();
+      messages += network.GetMessages ();
+      pendingReplies += network.GetPendingReplies ();
+      stats += network.GetStatistics ();
+      if (stopOnViolation && checker.GetViolations ().GetTotal () > before)
+        {
+          trial++;
+          break;
+        }
+    }
+
+  Violations const & v = checker.GetViolations ();
+  std::cerr << (trial - firstTrial) << " trials, " << checker.GetChecks () << " routes checked, "
+            << v.GetTotal () << " violations" << std::endl;
+
+  std::ofstream file;
+  std::ostream & os = OpenCsvOutput (output,
+                                     "topology,min_nodes,max_nodes,density,threshold,run,first_trial,trials,steps,actions,checks,"
+                                     "events,messages,pending_replies,pending_reply_timeouts,ft_computations,destinations_evaluated,ft_changes,"
+                                     "loops,missing,inactive,hops,stale,not_converged,wall_s,events_per_s,ns_per_event", file);
+  os << topology << "," << minNodes << "," << maxNodes << "," << density << "," << threshold << "," << run << ","
+     << firstTrial << "," << (trial - firstTrial) << "," << steps << "," << actions << "," << checker.GetChecks () << ","
+     << events << "," << messages << "," << pendingReplies << "," << stats.m_pendingReplyExpirations << ","
+     << stats.m_ftComputations << "," << stats.m_destinationsEvaluated << "," << stats.m_ftChanges << ","
+     << v.m_loops << "," << v.m_missing << "," << v.m_inactive << "," << v.m_hops << "," << v.m_stale << "," << v.m_nonConverged << "," << wall << ","
+     << (wall > 0 ? events / wall : 0) << "," << (events ? wall * 1e9 / events : 0) << std::endl;
+  return v.GetTotal () ? 1 : 0;
+}
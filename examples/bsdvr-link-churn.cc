@@ -0,0 +1,485 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Link churn benchmark: BSDVR on a static WiFi grid whose links are broken
+ * and restored at a controlled rate.
+ *
+ * Every grid link has a fixed loss in a MatrixPropagationLossModel; a break
+ * raises it so that no frame gets through until the restoration --downTime
+ * seconds later. Broken unicast frames are dropped by the MAC after their
+ * retries, which drives ProcessTxError, and the silenced HELLOs expire the
+ * neighbor, which drives SendUpdateOnLinkFailure and the pending reply
+ * machinery.
+ *
+ * After --warmup seconds of convergence, the run has two phases of --phase
+ * seconds each: a quiet baseline, then the churn phase in which breaks arrive
+ * as a Poisson process of --rate per second. Costs of the churn phase are
+ * reported net of the baseline, per link event (break or restoration):
+ *  - process CPU time, i.e. the control plane and the frames it sends,
+ *  - UPDATE messages and control bytes,
+ * together with the recovery time of the CBR flows, measured as the receive
+ * gaps longer than --outageGap, and the sampled deferred queue and pending
+ * reply queue occupancies. The row is written as CSV, appended to --output
+ * if given.
+ *
+ *   ./waf --run "bsdvr-link-churn --rows=8 --cols=8 --rate=0.5 --downTime=5"
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include "ns3/bsdvr-module.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/propagation-module.h"
+#include "ns3/applications-module.h"
+#include "bsdvr-example-common.h"
+#include "bsdvr-example-scenario.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("BsdvrLinkChurn");
+
+/**
+ * \brief Link churn experiment
+ */
+class LinkChurnExperiment
+{
+public:
+  LinkChurnExperiment ();
+  /**
+   * Read the parameters
+   * \param argc the argument count
+   * \param argv the arguments
+   */
+  void Configure (int argc, char *argv[]);
+  /// Build the network, run and write the CSV row
+  void Run ();
+
+private:
+  /// A grid link
+  struct Link
+  {
+    Ptr<MobilityModel> m_a;   ///< one end
+    Ptr<MobilityModel> m_b;   ///< other end
+    bool m_up;                ///< whether the link is up
+  };
+  /// Counters sampled at the phase boundaries
+  struct Sample
+  {
+    double m_cpu;             ///< process CPU seconds
+    uint64_t m_updates;       ///< UPDATE messages sent
+    uint64_t m_controlBytes;  ///< control bytes sent
+    bsdvr::Statistics m_stats; ///< summed routing statistics
+  };
+
+  /// Place the nodes on the grid and set up the radio
+  void CreateNetwork ();
+  /// Start the CBR flows
+  void CreateFlows ();
+  /**
+   * Take a phase boundary sample
+   * \param sample the sample to fill
+   */
+  void TakeSample (Sample * sample);
+  /// Break a random up link and schedule the next break
+  void Break ();
+  /**
+   * Restore a link
+   * \param index the link index
+   */
+  void Restore (uint32_t index);
+  /// Sample the queue occupancies and reschedule
+  void SampleQueues ();
+  /**
+   * Tx trace sink
+   * \param type the message type
+   * \param peer the neighbor, or broadcast, address
+   * \param dst the advertised destination
+   * \param hop the advertised hop count
+   * \param state the advertised binary state
+   * \param bytes the message size
+   */
+  void ControlTx (uint8_t type, Ipv4Address peer, Ipv4Address dst, uint32_t hop, uint32_t state, uint32_t bytes);
+  /**
+   * PacketSink Rx trace sink
+   * \param context the flow index
+   * \param packet the packet
+   * \param from the sender
+   */
+  void FlowRx (std::string context, Ptr<const Packet> packet, Address const & from);
+  /**
+   * Account a receive gap of a flow
+   * \param start the last reception before the gap
+   * \param gap the gap length
+   */
+  void AccountGap (Time start, Time gap);
+  /**
+   * Write the CSV row
+   * \param os the output stream
+   * \param wall the wall-clock seconds of the run
+   */
+  void Report (std::ostream & os, double wall) const;
+
+  uint32_t m_rows;             ///< grid rows
+  uint32_t m_cols;             ///< grid columns
+  double m_spacing;            ///< grid spacing, in meters
+  double m_rate;               ///< link breaks per second in the churn phase
+  double m_downTime;           ///< seconds a broken link stays down
+  double m_warmup;             ///< seconds before the baseline phase
+  double m_phase;              ///< seconds of each phase
+  double m_settle;             ///< seconds run after the churn phase
+  uint32_t m_flowCount;        ///< CBR flows
+  double m_packetRate;         ///< packets per second of each flow
+  uint32_t m_packetSize;       ///< bytes per packet
+  double m_outageGap;          ///< receive gap counted as an outage, in seconds
+  double m_sampleInterval;     ///< queue sampling interval, in seconds
+  uint32_t m_run;              ///< random number generator run
+  std::string m_output;        ///< CSV file
+
+  NodeContainer m_nodes;                                  ///< grid nodes
+  Ipv4InterfaceContainer m_interfaces;                    ///< node addresses
+  BsdvrHelper m_bsdvr;                                    ///< routing helper
+  std::vector<Ptr<bsdvr::RoutingProtocol> > m_protocols;  ///< BSDVR instances
+  Ptr<MatrixPropagationLossModel> m_loss;                 ///< per link loss
+  std::vector<Link> m_links;                              ///< grid links
+  Ptr<UniformRandomVariable> m_pick;                      ///< link and flow picker
+  Ptr<ExponentialRandomVariable> m_arrival;               ///< break inter-arrival times
+
+  uint64_t m_updates;          ///< UPDATE messages sent
+  uint64_t m_controlBytes;     ///< control bytes sent
+  uint32_t m_breaks;           ///< links broken in the churn phase
+  uint32_t m_restores;         ///< links restored in the churn phase
+  std::vector<Time> m_lastRx;  ///< last reception of each flow
+  uint32_t m_outages;          ///< receive gaps starting in the churn phase
+  uint32_t m_baselineOutages;  ///< receive gaps starting in the baseline phase
+  Time m_outageTotal;          ///< summed churn phase gaps
+  Time m_outageMax;            ///< longest churn phase gap
+  uint64_t m_queueSamples;     ///< queue samples taken
+  uint64_t m_queueTotal;       ///< summed deferred queue occupancy
+  uint32_t m_queueMax;         ///< largest deferred queue occupancy
+  uint64_t m_prQueueTotal;     ///< summed pending reply queue occupancy
+  uint32_t m_prQueueMax;       ///< largest pending reply queue occupancy
+  Sample m_samples[3];         ///< baseline start, churn start, churn end
+};
+
+LinkChurnExperiment::LinkChurnExperiment ()
+  : m_rows (6),
+    m_cols (6),
+    m_spacing (100),
+    m_rate (0.5),
+    m_downTime (5),
+    m_warmup (30),
+    m_phase (60),
+    m_settle (10),
+    m_flowCount (10),
+    m_packetRate (4),
+    m_packetSize (64),
+    m_outageGap (1),
+    m_sampleInterval (0.1),
+    m_run (1),
+    m_output (""),
+    m_updates (0),
+    m_controlBytes (0),
+    m_breaks (0),
+    m_restores (0),
+    m_outages (0),
+    m_baselineOutages (0),
+    m_queueSamples (0),
+    m_queueTotal (0),
+    m_queueMax (0),
+    m_prQueueTotal (0),
+    m_prQueueMax (0)
+{
+}
+
+void
+LinkChurnExperiment::Configure (int argc, char *argv[])
+{
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("rows", "Grid rows", m_rows);
+  cmd.AddValue ("cols", "Grid columns", m_cols);
+  cmd.AddValue ("rate", "Link breaks per second in the churn phase", m_rate);
+  cmd.AddValue ("downTime", "Seconds a broken link stays down", m_downTime);
+  cmd.AddValue ("warmup", "Seconds of initial convergence", m_warmup);
+  cmd.AddValue ("phase", "Seconds of the baseline and of the churn phase", m_phase);
+  cmd.AddValue ("settle", "Seconds run after the churn phase", m_settle);
+  cmd.AddValue ("flows", "Number of CBR flows between random node pairs", m_flowCount);
+  cmd.AddValue ("packetRate", "Packets per second of each flow", m_packetRate);
+  cmd.AddValue ("packetSize", "Bytes per packet", m_packetSize);
+  cmd.AddValue ("outageGap", "Receive gap of a flow counted as an outage, in seconds", m_outageGap);
+  cmd.AddValue ("sampleInterval", "Queue occupancy sampling interval, in seconds", m_sampleInterval);
+  cmd.AddValue ("run", "Random number generator run", m_run);
+  cmd.AddValue ("output", "CSV file the row is appended to, standard output if empty", m_output);
+  cmd.Parse (argc, argv);
+  NS_ABORT_MSG_IF (m_rows * m_cols < 2, "The grid needs at least two nodes");
+  NS_ABORT_MSG_IF (m_rate <= 0, "rate must be positive");
+  NS_ABORT_MSG_IF (m_outageGap <= 1 / m_packetRate, "outageGap must exceed the packet interval");
+}
+
+void
+LinkChurnExperiment::CreateNetwork ()
+{
+  m_nodes.Create (m_rows * m_cols);
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (m_spacing),
+                                 "DeltaY", DoubleValue (m_spacing),
+                                 "GridWidth", UintegerValue (m_cols),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.Install (m_nodes);
+
+  // Only grid neighbors hear each other
+  m_loss = CreateObject<MatrixPropagationLossModel> ();
+  m_loss->SetDefaultLoss (200);
+  for (uint32_t r = 0; r < m_rows; r++)
+    {
+      for (uint32_t c = 0; c < m_cols; c++)
+        {
+          Ptr<MobilityModel> a = m_nodes.Get (r * m_cols + c)->GetObject<MobilityModel> ();
+          if (c + 1 < m_cols)
+            {
+              Link link = { a, m_nodes.Get (r * m_cols + c + 1)->GetObject<MobilityModel> (), true };
+              m_links.push_back (link);
+            }
+          if (r + 1 < m_rows)
+            {
+              Link link = { a, m_nodes.Get ((r + 1) * m_cols + c)->GetObject<MobilityModel> (), true };
+              m_links.push_back (link);
+            }
+        }
+    }
+  for (std::vector<Link>::const_iterator l = m_links.begin (); l != m_links.end (); ++l)
+    {
+      m_loss->SetLoss (l->m_a, l->m_b, 50);
+    }
+  Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  channel->SetPropagationLossModel (m_loss);
+  NetDeviceContainer devices = InstallAdhocWifi (m_nodes, channel);
+
+  InternetStackHelper stack;
+  stack.SetRoutingHelper (m_bsdvr);
+  stack.Install (m_nodes);
+  m_interfaces = AssignAddresses (devices);
+  m_bsdvr.AssignStreams (m_nodes, 0);
+
+  for (NodeContainer::Iterator i = m_nodes.Begin (); i != m_nodes.End (); ++i)
+    {
+      Ptr<bsdvr::RoutingProtocol> protocol = BsdvrHelper::GetRoutingProtocol (*i);
+      protocol->TraceConnectWithoutContext ("Tx", MakeCallback (&LinkChurnExperiment::ControlTx, this));
+      m_protocols.push_back (protocol);
+    }
+}
+
+void
+LinkChurnExperiment::CreateFlows ()
+{
+  uint16_t port = 9;
+  Time start = Seconds (m_warmup);
+  Time stop = Seconds (m_warmup + 2 * m_phase + m_settle);
+  m_lastRx.assign (m_flowCount, start);
+  ApplicationContainer sinks = InstallCbrFlows (m_nodes, m_interfaces, m_flowCount, port, m_packetRate, m_packetSize,
+                                                start, stop, m_pick);
+  for (uint32_t f = 0; f < m_flowCount; f++)
+    {
+      std::ostringstream context;
+      context << f;
+      sinks.Get (f)->TraceConnect ("Rx", context.str (), MakeCallback (&LinkChurnExperiment::FlowRx, this));
+    }
+}
+
+void
+LinkChurnExperiment::TakeSample (Sample * sample)
+{
+  sample->m_cpu = GetCpuSeconds ();
+  sample->m_updates = m_updates;
+  sample->m_controlBytes = m_controlBytes;
+  sample->m_stats = m_bsdvr.GetStatistics (m_nodes);
+}
+
+void
+LinkChurnExperiment::Break ()
+{
+  Time churnEnd = Seconds (m_warmup + 2 * m_phase);
+  Time next = Seconds (m_arrival->GetValue ());
+  // Only breaks whose restoration also falls in the churn phase
+  if (Simulator::Now () + Seconds (m_downTime) <= churnEnd)
+    {
+      std::vector<uint32_t> up;
+      for (uint32_t l = 0; l < m_links.size (); l++)
+        {
+          if (m_links[l].m_up)
+            {
+              up.push_back (l);
+            }
+        }
+      if (!up.empty ())
+        {
+          uint32_t index = up[m_pick->GetInteger (0, up.size () - 1)];
+          m_links[index].m_up = false;
+          m_loss->SetLoss (m_links[index].m_a, m_links[index].m_b, 200);
+          m_breaks++;
+          NS_LOG_INFO ("Link " << index << " down");
+          Simulator::Schedule (Seconds (m_downTime), &LinkChurnExperiment::Restore, this, index);
+        }
+    }
+  if (Simulator::Now () + next + Seconds (m_downTime) <= churnEnd)
+    {
+      Simulator::Schedule (next, &LinkChurnExperiment::Break, this);
+    }
+}
+
+void
+LinkChurnExperiment::Restore (uint32_t index)
+{
+  m_links[index].m_up = true;
+  m_loss->SetLoss (m_links[index].m_a, m_links[index].m_b, 50);
+  m_restores++;
+  NS_LOG_INFO ("Link " << index << " up");
+}
+
+void
+LinkChurnExperiment::SampleQueues ()
+{
+  uint32_t queue = 0;
+  uint32_t prQueue = 0;
+  for (std::vector<Ptr<bsdvr::RoutingProtocol> >::const_iterator p = m_protocols.begin (); p != m_protocols.end (); ++p)
+    {
+      queue += (*p)->GetQueueSize ();
+      prQueue += (*p)->GetPendingReplyQueueSize ();
+    }
+  m_queueSamples++;
+  m_queueTotal += queue;
+  m_queueMax = std::max (m_queueMax, queue);
+  m_prQueueTotal += prQueue;
+  m_prQueueMax = std::max (m_prQueueMax, prQueue);
+  if (Simulator::Now () + Seconds (m_sampleInterval) <= Seconds (m_warmup + 2 * m_phase))
+    {
+      Simulator::Schedule (Seconds (m_sampleInterval), &LinkChurnExperiment::SampleQueues, this);
+    }
+}
+
+void
+LinkChurnExperiment::ControlTx (uint8_t type, Ipv4Address peer, Ipv4Address dst, uint32_t hop, uint32_t state, uint32_t bytes)
+{
+  if (type == bsdvr::BSDVRTYPE_UPDATE)
+    {
+      m_updates++;
+    }
+  m_controlBytes += bytes;
+}
+
+void
+LinkChurnExperiment::FlowRx (std::string context, Ptr<const Packet> packet, Address const & from)
+{
+  uint32_t flow = std::strtoul (context.c_str (), 0, 10);
+  Time gap = Simulator::Now () - m_lastRx[flow];
+  if (gap > Seconds (m_outageGap))
+    {
+      AccountGap (m_lastRx[flow], gap);
+    }
+  m_lastRx[flow] = Simulator::Now ();
+}
+
+void
+LinkChurnExperiment::AccountGap (Time start, Time gap)
+{
+  Time churnStart = Seconds (m_warmup + m_phase);
+  if (start < churnStart)
+    {
+      m_baselineOutages++;
+      return;
+    }
+  if (start < Seconds (m_warmup + 2 * m_phase))
+    {
+      m_outages++;
+      m_outageTotal += gap;
+      m_outageMax = Max (m_outageMax, gap);
+    }
+}
+
+void
+LinkChurnExperiment::Report (std::ostream & os, double wall) const
+{
+  Sample const & base = m_samples[0];
+  Sample const & churn = m_samples[1];
+  Sample const & end = m_samples[2];
+  uint32_t events = m_breaks + m_restores;
+  double perEvent = events ? 1.0 / events : 0;
+  // Baseline and churn phases are equally long, so the baseline is subtracted as is
+  double baselineCpu = churn.m_cpu - base.m_cpu;
+  double churnCpu = end.m_cpu - churn.m_cpu;
+  uint64_t baselineUpdates = churn.m_updates - base.m_updates;
+  uint64_t churnUpdates = end.m_updates - churn.m_updates;
+  double extraBytes = double (end.m_controlBytes - churn.m_controlBytes) - double (churn.m_controlBytes - base.m_controlBytes);
+  // Flows still silent when the run stops never recovered
+  uint32_t unrecovered = 0;
+  for (std::vector<Time>::const_iterator t = m_lastRx.begin (); t != m_lastRx.end (); ++t)
+    {
+      if (Simulator::Now () - *t > Seconds (m_outageGap))
+        {
+          unrecovered++;
+        }
+    }
+  os << m_rows << "," << m_cols << "," << m_rate << "," << m_downTime << "," << m_run << ","
+     << events << "," << m_breaks << ","
+     << end.m_stats.m_linkFailures - churn.m_stats.m_linkFailures << ","
+     << end.m_stats.m_pendingReplyEnqueues - churn.m_stats.m_pendingReplyEnqueues << ","
+     << baselineCpu << "," << churnCpu << "," << (churnCpu - baselineCpu) * 1e6 * perEvent << ","
+     << baselineUpdates << "," << churnUpdates << ","
+     << (double (churnUpdates) - double (baselineUpdates)) * perEvent << ","
+     << extraBytes * perEvent << "," << m_baselineOutages << "," << m_outages << ","
+     << (m_outages ? m_outageTotal.GetSeconds () / m_outages : 0) << "," << m_outageMax.GetSeconds () << ","
+     << unrecovered << ","
+     << (m_queueSamples ? double (m_queueTotal) / m_queueSamples : 0) << "," << m_queueMax << ","
+     << (m_queueSamples ? double (m_prQueueTotal) / m_queueSamples : 0) << "," << m_prQueueMax << ","
+     << wall << std::endl;
+}
+
+void
+LinkChurnExperiment::Run ()
+{
+  RngSeedManager::SetRun (m_run);
+  m_pick = CreateObject<UniformRandomVariable> ();
+  m_arrival = CreateObject<ExponentialRandomVariable> ();
+  m_arrival->SetAttribute ("Mean", DoubleValue (1 / m_rate));
+  CreateNetwork ();
+  CreateFlows ();
+
+  Time churnStart = Seconds (m_warmup + m_phase);
+  Simulator::Schedule (Seconds (m_warmup), &LinkChurnExperiment::TakeSample, this, &m_samples[0]);
+  Simulator::Schedule (churnStart, &LinkChurnExperiment::TakeSample, this, &m_samples[1]);
+  Simulator::Schedule (Seconds (m_warmup + 2 * m_phase), &LinkChurnExperiment::TakeSample, this, &m_samples[2]);
+  Simulator::Schedule (churnStart, &LinkChurnExperiment::SampleQueues, this);
+  Simulator::Schedule (churnStart + Seconds (m_arrival->GetValue ()), &LinkChurnExperiment::Break, this);
+  Simulator::Stop (Seconds (m_warmup + 2 * m_phase + m_settle));
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  Simulator::Run ();
+  double wall = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+  std::ofstream file;
+  std::ostream & os = OpenCsvOutput (m_output,
+                                     "rows,cols,rate,down_time,run,events,breaks,link_failures,pr_enqueues,"
+                                     "baseline_cpu_s,churn_cpu_s,cpu_per_event_us,baseline_updates,churn_updates,updates_per_event,"
+                                     "control_bytes_per_event,baseline_outages,outages,recovery_mean_s,recovery_max_s,unrecovered,"
+                                     "queue_mean,queue_max,pr_queue_mean,pr_queue_max,wall_s", file);
+  Report (os, wall);
+  Simulator::Destroy ();
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  LinkChurnExperiment experiment;
+  experiment.Configure (argc, argv);
+  experiment.Run ();
+  return 0;
+}
@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Mobility benchmark: BSDVR on N RandomWaypoint nodes carrying CBR/UDP
+ * flows between random node pairs.
+ *
+ * Nodes move in a --width x --height rectangle at speeds drawn uniformly from
+ * [--minSpeed, --maxSpeed] with --pause seconds of pause at every waypoint.
+ * The radio is a unit disk of --range meters, as in bsdvr-scaling. Flows
+ * start after --warmup seconds and run until --duration; FlowMonitor measures
+ * them. The CSV row holds the packet delivery ratio, the mean end-to-end
+ * delay of delivered packets, the routing overhead in control bytes per
+ * delivered data byte, and the wall-clock time of the run, appended to
+ * --output if given. All random variables are seeded through --run and
+ * AssignStreams, so a run is reproducible.
+ *
+ *   ./waf --run "bsdvr-mobility --nodes=50 --pause=0 --maxSpeed=20 --output=mobility.csv"
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include "ns3/bsdvr-module.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/flow-monitor-module.h"
+#include "bsdvr-example-common.h"
+#include "bsdvr-example-scenario.h"
+
+using namespace ns3;
+
+/// Bytes of the control messages sent by all nodes
+static uint64_t g_controlBytes = 0;
+/// Control messages sent by all nodes
+static uint64_t g_controlPackets = 0;
+
+/// Tx trace sink counting the control messages of all nodes
+static void
+ControlTx (uint8_t type, Ipv4Address peer, Ipv4Address dst, uint32_t hop, uint32_t state, uint32_t bytes)
+{
+  g_controlPackets++;
+  g_controlBytes += bytes;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t size = 50;
+  double width = 1500;
+  double height = 300;
+  double minSpeed = 1;
+  double maxSpeed = 20;
+  double pause = 0;
+  double range = 250;
+  uint32_t flowCount = 10;
+  double packetRate = 4;
+  uint32_t packetSize = 512;
+  double warmup = 30;
+  double duration = 200;
+  uint32_t run = 1;
+  std::string output = "";
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("nodes", "Number of nodes", size);
+  cmd.AddValue ("width", "Width of the area, in meters", width);
+  cmd.AddValue ("height", "Height of the area, in meters", height);
+  cmd.AddValue ("minSpeed", "Lowest node speed, in m/s", minSpeed);
+  cmd.AddValue ("maxSpeed", "Highest node speed, in m/s", maxSpeed);
+  cmd.AddValue ("pause", "Pause at every waypoint, in seconds", pause);
+  cmd.AddValue ("range", "Radio range, in meters", range);
+  cmd.AddValue ("flows", "Number of CBR flows between random node pairs", flowCount);
+  cmd.AddValue ("packetRate", "Packets per second of each flow", packetRate);
+  cmd.AddValue ("packetSize", "Bytes per packet", packetSize);
+  cmd.AddValue ("warmup", "Seconds before the flows start", warmup);
+  cmd.AddValue ("duration", "Simulated seconds", duration);
+  cmd.AddValue ("run", "Random number generator run", run);
+  cmd.AddValue ("output", "CSV file the row is appended to, standard output if empty", output);
+  cmd.Parse (argc, argv);
+  NS_ABORT_MSG_IF (size < 2, "At least two nodes are needed");
+  NS_ABORT_MSG_IF (minSpeed <= 0 || maxSpeed < minSpeed, "Speeds must satisfy 0 < minSpeed <= maxSpeed");
+  NS_ABORT_MSG_IF (duration <= warmup, "duration must exceed warmup");
+
+  RngSeedManager::SetRun (run);
+
+  NodeContainer nodes;
+  nodes.Create (size);
+
+  MobilityHelper mobility;
+  ObjectFactory positions;
+  positions.SetTypeId ("ns3::RandomRectanglePositionAllocator");
+  std::ostringstream x, y, speed, pauseTime;
+  x << "ns3::UniformRandomVariable[Min=0.0|Max=" << width << "]";
+  y << "ns3::UniformRandomVariable[Min=0.0|Max=" << height << "]";
+  speed << "ns3::UniformRandomVariable[Min=" << minSpeed << "|Max=" << maxSpeed << "]";
+  pauseTime << "ns3::ConstantRandomVariable[Constant=" << pause << "]";
+  positions.Set ("X", StringValue (x.str ()));
+  positions.Set ("Y", StringValue (y.str ()));
+  Ptr<PositionAllocator> waypoints = positions.Create ()->GetObject<PositionAllocator> ();
+  int64_t stream = waypoints->AssignStreams (0);
+  mobility.SetMobilityModel ("ns3::RandomWaypointMobilityModel",
+                             "Speed", StringValue (speed.str ()),
+                             "Pause", StringValue (pauseTime.str ()),
+                             "PositionAllocator", PointerValue (waypoints));
+  mobility.SetPositionAllocator (waypoints);
+  mobility.Install (nodes);
+  stream += MobilityHelper::AssignStreams (nodes, stream);
+
+  NetDeviceContainer devices = InstallUnitDiskWifi (nodes, range);
+  stream += WifiHelper ().AssignStreams (devices, stream);
+
+  BsdvrHelper bsdvr;
+  InternetStackHelper internet;
+  internet.SetRoutingHelper (bsdvr);
+  internet.Install (nodes);
+  Ipv4InterfaceContainer interfaces = AssignAddresses (devices);
+  stream += bsdvr.AssignStreams (nodes, stream);
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      BsdvrHelper::GetRoutingProtocol (*i)->TraceConnectWithoutContext ("Tx", MakeCallback (&ControlTx));
+    }
+
+  uint16_t port = 9;
+  Ptr<UniformRandomVariable> pick = CreateObject<UniformRandomVariable> ();
+  pick->SetStream (stream++);
+  InstallCbrFlows (nodes, interfaces, flowCount, port, packetRate, packetSize, Seconds (warmup), Seconds (duration), pick);
+
+  FlowMonitorHelper flowHelper;
+  Ptr<FlowMonitor> monitor = flowHelper.InstallAll ();
+
+  Simulator::Stop (Seconds (duration));
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  Simulator::Run ();
+  double wall = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+  CbrFlowTotals flows = GetCbrFlowTotals (flowHelper, monitor, port, flowCount);
+  bsdvr::Statistics stats = bsdvr.GetStatistics (nodes);
+
+  std::ofstream file;
+  std::ostream & os = OpenCsvOutput (output,
+                                     "nodes,width,height,min_speed,max_speed,pause,flows,run,tx_packets,rx_packets,pdr,delay_ms,"
+                                     "control_packets,control_bytes,overhead_bytes_per_data_byte,updates_sent,link_failures,"
+                                     "queue_drops,sim_time_s,wall_s", file);
+  os << size << "," << width << "," << height << "," << minSpeed << "," << maxSpeed << "," << pause << ","
+     << flowCount << "," << run << "," << flows.m_txPackets << "," << flows.m_rxPackets << ","
+     << (flows.m_txPackets ? double (flows.m_rxPackets) / flows.m_txPackets : 0) << ","
+     << (flows.m_rxPackets ? flows.m_delay.GetSeconds () * 1000 / flows.m_rxPackets : 0) << ","
+     << g_controlPackets << "," << g_controlBytes << ","
+     << (flows.m_rxBytes ? double (g_controlBytes) / flows.m_rxBytes : 0) << ","
+     << stats.m_updatesSent << "," << stats.m_linkFailures << "," << stats.m_queueDrops << ","
+     << duration << "," << wall << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
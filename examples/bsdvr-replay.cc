@@ -0,0 +1,297 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Control plane replay: drives bsdvr::Engine instances with a trace of
+ * events, without sockets, WiFi or the simulator, to profile and benchmark
+ * the control plane on its own.
+ *
+ * Without --trace the events are generated in closed loop by a
+ * BsdvrEngineNetwork over a grid, line or disc topology: every node hears its
+ * neighbors, the UPDATEs each engine asks for are delivered to the neighbor
+ * engines, pending reply timers fire when the network is quiet, and --churn
+ * random links then fail and come back. With --record the events are
+ * written to a trace file as they are processed. With --trace a recorded
+ * file is replayed open loop, --repeat times on fresh engines, and only the
+ * engine work is timed: the trace already holds the UPDATEs that the outputs
+ * caused.
+ *
+ *   ./waf --run "bsdvr-replay --nodes=400 --topology=disc --churn=200 --record=disc.trace"
+ *   ./waf --run "bsdvr-replay --trace=disc.trace --repeat=5 --output=replay.csv"
+ *
+ * A trace is a text file with one event per line, node addresses in
+ * 10.0.0.0/16 (node i is 10.0.0.0 + i + 1):
+ *
+ *   # bsdvr-replay nodes <N> threshold <T>
+ *   U <node> <neighbor>                       HELLO heard from the neighbor
+ *   D <node> <neighbor>                       link to the neighbor failed
+ *   R <node> <from> <dst> <hop> <state>       UPDATE received, as carried
+ *   T <node> <neighbor> <dst>                 pending reply timer fired
+ *
+ * Both modes print the same CSV row, whose checksum of the final forwarding
+ * tables lets a replay be checked against the run that recorded it. Build
+ * with --build-profile=optimized for meaningful numbers.
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include "ns3/bsdvr-module.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "bsdvr-example-common.h"
+
+using namespace ns3;
+using namespace ns3::bsdvr;
+
+namespace {
+
+/// A trace event
+typedef BsdvrEngineNetwork::Event Event;
+
+/**
+ * Link the nodes of a network
+ * \param network the network
+ * \param topology grid, line or disc
+ * \param density the mean number of neighbors in a disc
+ * \param rng the random variable placing the nodes
+ */
+void
+Build (BsdvrEngineNetwork & network, std::string const & topology, double density, Ptr<UniformRandomVariable> rng)
+{
+  uint32_t size = network.GetSize ();
+  if (topology == "grid")
+    {
+      uint32_t width = std::ceil (std::sqrt (size));
+      for (uint32_t i = 0; i < size; i++)
+        {
+          if ((i + 1) % width != 0 && i + 1 < size)
+            {
+              network.AddLink (i, i + 1);
+            }
+          if (i + width < size)
+            {
+              network.AddLink (i, i + width);
+            }
+        }
+    }
+  else if (topology == "line")
+    {
+      for (uint32_t i = 0; i + 1 < size; i++)
+        {
+          network.AddLink (i, i + 1);
+        }
+    }
+  else if (topology == "disc")
+    {
+      // Unit range: N / radius^2 neighbors on average, ignoring the border
+      double radius = std::sqrt (size / density);
+      std::vector<double> x (size);
+      std::vector<double> y (size);
+      for (uint32_t i = 0; i < size; i++)
+        {
+          double rho = radius * std::sqrt (rng->GetValue ());
+          double theta = rng->GetValue (0, 2 * M_PI);
+          x[i] = rho * std::cos (theta);
+          y[i] = rho * std::sin (theta);
+        }
+      for (uint32_t i = 0; i < size; i++)
+        {
+          for (uint32_t j = i + 1; j < size; j++)
+            {
+              if ((x[i] - x[j]) * (x[i] - x[j]) + (y[i] - y[j]) * (y[i] - y[j]) <= 1)
+                {
+                  network.AddLink (i, j);
+                }
+            }
+        }
+    }
+  else
+    {
+      NS_FATAL_ERROR ("Unknown topology " << topology << ", expected grid, line or disc");
+    }
+}
+
+/**
+ * Bring all links up, then fail and restore random links
+ * \param network the network
+ * \param churn the number of link failures
+ * \param maxEvents the number of events after which the run is aborted
+ * \param rng the random variable picking the links
+ */
+void
+Generate (BsdvrEngineNetwork & network, uint32_t churn, uint64_t maxEvents, Ptr<UniformRandomVariable> rng)
+{
+  network.Start ();
+  NS_ABORT_MSG_UNLESS (network.Run (maxEvents), "No convergence after " << maxEvents << " events");
+  for (uint32_t c = 0; c < churn; c++)
+    {
+      uint32_t a = rng->GetInteger (0, network.GetSize () - 1);
+      std::vector<uint32_t> const & links = network.GetLinks (a);
+      if (links.empty ())
+        {
+          continue;
+        }
+      uint32_t b = links[rng->GetInteger (0, links.size () - 1)];
+      network.FailLink (a, b);
+      NS_ABORT_MSG_UNLESS (network.Run (maxEvents), "No convergence after " << maxEvents << " events");
+      network.RestoreLink (a, b);
+      NS_ABORT_MSG_UNLESS (network.Run (maxEvents), "No convergence after " << maxEvents << " events");
+    }
+}
+
+/**
+ * Read a trace
+ * \param file the file name
+ * \param size set to the number of nodes
+ * \param threshold set to the hop threshold
+ * \returns the events
+ */
+std::vector<Event>
+ReadTrace (std::string const & file, uint32_t & size, uint32_t & threshold)
+{
+  std::ifstream is (file.c_str ());
+  NS_ABORT_MSG_UNLESS (is, "Cannot read " << file);
+  std::vector<Event> events;
+  std::string line;
+  size = 0;
+  while (std::getline (is, line))
+    {
+      std::istringstream ls (line);
+      std::string type;
+      if (!(ls >> type))
+        {
+          continue;
+        }
+      if (type == "#")
+        {
+          std::string tool;
+          std::string key;
+          if (ls >> tool >> key && tool == "bsdvr-replay" && key == "nodes")
+            {
+              ls >> size >> key >> threshold;
+            }
+          continue;
+        }
+      Event e = { type[0], 0, 0, Ipv4Address (), 0, 0 };
+      std::string node;
+      std::string peer;
+      std::string dst;
+      ls >> node >> peer;
+      if (e.m_type == 'R')
+        {
+          ls >> dst >> e.m_hop >> e.m_state;
+        }
+      else if (e.m_type == 'T')
+        {
+          ls >> dst;
+        }
+      NS_ABORT_MSG_IF (type.size () != 1 || std::string ("UDRT").find (e.m_type) == std::string::npos || !ls,
+                       "Malformed trace line: " << line);
+      e.m_node = BsdvrEngineNetwork::GetIndex (Ipv4Address (node.c_str ()));
+      e.m_peer = BsdvrEngineNetwork::GetIndex (Ipv4Address (peer.c_str ()));
+      e.m_dst = dst.empty () ? Ipv4Address () : Ipv4Address (dst.c_str ());
+      NS_ABORT_MSG_IF (e.m_node >= size || e.m_peer >= size, "Node out of range: " << line);
+      events.push_back (e);
+    }
+  return events;
+}
+
+}  // unnamed namespace
+
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t size = 100;
+  std::string topology = "grid";
+  double density = 8;
+  uint32_t churn = 100;
+  uint32_t threshold = bsdvr::constants::BSDVR_THRESHOLD;
+  uint64_t maxEvents = 100000000;
+  uint32_t run = 1;
+  std::string record = "";
+  std::string trace = "";
+  uint32_t repeat = 1;
+  std::string output = "";
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("nodes", "Number of nodes of a generated run", size);
+  cmd.AddValue ("topology", "Topology of a generated run: grid, line or disc", topology);
+  cmd.AddValue ("density", "Mean number of neighbors in a disc", density);
+  cmd.AddValue ("churn", "Link failures of a generated run, each followed by the link coming back", churn);
+  cmd.AddValue ("threshold", "Hop threshold of a generated run", threshold);
+  cmd.AddValue ("maxEvents", "Events after which a generated run is aborted", maxEvents);
+  cmd.AddValue ("run", "Random number generator run", run);
+  cmd.AddValue ("record", "Trace file the events of a generated run are written to", record);
+  cmd.AddValue ("trace", "Trace file to replay instead of generating events", trace);
+  cmd.AddValue ("repeat", "Number of replays of the trace", repeat);
+  cmd.AddValue ("output", "CSV file the row is appended to, standard output if empty", output);
+  cmd.Parse (argc, argv);
+
+  std::string mode = trace.empty () ? "generate" : "replay";
+  std::string source = trace.empty () ? topology : trace;
+  uint64_t events = 0;
+  uint64_t messages = 0;
+  uint64_t pendingReplies = 0;
+  uint64_t checksum = 0;
+  Statistics stats;
+  double wall = 0;
+  if (trace.empty ())
+    {
+      NS_ABORT_MSG_IF (size < 2, "At least two nodes are needed");
+      NS_ABORT_MSG_IF (size > 65000, "10.0.0.0/16 holds at most 65000 nodes");
+      RngSeedManager::SetRun (run);
+      Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+      rng->SetStream (0);
+      BsdvrEngineNetwork network (size, threshold);
+      Build (network, topology, density, rng);
+      NS_ABORT_MSG_UNLESS (network.Record (record), "Cannot write " << record);
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+      Generate (network, churn, maxEvents, rng);
+      wall = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+      events = network.GetEvents ();
+      messages = network.GetMessages ();
+      pendingReplies = network.GetPendingReplies ();
+      stats = network.GetStatistics ();
+      checksum = network.GetChecksum ();
+    }
+  else
+    {
+      NS_ABORT_MSG_IF (repeat == 0, "repeat must be positive");
+      std::vector<Event> replay = ReadTrace (trace, size, threshold);
+      NS_ABORT_MSG_IF (size == 0, "No bsdvr-replay header in " << trace);
+      EngineOutput out;
+      std::vector<EngineMessage> sent;
+      for (uint32_t r = 0; r < repeat; r++)
+        {
+          BsdvrEngineNetwork network (size, threshold);
+          messages = 0;
+          pendingReplies = 0;
+          std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+          for (std::vector<Event>::const_iterator e = replay.begin (); e != replay.end (); ++e)
+            {
+              network.Apply (*e, out, sent);
+              messages += sent.size ();
+              pendingReplies += out.m_pendingReplies.size ();
+            }
+          wall += std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+          stats = network.GetStatistics ();
+          checksum = network.GetChecksum ();
+        }
+      events = replay.size () * uint64_t (repeat);
+      wall /= repeat;
+      events /= repeat;
+    }
+
+  std::ofstream file;
+  std::ostream & os = OpenCsvOutput (output,
+                                     "mode,source,nodes,threshold,churn,run,repeat,events,messages,pending_replies,ft_computations,"
+                                     "destinations_evaluated,ft_changes,wall_s,events_per_s,ns_per_event,checksum", file);
+  os << mode << "," << source << "," << size << "," << threshold << "," << churn << "," << run << ","
+     << repeat << "," << events << "," << messages << "," << pendingReplies << ","
+     << stats.m_ftComputations << "," << stats.m_destinationsEvaluated << "," << stats.m_ftChanges << ","
+     << wall << "," << (wall > 0 ? events / wall : 0) << "," << (events ? wall * 1e9 / events : 0) << ","
+     << std::hex << checksum << std::dec << std::endl;
+  return 0;
+}
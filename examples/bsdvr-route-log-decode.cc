@@ -0,0 +1,62 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Decode a BSDVR route change log (RouteLogFile attribute) into CSV.
+ *
+ *   ./waf --run "bsdvr-route-log-decode --input=route-changes.bin --output=route-changes.csv"
+ */
+#include <iostream>
+#include <fstream>
+#include "ns3/bsdvr-route-log.h"
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+
+int
+main (int argc, char *argv[])
+{
+  std::string input = "bsdvr-route-log.bin";
+  std::string output = "";
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("input", "Binary route change log", input);
+  cmd.AddValue ("output", "CSV file, standard output if empty", output);
+  cmd.Parse (argc, argv);
+
+  std::ifstream is (input.c_str (), std::ios::binary);
+  if (!is)
+    {
+      std::cerr << "Cannot open " << input << std::endl;
+      return 1;
+    }
+  std::ofstream file;
+  if (!output.empty ())
+    {
+      file.open (output.c_str ());
+    }
+  std::ostream & os = output.empty () ? std::cout : file;
+
+  os << "node,time_ns,dst,old_next_hop,new_next_hop,hop,state,cause\n";
+  uint32_t nodeId;
+  uint32_t blocks = 0;
+  std::vector<bsdvr::RouteChangeRecord> records;
+  while (bsdvr::RouteChangeLog::ReadBlock (is, nodeId, records))
+    {
+      for (std::vector<bsdvr::RouteChangeRecord>::const_iterator r = records.begin (); r != records.end (); ++r)
+        {
+          os << nodeId << "," << r->m_time << ","
+             << Ipv4Address (r->m_dst) << "," << Ipv4Address (r->m_oldNextHop) << ","
+             << Ipv4Address (r->m_newNextHop) << "," << r->m_hop << ","
+             << (r->m_state ? "ACTIVE" : "INACTIVE") << ","
+             << bsdvr::RouteChangeLog::GetCauseName (r->m_cause) << "\n";
+        }
+      records.clear ();
+      blocks++;
+    }
+  if (!is.eof ())
+    {
+      std::cerr << "Malformed block after " << blocks << " blocks" << std::endl;
+      return 1;
+    }
+  return 0;
+}
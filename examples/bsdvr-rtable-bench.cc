@@ -0,0 +1,550 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Micro-benchmark of the BSDVR routing table data structures.
+ *
+ * Every operation is timed over tables of each requested size and reported
+ * as one CSV row: time per operation, heap allocations and bytes per
+ * operation (counted by replacing the global operator new), the peak heap
+ * growth during the case, the table size estimated by
+ * RoutingTable::GetMemoryUsage and the peak RSS of the process so far.
+ *
+ *   ./waf --run "bsdvr-rtable-bench --sizes=10,1000,100000 --minTime=0.5 --output=rtable.csv"
+ *
+ * Build with --build-profile=optimized for meaningful numbers; in debug
+ * builds the NS_LOG checks of every call are part of the measurement.
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <new>
+#include <cstdlib>
+#include "ns3/bsdvr.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "bsdvr-example-common.h"
+
+using namespace ns3;
+
+namespace {
+
+/// Size of the block header holding the allocation size
+const std::size_t HEADER_SIZE = 16;
+/// Number of operator new calls
+uint64_t g_allocs = 0;
+/// Bytes requested from operator new
+uint64_t g_allocBytes = 0;
+/// Bytes currently allocated
+uint64_t g_liveBytes = 0;
+/// Highest g_liveBytes since the last reset
+uint64_t g_peakBytes = 0;
+
+void *
+CountedAlloc (std::size_t size)
+{
+  void *p = std::malloc (size + HEADER_SIZE);
+  if (p == 0)
+    {
+      return 0;
+    }
+  *static_cast<std::size_t *> (p) = size;
+  g_allocs++;
+  g_allocBytes += size;
+  g_liveBytes += size;
+  if (g_liveBytes > g_peakBytes)
+    {
+      g_peakBytes = g_liveBytes;
+    }
+  return static_cast<char *> (p) + HEADER_SIZE;
+}
+
+void
+CountedFree (void *p)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  char *base = static_cast<char *> (p) - HEADER_SIZE;
+  g_liveBytes -= *reinterpret_cast<std::size_t *> (base);
+  std::free (base);
+}
+
+}  // unnamed namespace
+
+void *
+operator new (std::size_t size)
+{
+  void *p = CountedAlloc (size);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+void *
+operator new (std::size_t size, std::nothrow_t const &) noexcept
+{
+  return CountedAlloc (size);
+}
+
+void
+operator delete (void *p) noexcept
+{
+  CountedFree (p);
+}
+
+void
+operator delete (void *p, std::nothrow_t const &) noexcept
+{
+  CountedFree (p);
+}
+
+void
+operator delete (void *p, std::size_t) noexcept
+{
+  CountedFree (p);
+}
+
+namespace {
+
+typedef std::map<Ipv4Address, bsdvr::RoutingTableEntry> EntryMap;
+typedef std::map<Ipv4Address, EntryMap*> DistanceVectorMap;
+
+/// Number of interfaces the entries are spread over
+const uint32_t INTERFACES = 4;
+
+/**
+ * \brief Accumulates time and allocations over the timed sections of a case
+ */
+class Meter
+{
+public:
+  Meter ()
+    : m_ns (0),
+      m_ops (0),
+      m_rounds (0),
+      m_allocs (0),
+      m_allocBytes (0),
+      m_startAllocs (0),
+      m_startAllocBytes (0)
+  {
+    g_peakBytes = g_liveBytes;
+    m_baseBytes = g_liveBytes;
+  }
+  /// Start a timed section
+  void Start ()
+  {
+    m_startAllocs = g_allocs;
+    m_startAllocBytes = g_allocBytes;
+    m_start = std::chrono::steady_clock::now ();
+  }
+  /**
+   * End a timed section
+   * \param ops the number of operations done in the section
+   */
+  void Stop (uint64_t ops)
+  {
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now ();
+    m_ns += std::chrono::duration_cast<std::chrono::nanoseconds> (end - m_start).count ();
+    m_allocs += g_allocs - m_startAllocs;
+    m_allocBytes += g_allocBytes - m_startAllocBytes;
+    m_ops += ops;
+    m_rounds++;
+  }
+  /// \returns the timed seconds so far
+  double GetSeconds () const
+  {
+    return m_ns / 1e9;
+  }
+  /// \returns the number of timed sections so far
+  uint64_t GetRounds () const
+  {
+    return m_rounds;
+  }
+  /**
+   * Write the CSV row of the case
+   * \param os the output stream
+   * \param op the operation name
+   * \param entries the table size
+   * \param tableBytes the estimated table size in bytes
+   */
+  void Print (std::ostream & os, std::string const & op, uint32_t entries, uint64_t tableBytes) const
+  {
+    double ops = m_ops ? m_ops : 1;
+    os << op << "," << entries << "," << m_rounds << "," << m_ops << ","
+       << m_ns / ops << "," << m_allocs / ops << "," << m_allocBytes / ops << ","
+       << g_peakBytes - m_baseBytes << "," << tableBytes << "," << GetPeakRss () << std::endl;
+  }
+
+private:
+  uint64_t m_ns;                                     ///< timed nanoseconds
+  uint64_t m_ops;                                    ///< timed operations
+  uint64_t m_rounds;                                 ///< timed sections
+  uint64_t m_allocs;                                 ///< allocations in timed sections
+  uint64_t m_allocBytes;                             ///< bytes allocated in timed sections
+  uint64_t m_startAllocs;                            ///< g_allocs at Start
+  uint64_t m_startAllocBytes;                        ///< g_allocBytes at Start
+  uint64_t m_baseBytes;                              ///< g_liveBytes when the case began
+  std::chrono::steady_clock::time_point m_start;     ///< Start time
+};
+
+/**
+ * \brief Runs every operation over tables of one size
+ */
+class Bench
+{
+public:
+  /**
+   * constructor
+   * \param os the CSV stream
+   * \param entries the table size
+   * \param neighbors the number of DVT neighbors
+   * \param minTime the timed seconds of each case
+   * \param maxRounds the largest number of timed sections of each case
+   */
+  Bench (std::ostream & os, uint32_t entries, uint32_t neighbors, double minTime, uint32_t maxRounds);
+  /// Run all cases
+  void Run ();
+
+private:
+  /// Time AddRoute into an empty FT
+  void BenchAddRoute ();
+  /// Time LookupRoute of present destinations
+  void BenchLookupRoute ();
+  /// Time Update of present destinations
+  void BenchUpdate ();
+  /// Time SetEntryState of present destinations
+  void BenchSetEntryState ();
+  /// Time DeleteAllRoutesFromInterface of one interface out of INTERFACES
+  void BenchDeleteAllRoutesFromInterface ();
+  /// Time Print of the FT
+  void BenchPrint ();
+  /// Time the DVT population of UpdateDistanceVectorTable into an empty DVT
+  void BenchDvtPopulate ();
+  /// Time the DVT update of UpdateDistanceVectorTable for present routes
+  void BenchDvtUpdate ();
+  /**
+   * \param meter the case meter
+   * \returns whether the case needs another timed section
+   */
+  bool More (Meter const & meter) const;
+  /**
+   * Fill an FT with all entries
+   * \param table the routing table
+   */
+  void Fill (bsdvr::RoutingTable & table) const;
+  /**
+   * Store a route in the DVT the way RoutingProtocol::UpdateDistanceVectorTable does
+   * \param dvt the distance vector table
+   * \param nxtHp the neighbor
+   * \param rt the route
+   */
+  static void UpdateDvt (DistanceVectorMap & dvt, Ipv4Address nxtHp, bsdvr::RoutingTableEntry & rt);
+  /**
+   * Free the neighbor maps of a DVT
+   * \param dvt the distance vector table
+   */
+  static void ClearDvt (DistanceVectorMap & dvt);
+
+  std::ostream & m_os;                             ///< CSV stream
+  uint32_t m_entries;                              ///< table size
+  uint32_t m_neighbors;                            ///< DVT neighbors
+  double m_minTime;                                ///< timed seconds per case
+  uint32_t m_maxRounds;                            ///< timed sections per case
+  std::vector<Ipv4InterfaceAddress> m_ifaces;      ///< interfaces of the entries
+  std::vector<bsdvr::RoutingTableEntry> m_routes;  ///< one entry per destination
+  std::vector<uint32_t> m_order;                   ///< shuffled access order into m_routes
+};
+
+Bench::Bench (std::ostream & os, uint32_t entries, uint32_t neighbors, double minTime, uint32_t maxRounds)
+  : m_os (os),
+    m_entries (entries),
+    m_neighbors (neighbors),
+    m_minTime (minTime),
+    m_maxRounds (maxRounds)
+{
+  for (uint32_t i = 0; i < INTERFACES; i++)
+    {
+      m_ifaces.push_back (Ipv4InterfaceAddress (Ipv4Address (0x0afe0001 + (i << 8)), Ipv4Mask ("255.255.255.0")));
+    }
+  m_routes.reserve (entries);
+  m_order.reserve (entries);
+  for (uint32_t i = 0; i < entries; i++)
+    {
+      Ipv4Address dst (0x0a000001 + i);
+      Ipv4Address nextHop (0x0aff0001 + i % neighbors);
+      m_routes.push_back (bsdvr::RoutingTableEntry (/*device=*/ 0, dst, m_ifaces[i % INTERFACES],
+                                                    /*hops=*/ 1 + i % 16, nextHop, /*changedEntries=*/ false));
+      m_order.push_back (i);
+    }
+  std::mt19937 rng (1);
+  std::shuffle (m_order.begin (), m_order.end (), rng);
+}
+
+bool
+Bench::More (Meter const & meter) const
+{
+  return meter.GetRounds () == 0 || (meter.GetSeconds () < m_minTime && meter.GetRounds () < m_maxRounds);
+}
+
+void
+Bench::Fill (bsdvr::RoutingTable & table) const
+{
+  for (uint32_t i = 0; i < m_entries; i++)
+    {
+      table.GetForwardingTable ()->insert (std::make_pair (m_routes[i].GetDestination (), m_routes[i]));
+    }
+}
+
+void
+Bench::UpdateDvt (DistanceVectorMap & dvt, Ipv4Address nxtHp, bsdvr::RoutingTableEntry & rt)
+{
+  Ipv4Address dst = rt.GetDestination ();
+  DistanceVectorMap::iterator n_dvt = dvt.find (nxtHp);
+  if (n_dvt == dvt.end ())
+    {
+      dvt.insert (std::make_pair (nxtHp, new EntryMap ()));
+    }
+  EntryMap* n_dvt_entries = dvt[nxtHp];
+  EntryMap::iterator n_dvt_entry = n_dvt_entries->find (dst);
+  if (n_dvt_entry != n_dvt_entries->end ())
+    {
+      (*n_dvt_entries)[dst] = rt;
+    }
+  else
+    {
+      n_dvt_entries->insert (std::make_pair (dst, rt));
+    }
+}
+
+void
+Bench::ClearDvt (DistanceVectorMap & dvt)
+{
+  for (DistanceVectorMap::iterator i = dvt.begin (); i != dvt.end (); ++i)
+    {
+      delete i->second;
+    }
+  dvt.clear ();
+}
+
+void
+Bench::BenchAddRoute ()
+{
+  Meter meter;
+  uint64_t tableBytes = 0;
+  while (More (meter))
+    {
+      bsdvr::RoutingTable table;
+      EntryMap* ft = table.GetForwardingTable ();
+      meter.Start ();
+      for (uint32_t i = 0; i < m_entries; i++)
+        {
+          table.AddRoute (m_routes[i], ft);
+        }
+      meter.Stop (m_entries);
+      tableBytes = table.GetMemoryUsage ();
+    }
+  meter.Print (m_os, "AddRoute", m_entries, tableBytes);
+}
+
+void
+Bench::BenchLookupRoute ()
+{
+  bsdvr::RoutingTable table;
+  Fill (table);
+  EntryMap* ft = table.GetForwardingTable ();
+  Meter meter;
+  bsdvr::RoutingTableEntry rt;
+  uint32_t found = 0;
+  while (More (meter))
+    {
+      meter.Start ();
+      for (uint32_t i = 0; i < m_entries; i++)
+        {
+          found += table.LookupRoute (m_routes[m_order[i]].GetDestination (), rt, ft);
+        }
+      meter.Stop (m_entries);
+    }
+  NS_ABORT_MSG_UNLESS (found == m_entries * meter.GetRounds (), "LookupRoute missed present destinations");
+  meter.Print (m_os, "LookupRoute", m_entries, table.GetMemoryUsage ());
+}
+
+void
+Bench::BenchUpdate ()
+{
+  bsdvr::RoutingTable table;
+  Fill (table);
+  EntryMap* ft = table.GetForwardingTable ();
+  Meter meter;
+  while (More (meter))
+    {
+      meter.Start ();
+      for (uint32_t i = 0; i < m_entries; i++)
+        {
+          table.Update (m_routes[m_order[i]], ft);
+        }
+      meter.Stop (m_entries);
+    }
+  meter.Print (m_os, "Update", m_entries, table.GetMemoryUsage ());
+}
+
+void
+Bench::BenchSetEntryState ()
+{
+  bsdvr::RoutingTable table;
+  Fill (table);
+  EntryMap & ft = *table.GetForwardingTable ();
+  Meter meter;
+  while (More (meter))
+    {
+      bsdvr::RouteState state = (meter.GetRounds () % 2) ? bsdvr::ACTIVE : bsdvr::INACTIVE;
+      meter.Start ();
+      for (uint32_t i = 0; i < m_entries; i++)
+        {
+          table.SetEntryState (m_routes[m_order[i]].GetDestination (), state, ft);
+        }
+      meter.Stop (m_entries);
+    }
+  meter.Print (m_os, "SetEntryState", m_entries, table.GetMemoryUsage ());
+}
+
+void
+Bench::BenchDeleteAllRoutesFromInterface ()
+{
+  Meter meter;
+  uint64_t tableBytes = 0;
+  while (More (meter))
+    {
+      bsdvr::RoutingTable table;
+      Fill (table);
+      tableBytes = table.GetMemoryUsage ();
+      meter.Start ();
+      table.DeleteAllRoutesFromInterface (m_ifaces[0], table.GetForwardingTable ());
+      meter.Stop (1);
+    }
+  meter.Print (m_os, "DeleteAllRoutesFromInterface", m_entries, tableBytes);
+}
+
+void
+Bench::BenchPrint ()
+{
+  bsdvr::RoutingTable table;
+  Fill (table);
+  std::ostringstream oss;
+  Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (&oss);
+  Meter meter;
+  while (More (meter))
+    {
+      oss.str ("");
+      meter.Start ();
+      table.Print (table.GetForwardingTable (), stream);
+      meter.Stop (1);
+    }
+  meter.Print (m_os, "Print", m_entries, table.GetMemoryUsage ());
+}
+
+void
+Bench::BenchDvtPopulate ()
+{
+  Meter meter;
+  uint64_t tableBytes = 0;
+  while (More (meter))
+    {
+      bsdvr::RoutingTable table;
+      DistanceVectorMap & dvt = *table.GetDistanceVectorTable ();
+      meter.Start ();
+      for (uint32_t i = 0; i < m_entries; i++)
+        {
+          UpdateDvt (dvt, m_routes[i].GetNextHop (), m_routes[i]);
+        }
+      meter.Stop (m_entries);
+      tableBytes = table.GetMemoryUsage ();
+      ClearDvt (dvt);
+    }
+  meter.Print (m_os, "DvtPopulate", m_entries, tableBytes);
+}
+
+void
+Bench::BenchDvtUpdate ()
+{
+  bsdvr::RoutingTable table;
+  DistanceVectorMap & dvt = *table.GetDistanceVectorTable ();
+  for (uint32_t i = 0; i < m_entries; i++)
+    {
+      UpdateDvt (dvt, m_routes[i].GetNextHop (), m_routes[i]);
+    }
+  Meter meter;
+  while (More (meter))
+    {
+      meter.Start ();
+      for (uint32_t i = 0; i < m_entries; i++)
+        {
+          bsdvr::RoutingTableEntry & rt = m_routes[m_order[i]];
+          UpdateDvt (dvt, rt.GetNextHop (), rt);
+        }
+      meter.Stop (m_entries);
+    }
+  meter.Print (m_os, "DvtUpdate", m_entries, table.GetMemoryUsage ());
+  ClearDvt (dvt);
+}
+
+void
+Bench::Run ()
+{
+  BenchAddRoute ();
+  BenchLookupRoute ();
+  BenchUpdate ();
+  BenchSetEntryState ();
+  BenchDeleteAllRoutesFromInterface ();
+  BenchPrint ();
+  BenchDvtPopulate ();
+  BenchDvtUpdate ();
+}
+
+}  // unnamed namespace
+
+
+int
+main (int argc, char *argv[])
+{
+  std::string sizes = "10,100,1000,10000,100000";
+  uint32_t neighbors = 8;
+  double minTime = 0.2;
+  uint32_t maxRounds = 100000;
+  std::string output = "";
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("sizes", "Comma separated table sizes", sizes);
+  cmd.AddValue ("neighbors", "Number of neighbors the DVT entries are spread over", neighbors);
+  cmd.AddValue ("minTime", "Timed seconds of each case", minTime);
+  cmd.AddValue ("maxRounds", "Largest number of timed passes of each case", maxRounds);
+  cmd.AddValue ("output", "CSV file, standard output if empty", output);
+  cmd.Parse (argc, argv);
+  NS_ABORT_MSG_IF (neighbors == 0, "neighbors must be positive");
+
+  std::ofstream file;
+  if (!output.empty ())
+    {
+      file.open (output.c_str ());
+    }
+  std::ostream & os = output.empty () ? std::cout : file;
+
+  os << "op,entries,rounds,ops,ns_per_op,allocs_per_op,alloc_bytes_per_op,peak_heap_bytes,table_bytes,peak_rss_kb" << std::endl;
+  std::istringstream list (sizes);
+  std::string size;
+  while (std::getline (list, size, ','))
+    {
+      uint32_t entries = std::strtoul (size.c_str (), 0, 10);
+      if (entries == 0)
+        {
+          continue;
+        }
+      Bench bench (os, entries, neighbors, minTime, maxRounds);
+      bench.Run ();
+    }
+  return 0;
+}
@@ -0,0 +1,214 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Scaling scenario: BSDVR on N static ad-hoc WiFi nodes placed on a grid,
+ * a line or uniformly in a disc, run from cold start until the forwarding
+ * tables stop changing.
+ *
+ * The radio is a unit disk of --range meters, see InstallUnitDiskWifi. In a
+ * disc, --density is the mean number of neighbors and sets the disc radius.
+ *
+ * The run stops at convergence (no route change for --window) or at
+ * --duration, and writes one CSV row. With --output the row is appended to a
+ * file, with its header when the file is new, so that a sweep collects one
+ * file:
+ *
+ *   for n in 50 100 200 500 1000 2000 5000; do
+ *     ./waf --run "bsdvr-scaling --nodes=$n --topology=disc --output=scaling.csv"
+ *   done
+ *
+ * RoutingProtocol attributes are set on the command line, such as
+ * --ns3::bsdvr::RoutingProtocol::HelloInterval=2s. bsdvr-sweep.py runs a grid
+ * of node counts, attribute values and runs in parallel, one process per run,
+ * and merges the rows.
+ */
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cmath>
+#include "ns3/bsdvr-module.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "bsdvr-example-common.h"
+#include "bsdvr-example-scenario.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("BsdvrScaling");
+
+/// Control messages sent by all nodes
+static uint64_t g_controlPackets = 0;
+/// Bytes of the control messages sent by all nodes
+static uint64_t g_controlBytes = 0;
+
+/// Tx trace sink counting the control messages of all nodes
+static void
+ControlTx (uint8_t type, Ipv4Address peer, Ipv4Address dst, uint32_t hop, uint32_t state, uint32_t bytes)
+{
+  g_controlPackets++;
+  g_controlBytes += bytes;
+}
+
+/// Converged trace sink stopping the simulation at the first real convergence
+static void
+Converged (Time convergenceTime, uint32_t changes)
+{
+  // A quiet window before the first HELLO arrives is not convergence
+  if (changes > 0)
+    {
+      NS_LOG_INFO ("Converged at " << Simulator::Now ().As (Time::S) << " after " << changes << " route changes");
+      Simulator::Stop ();
+    }
+}
+
+/**
+ * Place the nodes
+ * \param nodes the nodes
+ * \param topology grid, line or disc
+ * \param spacing the grid and line spacing, in meters
+ * \param range the radio range, in meters
+ * \param density the mean number of neighbors in a disc
+ */
+static void
+PlaceNodes (NodeContainer nodes, std::string const & topology, double spacing, double range, double density)
+{
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  if (topology == "grid")
+    {
+      uint32_t width = std::ceil (std::sqrt (nodes.GetN ()));
+      mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                     "MinX", DoubleValue (0.0),
+                                     "MinY", DoubleValue (0.0),
+                                     "DeltaX", DoubleValue (spacing),
+                                     "DeltaY", DoubleValue (spacing),
+                                     "GridWidth", UintegerValue (width),
+                                     "LayoutType", StringValue ("RowFirst"));
+    }
+  else if (topology == "line")
+    {
+      mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                     "MinX", DoubleValue (0.0),
+                                     "MinY", DoubleValue (0.0),
+                                     "DeltaX", DoubleValue (spacing),
+                                     "DeltaY", DoubleValue (spacing),
+                                     "GridWidth", UintegerValue (nodes.GetN ()),
+                                     "LayoutType", StringValue ("RowFirst"));
+    }
+  else if (topology == "disc")
+    {
+      // N * range^2 / radius^2 neighbors on average, ignoring the border
+      double radius = range * std::sqrt (nodes.GetN () / density);
+      mobility.SetPositionAllocator ("ns3::UniformDiscPositionAllocator",
+                                     "rho", DoubleValue (radius),
+                                     "X", DoubleValue (0.0),
+                                     "Y", DoubleValue (0.0));
+    }
+  else
+    {
+      NS_FATAL_ERROR ("Unknown topology " << topology << ", expected grid, line or disc");
+    }
+  mobility.Install (nodes);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t size = 100;
+  std::string topology = "grid";
+  double spacing = 80;
+  double range = 100;
+  double density = 8;
+  double duration = 300;
+  double window = 3;
+  uint32_t run = 1;
+  std::string output = "";
+  std::string profile = "";
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("nodes", "Number of nodes", size);
+  cmd.AddValue ("topology", "Node placement: grid, line or disc", topology);
+  cmd.AddValue ("spacing", "Distance between grid and line neighbors, in meters", spacing);
+  cmd.AddValue ("range", "Radio range, in meters", range);
+  cmd.AddValue ("density", "Mean number of neighbors in a disc", density);
+  cmd.AddValue ("duration", "Simulated seconds after which the run stops unconverged", duration);
+  cmd.AddValue ("window", "Seconds without a route change after which the network is converged", window);
+  cmd.AddValue ("run", "Random number generator run", run);
+  cmd.AddValue ("output", "CSV file the row is appended to, standard output if empty", output);
+  cmd.AddValue ("profile", "File the control-plane profile is written to, see --enable-bsdvr-profiling", profile);
+  cmd.Parse (argc, argv);
+  NS_ABORT_MSG_IF (size < 2, "At least two nodes are needed");
+  NS_ABORT_MSG_IF (size > 65000, "10.0.0.0/16 holds at most 65000 nodes");
+  NS_ABORT_MSG_IF (density <= 0, "density must be positive");
+
+  RngSeedManager::SetRun (run);
+
+  NodeContainer nodes;
+  nodes.Create (size);
+  PlaceNodes (nodes, topology, spacing, range, density);
+  NetDeviceContainer devices = InstallUnitDiskWifi (nodes, range);
+
+  BsdvrHelper bsdvr;
+  InternetStackHelper stack;
+  stack.SetRoutingHelper (bsdvr);
+  stack.Install (nodes);
+  AssignAddresses (devices);
+  bsdvr.AssignStreams (nodes, 0);
+
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      BsdvrHelper::GetRoutingProtocol (*i)->TraceConnectWithoutContext ("Tx", MakeCallback (&ControlTx));
+    }
+  Ptr<BsdvrConvergenceMonitor> monitor = CreateObject<BsdvrConvergenceMonitor> ();
+  monitor->SetAttribute ("QuiescentWindow", TimeValue (Seconds (window)));
+  monitor->Install (nodes);
+  monitor->TraceConnectWithoutContext ("Converged", MakeCallback (&Converged));
+
+  Simulator::Stop (Seconds (duration));
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  Simulator::Run ();
+  double wall = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+  bool converged = monitor->IsConverged ();
+  bsdvr::Statistics stats = bsdvr.GetStatistics (nodes);
+  bsdvr::MemoryUsage memory = bsdvr.GetMemoryUsage (nodes);
+  // ACTIVE routes to other nodes, against the N (N - 1) of a connected network
+  uint64_t routes = 0;
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4> ();
+      std::map<Ipv4Address, bsdvr::RoutingTableEntry> const * ft =
+        BsdvrHelper::GetRoutingProtocol (*i)->GetRoutingTable ().GetForwardingTable ();
+      for (std::map<Ipv4Address, bsdvr::RoutingTableEntry>::const_iterator e = ft->begin (); e != ft->end (); ++e)
+        {
+          if (e->second.GetRouteState () == bsdvr::ACTIVE && e->first != Ipv4Address::GetLoopback ()
+              && ipv4->GetInterfaceForAddress (e->first) < 0)
+            {
+              routes++;
+            }
+        }
+    }
+
+  std::ofstream file;
+  std::ostream & os = OpenCsvOutput (output,
+                                     "topology,nodes,range,spacing,density,run,converged,convergence_s,sim_time_s,wall_s,events,"
+                                     "control_packets,control_bytes,updates_sent,hellos_sent,ft_changes,route_coverage,"
+                                     "memory_bytes,peak_rss_kb", file);
+  os << topology << "," << size << "," << range << "," << spacing << "," << density << "," << run << ","
+     << converged << "," << (converged ? monitor->GetLastConvergenceTime ().GetSeconds () : -1) << ","
+     << Simulator::Now ().GetSeconds () << "," << wall << "," << Simulator::GetEventCount () << ","
+     << g_controlPackets << "," << g_controlBytes << "," << stats.m_updatesSent << ","
+     << stats.m_hellosSent << "," << stats.m_ftChanges << ","
+     << double (routes) / (double (size) * (size - 1)) << ","
+     << memory.GetTotal () << "," << GetPeakRss () << std::endl;
+  if (!profile.empty ())
+    {
+      BsdvrHelper::PrintProfile (Create<OutputStreamWrapper> (profile, std::ios::out));
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
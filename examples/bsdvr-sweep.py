@@ -0,0 +1,280 @@
+#!/usr/bin/env python3
+# -*- Mode: python; py-indent-offset: 4; indent-tabs-mode: nil; coding: utf-8; -*-
+"""
+Parameter sweep of the bsdvr-scaling scenario over all local cores.
+
+The grid is the cartesian product of the node counts, the RoutingProtocol
+attributes (HelloInterval, MaxQueueLen, MaxPRQueueLen, MaxPRQueueTime) and
+the runs. Every point is an independent simulation in its own process, at
+most --jobs at a time, largest node counts first so that the longest runs do
+not start last. Each run writes its row to <out>/runs/<name>.csv, renamed
+into place only once the run succeeded; an interrupted sweep started again
+with the same --out skips the runs already done. When the sweep ends or is
+interrupted, the rows of all finished runs are merged into <out>/sweep.csv,
+with the attribute values as leading columns. The output of each run goes to
+<out>/logs/<name>.log.
+
+Run from the top of the ns-3 tree after ./waf build, preferably with
+--build-profile=optimized:
+
+  python3 src/bsdvr/examples/bsdvr-sweep.py --out=sweep \\
+      --nodes=100,200,500,1000 --runs=1-20 \\
+      --hello-interval=0.5s,1s,2s --max-queue-len=64,256 \\
+      --max-pr-queue-len=50,200 --max-pr-queue-time=1s,3s \\
+      --extra="--topology=disc --duration=300"
+
+--dry-run prints the command lines without running anything.
+"""
+
+import argparse
+import concurrent.futures
+import csv
+import glob
+import itertools
+import os
+import shlex
+import signal
+import subprocess
+import sys
+import threading
+
+# Sweep axes: option name, RoutingProtocol attribute, merged CSV column
+ATTRIBUTES = [
+    ('hello_interval', 'HelloInterval', 'hello_interval'),
+    ('max_queue_len', 'MaxQueueLen', 'max_queue_len'),
+    ('max_pr_queue_len', 'MaxPRQueueLen', 'max_pr_queue_len'),
+    ('max_pr_queue_time', 'MaxPRQueueTime', 'max_pr_queue_time'),
+]
+
+ATTRIBUTE_PREFIX = '--ns3::bsdvr::RoutingProtocol::'
+
+
+def parse_list(text):
+    """Split a comma separated list, dropping empty items"""
+    return [item.strip() for item in text.split(',') if item.strip()]
+
+
+def parse_runs(text):
+    """Expand a run list such as 1-10,15 into integers"""
+    runs = []
+    for item in parse_list(text):
+        if '-' in item:
+            first, last = item.split('-', 1)
+            runs.extend(range(int(first), int(last) + 1))
+        else:
+            runs.append(int(item))
+    return runs
+
+
+def find_program(ns3_dir):
+    """Locate the bsdvr-scaling binary of the last build"""
+    patterns = [
+        os.path.join(ns3_dir, 'build', 'src', 'bsdvr', 'examples', '*bsdvr-scaling*'),
+        os.path.join(ns3_dir, 'build', 'contrib', 'bsdvr', 'examples', '*bsdvr-scaling*'),
+    ]
+    for pattern in patterns:
+        found = [p for p in glob.glob(pattern) if os.access(p, os.X_OK) and not p.endswith('.o')]
+        if found:
+            return max(found, key=os.path.getmtime)
+    return None
+
+
+def run_name(point):
+    """File name of a grid point, unique and stable across invocations"""
+    parts = ['n%s' % point['nodes']]
+    for option, _, _ in ATTRIBUTES:
+        parts.append('%s%s' % (''.join(w[0] for w in option.split('_')), point[option]))
+    parts.append('r%d' % point['run'])
+    return '_'.join(parts).replace('/', '-')
+
+
+class Sweep(object):
+    """Runs the grid points and merges their rows"""
+
+    def __init__(self, args, program):
+        self.args = args
+        self.program = program
+        self.runs_dir = os.path.join(args.out, 'runs')
+        self.logs_dir = os.path.join(args.out, 'logs')
+        self.merged = os.path.join(args.out, 'sweep.csv')
+        self.lock = threading.Lock()
+        self.stopping = threading.Event()
+        self.children = set()
+        self.done = 0
+        self.failed = 0
+
+    def points(self):
+        """The grid points, largest node counts first"""
+        axes = [parse_list(self.args.nodes)]
+        axes.extend(parse_list(getattr(self.args, option)) for option, _, _ in ATTRIBUTES)
+        axes.append(parse_runs(self.args.runs))
+        points = []
+        for values in itertools.product(*axes):
+            point = {'nodes': values[0], 'run': values[-1]}
+            for (option, _, _), value in zip(ATTRIBUTES, values[1:-1]):
+                point[option] = value
+            points.append(point)
+        points.sort(key=lambda p: -int(p['nodes']))
+        return points
+
+    def command(self, point, output):
+        """Command line of one grid point"""
+        cmd = [self.program, '--nodes=%s' % point['nodes'], '--run=%d' % point['run'],
+               '--output=%s' % output]
+        for option, attribute, _ in ATTRIBUTES:
+            cmd.append('%s%s=%s' % (ATTRIBUTE_PREFIX, attribute, point[option]))
+        cmd.extend(shlex.split(self.args.extra))
+        return cmd
+
+    def run(self, point, total):
+        """Run one grid point; returns True on success"""
+        if self.stopping.is_set():
+            return False
+        name = run_name(point)
+        final = os.path.join(self.runs_dir, name + '.csv')
+        partial = final + '.partial'
+        if os.path.exists(partial):
+            os.remove(partial)
+        env = dict(os.environ)
+        lib = os.path.join(self.args.ns3_dir, 'build', 'lib')
+        env['LD_LIBRARY_PATH'] = lib + os.pathsep + env.get('LD_LIBRARY_PATH', '')
+        env['DYLD_LIBRARY_PATH'] = lib + os.pathsep + env.get('DYLD_LIBRARY_PATH', '')
+        with open(os.path.join(self.logs_dir, name + '.log'), 'w') as log:
+            child = subprocess.Popen(self.command(point, partial), stdout=log, stderr=subprocess.STDOUT,
+                                     env=env, start_new_session=True)
+            with self.lock:
+                self.children.add(child)
+            try:
+                status = child.wait(timeout=self.args.timeout or None)
+            except subprocess.TimeoutExpired:
+                os.killpg(child.pid, signal.SIGKILL)
+                status = child.wait()
+                log.write('\nbsdvr-sweep: killed after %s s\n' % self.args.timeout)
+            with self.lock:
+                self.children.discard(child)
+        ok = status == 0 and os.path.exists(partial) and os.path.getsize(partial) > 0
+        if ok:
+            os.replace(partial, final)
+        elif os.path.exists(partial):
+            os.remove(partial)
+        with self.lock:
+            self.done += 1
+            if not ok:
+                self.failed += 1
+            if not self.stopping.is_set():
+                print('[%d/%d] %s %s' % (self.done, total, name, 'done' if ok else 'FAILED (status %s)' % status),
+                      flush=True)
+        return ok
+
+    def merge(self):
+        """Rewrite sweep.csv from all finished runs, called with the lock held"""
+        header = None
+        rows = []
+        for point in self.points():
+            path = os.path.join(self.runs_dir, run_name(point) + '.csv')
+            if not os.path.exists(path):
+                continue
+            with open(path, newline='') as f:
+                lines = list(csv.reader(f))
+            if not lines:
+                continue
+            if header is None:
+                header = [column for _, _, column in ATTRIBUTES] + lines[0]
+            prefix = [point[option] for option, _, _ in ATTRIBUTES]
+            rows.extend(prefix + line for line in lines[1:])
+        if header is None:
+            return
+        # Sorted by parameters, then by node count and run
+        columns = list(range(len(ATTRIBUTES))) + [header.index('nodes'), header.index('run')]
+        rows.sort(key=lambda r: [(0, float(r[i])) if is_number(r[i]) else (1, r[i]) for i in columns])
+        tmp = self.merged + '.tmp'
+        with open(tmp, 'w', newline='') as f:
+            writer = csv.writer(f)
+            writer.writerow(header)
+            writer.writerows(rows)
+        os.replace(tmp, self.merged)
+
+    def stop(self):
+        """Kill the running simulations; their partial outputs are discarded"""
+        self.stopping.set()
+        with self.lock:
+            for child in list(self.children):
+                try:
+                    os.killpg(child.pid, signal.SIGTERM)
+                except OSError:
+                    pass
+
+    def execute(self):
+        """Run every grid point not done yet"""
+        os.makedirs(self.runs_dir, exist_ok=True)
+        os.makedirs(self.logs_dir, exist_ok=True)
+        points = self.points()
+        todo = [p for p in points if not os.path.exists(os.path.join(self.runs_dir, run_name(p) + '.csv'))]
+        print('%d runs, %d already done, %d to go on %d jobs'
+              % (len(points), len(points) - len(todo), len(todo), self.args.jobs), flush=True)
+        executor = concurrent.futures.ThreadPoolExecutor(max_workers=self.args.jobs)
+        try:
+            futures = [executor.submit(self.run, p, len(todo)) for p in todo]
+            for future in concurrent.futures.as_completed(futures):
+                future.result()
+        except KeyboardInterrupt:
+            print('\nInterrupted: stopping, finished runs are kept and skipped on resume', flush=True)
+            self.stop()
+            executor.shutdown(wait=True, cancel_futures=True)
+            with self.lock:
+                self.merge()
+            return 130
+        executor.shutdown(wait=True)
+        with self.lock:
+            self.merge()
+        print('%d runs done, %d failed; merged rows in %s' % (self.done - self.failed, self.failed, self.merged))
+        return 1 if self.failed else 0
+
+
+def is_number(text):
+    """Whether a CSV field is numeric"""
+    try:
+        float(text)
+        return True
+    except ValueError:
+        return False
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--out', required=True, help='directory of the per-run and merged CSV files')
+    parser.add_argument('--nodes', default='100', help='node counts, comma separated')
+    parser.add_argument('--runs', default='1', help='random number generator runs, such as 1-10,15')
+    parser.add_argument('--hello-interval', dest='hello_interval', default='1s', help='HelloInterval values')
+    parser.add_argument('--max-queue-len', dest='max_queue_len', default='64', help='MaxQueueLen values')
+    parser.add_argument('--max-pr-queue-len', dest='max_pr_queue_len', default='50', help='MaxPRQueueLen values')
+    parser.add_argument('--max-pr-queue-time', dest='max_pr_queue_time', default='1s',
+                        help='MaxPRQueueTime values')
+    parser.add_argument('--extra', default='', help='further bsdvr-scaling arguments, passed to every run')
+    parser.add_argument('--jobs', type=int, default=os.cpu_count() or 1,
+                        help='simulations run at once [default: the number of cores]')
+    parser.add_argument('--timeout', type=float, default=0, help='seconds after which a run is killed, 0 for none')
+    parser.add_argument('--ns3-dir', dest='ns3_dir', default='.', help='top of the ns-3 tree')
+    parser.add_argument('--program', default=None, help='bsdvr-scaling binary [default: found in the build]')
+    parser.add_argument('--dry-run', dest='dry_run', action='store_true', help='print the commands only')
+    args = parser.parse_args()
+    if args.jobs < 1:
+        parser.error('--jobs must be positive')
+    for option in ['--output=', '--nodes=', '--run=']:
+        if option in args.extra:
+            parser.error('%s is set by the sweep, not through --extra' % option.rstrip('='))
+
+    program = args.program or find_program(args.ns3_dir)
+    if program is None:
+        parser.error('no bsdvr-scaling binary under %s/build, build ns-3 or give --program' % args.ns3_dir)
+    sweep = Sweep(args, program)
+    if args.dry_run:
+        for point in sweep.points():
+            output = os.path.join(sweep.runs_dir, run_name(point) + '.csv')
+            print(' '.join(shlex.quote(a) for a in sweep.command(point, output)))
+        return 0
+    return sweep.execute()
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "bsdvr-convergence-monitor.h"
+#include "bsdvr-helper.h"
+#include "ns3/bsdvr.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BsdvrConvergenceMonitor");
+
+NS_OBJECT_ENSURE_REGISTERED (BsdvrConvergenceMonitor);
+
+TypeId
+BsdvrConvergenceMonitor::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BsdvrConvergenceMonitor")
+    .SetParent<Object> ()
+    .SetGroupName ("Bsdvr")
+    .AddConstructor<BsdvrConvergenceMonitor> ()
+    .AddAttribute ("QuiescentWindow", "Time without any forwarding table change after which the network is converged.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&BsdvrConvergenceMonitor::m_window),
+                   MakeTimeChecker ())
+    .AddTraceSource ("Converged", "No forwarding table changed for QuiescentWindow.",
+                     MakeTraceSourceAccessor (&BsdvrConvergenceMonitor::m_convergedTrace),
+                     "ns3::BsdvrConvergenceMonitor::ConvergedTracedCallback")
+    ;
+  return tid;
+}
+
+BsdvrConvergenceMonitor::BsdvrConvergenceMonitor ()
+  : m_changes (0),
+    m_converged (true)
+{
+}
+
+BsdvrConvergenceMonitor::~BsdvrConvergenceMonitor ()
+{
+}
+
+void
+BsdvrConvergenceMonitor::DoDispose ()
+{
+  m_check.Cancel ();
+  Object::DoDispose ();
+}
+
+void
+BsdvrConvergenceMonitor::Install (NodeContainer c)
+{
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<bsdvr::RoutingProtocol> bsdvr = BsdvrHelper::GetRoutingProtocol (*i);
+      NS_ASSERT_MSG (bsdvr, "BSDVR not installed on node " << (*i)->GetId ());
+      bsdvr->TraceConnectWithoutContext ("RouteChange", MakeCallback (&BsdvrConvergenceMonitor::RouteChanged, this));
+    }
+  Trigger ();
+}
+
+void
+BsdvrConvergenceMonitor::Trigger ()
+{
+  NS_LOG_FUNCTION (this);
+  m_converged = false;
+  m_trigger = Simulator::Now ();
+  m_lastChange = m_trigger;
+  m_changes = 0;
+  if (!m_check.IsRunning ())
+    {
+      m_check = Simulator::Schedule (m_window, &BsdvrConvergenceMonitor::CheckQuiescent, this);
+    }
+}
+
+bool
+BsdvrConvergenceMonitor::IsConverged () const
+{
+  return m_converged;
+}
+
+Time
+BsdvrConvergenceMonitor::GetLastConvergenceTime () const
+{
+  return m_lastConvergence;
+}
+
+void
+BsdvrConvergenceMonitor::RouteChanged (Ipv4Address dst, Ipv4Address oldNextHop, Ipv4Address newNextHop,
+                                       uint32_t hop, uint32_t state)
+{
+  if (m_converged)
+    {
+      m_converged = false;
+      m_trigger = Simulator::Now ();
+      m_changes = 0;
+    }
+  m_changes++;
+  m_lastChange = Simulator::Now ();
+  // The pending check reschedules itself, so a burst of changes costs no event churn
+  if (!m_check.IsRunning ())
+    {
+      m_check = Simulator::Schedule (m_window, &BsdvrConvergenceMonitor::CheckQuiescent, this);
+    }
+}
+
+void
+BsdvrConvergenceMonitor::CheckQuiescent ()
+{
+  Time quiet = Simulator::Now () - m_lastChange;
+  if (quiet < m_window)
+    {
+      m_check = Simulator::Schedule (m_window - quiet, &BsdvrConvergenceMonitor::CheckQuiescent, this);
+      return;
+    }
+  m_converged = true;
+  m_lastConvergence = m_lastChange - m_trigger;
+  NS_LOG_INFO ("Converged after " << m_lastConvergence.As (Time::S) << " with " << m_changes << " route changes");
+  m_convergedTrace (m_lastConvergence, m_changes);
+}
+
+}
@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef BSDVR_CONVERGENCE_MONITOR_H
+#define BSDVR_CONVERGENCE_MONITOR_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/node-container.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+/**
+ * \ingroup Bsdvr
+ * \brief Detects when the forwarding tables of a set of BSDVR nodes stop changing.
+ *
+ * The monitor listens to the RouteChange trace of every installed node. A
+ * convergence episode starts with Trigger () (Install () triggers one for
+ * startup) or with the first route change after the network was quiescent,
+ * and ends once no forwarding table has changed for QuiescentWindow. The
+ * Converged trace then reports the time from the triggering event to the last
+ * route change of the episode.
+ */
+class BsdvrConvergenceMonitor : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * TracedCallback signature for convergence events.
+   *
+   * \param [in] convergenceTime time from the triggering event to the last route change
+   * \param [in] changes number of route changes in the episode
+   */
+  typedef void (* ConvergedTracedCallback)(Time convergenceTime, uint32_t changes);
+
+  BsdvrConvergenceMonitor ();
+  virtual ~BsdvrConvergenceMonitor ();
+
+  /**
+   * Watch the BSDVR instances of a set of nodes and start a convergence episode
+   * \param c the nodes
+   */
+  void Install (NodeContainer c);
+  /**
+   * Start a convergence episode now, e.g. right after a scheduled topology change
+   */
+  void Trigger ();
+  /**
+   * \returns true if no forwarding table changed during the last episode's window
+   */
+  bool IsConverged () const;
+  /**
+   * \returns the convergence time of the last completed episode
+   */
+  Time GetLastConvergenceTime () const;
+
+protected:
+  virtual void DoDispose ();
+
+private:
+  /**
+   * RouteChange trace sink
+   * \param dst the destination
+   * \param oldNextHop the previous next hop
+   * \param newNextHop the installed next hop
+   * \param hop the installed hop count
+   * \param state the installed binary state
+   */
+  void RouteChanged (Ipv4Address dst, Ipv4Address oldNextHop, Ipv4Address newNextHop, uint32_t hop, uint32_t state);
+  /// Check whether the window elapsed without a route change
+  void CheckQuiescent ();
+
+  /// Quiet period after which the network is declared converged
+  Time m_window;
+  /// Time of the event that started the current episode
+  Time m_trigger;
+  /// Time of the last route change
+  Time m_lastChange;
+  /// Route changes in the current episode
+  uint32_t m_changes;
+  /// Whether the network is quiescent
+  bool m_converged;
+  /// Convergence time of the last completed episode
+  Time m_lastConvergence;
+  /// Quiescence check event
+  EventId m_check;
+  /// Trace fired when the network becomes quiescent
+  TracedCallback<Time, uint32_t> m_convergedTrace;
+};
+
+}
+
+#endif /* BSDVR_CONVERGENCE_MONITOR_H */
@@ -0,0 +1,408 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "bsdvr-engine-network.h"
+#include <algorithm>
+#include "ns3/bsdvr-packet.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BsdvrEngineNetwork");
+
+using namespace bsdvr;
+
+/// First node address, node i is BASE + i + 1
+static const uint32_t BASE = 0x0a000000;
+
+BsdvrEngineNetwork::BsdvrEngineNetwork (uint32_t size, uint32_t threshold)
+  : m_threshold (threshold),
+    m_links (size),
+    m_failed (size, false),
+    m_queuedReplies (0),
+    m_events (0),
+    m_messages (0),
+    m_pendingReplies (0),
+    m_replyTimeouts (0)
+{
+  NS_ABORT_MSG_IF (size > 65000, "10.0.0.0/16 holds at most 65000 nodes");
+  for (uint32_t i = 0; i < size; i++)
+    {
+      Node *n = new Node;
+      n->m_iface = Ipv4InterfaceAddress (GetAddress (i), Ipv4Mask ("255.255.0.0"));
+      n->m_engine.SetMainAddress (GetAddress (i));
+      n->m_engine.SetThreshold (threshold);
+      m_nodes.push_back (n);
+    }
+}
+
+BsdvrEngineNetwork::~BsdvrEngineNetwork ()
+{
+  for (std::vector<Node *>::iterator i = m_nodes.begin (); i != m_nodes.end (); ++i)
+    {
+      delete *i;
+    }
+}
+
+Ipv4Address
+BsdvrEngineNetwork::GetAddress (uint32_t i)
+{
+  return Ipv4Address (BASE + i + 1);
+}
+
+uint32_t
+BsdvrEngineNetwork::GetIndex (Ipv4Address address)
+{
+  return address.Get () - BASE - 1;
+}
+
+void
+BsdvrEngineNetwork::AddLink (uint32_t a, uint32_t b)
+{
+  NS_LOG_FUNCTION (this << a << b);
+  NS_ASSERT (a != b && a < m_nodes.size () && b < m_nodes.size ());
+  m_links[a].push_back (b);
+  m_links[b].push_back (a);
+}
+
+void
+BsdvrEngineNetwork::Start ()
+{
+  for (uint32_t i = 0; i < m_nodes.size (); i++)
+    {
+      for (std::vector<uint32_t>::const_iterator j = m_links[i].begin (); j != m_links[i].end (); ++j)
+        {
+          if (IsUp (i, *j))
+            {
+              Push ('U', *j, i);
+            }
+        }
+    }
+}
+
+void
+BsdvrEngineNetwork::FailLink (uint32_t a, uint32_t b)
+{
+  NS_LOG_FUNCTION (this << a << b);
+  bool up = IsUp (a, b);
+  m_down.insert (std::make_pair (std::min (a, b), std::max (a, b)));
+  if (up)
+    {
+      Push ('D', a, b);
+      Push ('D', b, a);
+    }
+}
+
+void
+BsdvrEngineNetwork::RestoreLink (uint32_t a, uint32_t b)
+{
+  NS_LOG_FUNCTION (this << a << b);
+  bool up = IsUp (a, b);
+  m_down.erase (std::make_pair (std::min (a, b), std::max (a, b)));
+  if (!up && IsUp (a, b))
+    {
+      Push ('U', a, b);
+      Push ('U', b, a);
+    }
+}
+
+void
+BsdvrEngineNetwork::FailNode (uint32_t i)
+{
+  NS_LOG_FUNCTION (this << i);
+  for (std::vector<uint32_t>::const_iterator j = m_links[i].begin (); j != m_links[i].end (); ++j)
+    {
+      if (IsUp (i, *j))
+        {
+          Push ('D', i, *j);
+          Push ('D', *j, i);
+        }
+    }
+  m_failed[i] = true;
+}
+
+void
+BsdvrEngineNetwork::RestoreNode (uint32_t i)
+{
+  NS_LOG_FUNCTION (this << i);
+  if (!m_failed[i])
+    {
+      return;
+    }
+  m_failed[i] = false;
+  for (std::vector<uint32_t>::const_iterator j = m_links[i].begin (); j != m_links[i].end (); ++j)
+    {
+      if (IsUp (i, *j))
+        {
+          Push ('U', i, *j);
+          Push ('U', *j, i);
+        }
+    }
+}
+
+void
+BsdvrEngineNetwork::InjectUpdate (uint32_t from, uint32_t to, uint32_t dst, uint32_t state)
+{
+  NS_LOG_FUNCTION (this << from << to << dst << state);
+  if (!IsUp (from, to))
+    {
+      return;
+    }
+  std::map<Ipv4Address, RoutingTableEntry> const * ft = m_nodes[from]->m_table.GetForwardingTable ();
+  std::map<Ipv4Address, RoutingTableEntry>::const_iterator rt = ft->find (GetAddress (dst));
+  Event e = { 'R', to, from, GetAddress (dst), (rt == ft->end ()) ? m_threshold : rt->second.GetHop (), state };
+  m_linkEvents.push_back (e);
+}
+
+bool
+BsdvrEngineNetwork::IsUp (uint32_t a, uint32_t b) const
+{
+  return !m_failed[a] && !m_failed[b]
+         && m_down.find (std::make_pair (std::min (a, b), std::max (a, b))) == m_down.end ();
+}
+
+void
+BsdvrEngineNetwork::Push (char type, uint32_t node, uint32_t peer)
+{
+  Event e = { type, node, peer, Ipv4Address (), 0, 0 };
+  m_linkEvents.push_back (e);
+}
+
+bool
+BsdvrEngineNetwork::Run (uint64_t maxEvents)
+{
+  EngineOutput out;
+  std::vector<EngineMessage> messages;
+  while (!m_queue.empty () || !m_linkEvents.empty () || m_queuedReplies > 0)
+    {
+      if (m_events >= maxEvents)
+        {
+          return false;
+        }
+      if (m_queue.empty ())
+        {
+          if (!m_linkEvents.empty ())
+            {
+              m_queue.push_back (m_linkEvents.front ());
+              m_linkEvents.pop_front ();
+            }
+          else
+            {
+              // The network is quiet: the pending reply timers fire
+              FireReplyTimers ();
+            }
+        }
+      Event e = m_queue.front ();
+      m_queue.pop_front ();
+      if (m_trace.is_open ())
+        {
+          Write (e);
+        }
+      Apply (e, out, messages);
+      m_events++;
+      std::map<Ipv4Address, RoutingTableEntry> const * ft = m_nodes[e.m_node]->m_table.GetForwardingTable ();
+      m_messages += messages.size ();
+      for (std::vector<EngineMessage>::const_iterator m = messages.begin (); m != messages.end (); ++m)
+        {
+          uint32_t to = GetIndex (m->m_neighbor);
+          if (!IsUp (e.m_node, to))
+            {
+              continue;
+            }
+          RoutingTableEntry const & rt = ft->find (m->m_destination)->second;
+          Event r = { 'R', to, e.m_node, m->m_destination, rt.GetHop (),
+                      uint32_t ((rt.GetRouteState () == ACTIVE) ? UPDATE_STATE_ACTIVE : UPDATE_STATE_INACTIVE) };
+          m_queue.push_back (r);
+        }
+      for (std::vector<EnginePendingReply>::const_iterator p = out.m_pendingReplies.begin ();
+           p != out.m_pendingReplies.end (); ++p)
+        {
+          // One entry per neighbor and destination, the oldest dropped on overflow
+          BsdvrPendingReplyQueue & replies = m_nodes[e.m_node]->m_replies;
+          uint32_t queued = replies.GetSize ();
+          PendingReplyEntry en (p->m_neighbor, p->m_destination);
+          if (replies.Enqueue (en))
+            {
+              m_pendingReplies++;
+              m_queuedReplies += replies.GetSize () - queued;
+            }
+        }
+    }
+  return true;
+}
+
+void
+BsdvrEngineNetwork::FireReplyTimers ()
+{
+  for (uint32_t i = 0; i < m_nodes.size (); i++)
+    {
+      for (std::vector<uint32_t>::const_iterator j = m_links[i].begin (); j != m_links[i].end (); ++j)
+        {
+          PendingReplyEntry en;
+          while (m_nodes[i]->m_replies.Dequeue (GetAddress (*j), en))
+            {
+              Event t = { 'T', i, *j, en.GetDestination (), 0, 0 };
+              m_queue.push_back (t);
+              m_queuedReplies--;
+              m_replyTimeouts++;
+            }
+        }
+    }
+  // Every neighbor of a pending reply is linked
+  NS_ASSERT (m_queuedReplies == 0);
+}
+
+void
+BsdvrEngineNetwork::Apply (Event const & e, EngineOutput & out, std::vector<EngineMessage> & messages)
+{
+  out.Clear ();
+  messages.clear ();
+  Node & n = *m_nodes[e.m_node];
+  Ipv4Address peer = GetAddress (e.m_peer);
+  switch (e.m_type)
+    {
+    case 'U':
+      {
+        // As RoutingProtocol::ProcessHello: a new link gets the whole table
+        n.m_engine.AddNeighbor (peer);
+        RoutingTableEntry link (/*device=*/ 0, /*dst=*/ peer, /*iface=*/ n.m_iface,
+                                /*hops=*/ 1, /*next hop=*/ peer, /*changedEntries*/ false);
+        if (n.m_engine.LinkUp (link, out))
+          {
+            n.m_engine.GetFullUpdate (peer, messages);
+          }
+        break;
+      }
+    case 'D':
+      n.m_engine.LinkDown (peer, out);
+      n.m_engine.GetTriggeredUpdates (out.m_changes, out.m_excluded, messages);
+      break;
+    case 'R':
+      {
+        // As RoutingProtocol::RecvUpdate
+        uint32_t hop = e.m_hop + 1;
+        if (e.m_state == UPDATE_STATE_POISONED)
+          {
+            hop = std::max<uint32_t> (hop, m_threshold + 1);
+          }
+        RoutingTableEntry rt (/*device=*/ 0, /*dst=*/ e.m_dst, /*iface=*/ n.m_iface,
+                              /*hops=*/ hop, /*next hop=*/ peer, /*changedEntries*/ false);
+        rt.SetRouteState ((e.m_state == UPDATE_STATE_ACTIVE) ? ACTIVE : INACTIVE);
+        n.m_engine.RecvUpdate (rt, peer, e.m_hop, e.m_state, out);
+        n.m_engine.GetTriggeredUpdates (out.m_changes, out.m_excluded, messages);
+        break;
+      }
+    case 'T':
+      n.m_engine.PendingReplyTimeout (peer, e.m_dst, out);
+      break;
+    default:
+      NS_FATAL_ERROR ("Unknown event type " << e.m_type);
+    }
+  messages.insert (messages.end (), out.m_replies.begin (), out.m_replies.end ());
+}
+
+bool
+BsdvrEngineNetwork::Record (std::string const & file)
+{
+  if (file.empty ())
+    {
+      return true;
+    }
+  m_trace.open (file.c_str ());
+  if (!m_trace)
+    {
+      return false;
+    }
+  m_trace << "# bsdvr-replay nodes " << m_nodes.size () << " threshold " << m_threshold << std::endl;
+  return true;
+}
+
+void
+BsdvrEngineNetwork::Write (Event const & e)
+{
+  m_trace << e.m_type << " " << GetAddress (e.m_node) << " " << GetAddress (e.m_peer);
+  if (e.m_type == 'R')
+    {
+      m_trace << " " << e.m_dst << " " << e.m_hop << " " << e.m_state;
+    }
+  else if (e.m_type == 'T')
+    {
+      m_trace << " " << e.m_dst;
+    }
+  m_trace << "\n";
+}
+
+Statistics
+BsdvrEngineNetwork::GetStatistics () const
+{
+  Statistics stats;
+  for (std::vector<Node *>::const_iterator i = m_nodes.begin (); i != m_nodes.end (); ++i)
+    {
+      stats += (*i)->m_engine.GetStatistics ();
+    }
+  stats.m_pendingReplyEnqueues += m_pendingReplies;
+  stats.m_pendingReplyExpirations += m_replyTimeouts;
+  return stats;
+}
+
+uint64_t
+BsdvrEngineNetwork::GetChecksum () const
+{
+  uint64_t h = 14695981039346656037ULL;
+  for (std::vector<Node *>::const_iterator i = m_nodes.begin (); i != m_nodes.end (); ++i)
+    {
+      std::map<Ipv4Address, RoutingTableEntry> const * ft = (*i)->m_table.GetForwardingTable ();
+      for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator e = ft->begin (); e != ft->end (); ++e)
+        {
+          uint32_t words[4] = { e->first.Get (), e->second.GetNextHop ().Get (), e->second.GetHop (),
+                                uint32_t (e->second.GetRouteState ()) };
+          for (uint32_t w = 0; w < 4; w++)
+            {
+              h = (h ^ words[w]) * 1099511628211ULL;
+            }
+        }
+    }
+  return h;
+}
+
+/**
+ * Print the route part of a dump line
+ * \param os the output stream
+ * \param dst the destination
+ * \param rt the entry
+ */
+static void
+PrintEntry (std::ostream & os, Ipv4Address dst, RoutingTableEntry const & rt)
+{
+  os << " " << BsdvrEngineNetwork::GetIndex (dst) << " " << BsdvrEngineNetwork::GetIndex (rt.GetNextHop ())
+     << " " << rt.GetHop () << " " << ((rt.GetRouteState () == ACTIVE) ? "A" : "I") << "\n";
+}
+
+void
+BsdvrEngineNetwork::Print (std::ostream & os) const
+{
+  for (uint32_t i = 0; i < m_nodes.size (); i++)
+    {
+      RoutingTable const & table = m_nodes[i]->m_table;
+      std::map<Ipv4Address, RoutingTableEntry> const * ft = table.GetForwardingTable ();
+      for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator e = ft->begin (); e != ft->end (); ++e)
+        {
+          os << i << " ft";
+          PrintEntry (os, e->first, e->second);
+        }
+      std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* > const * dvt = table.GetDistanceVectorTable ();
+      for (std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >::const_iterator ne = dvt->begin ();
+           ne != dvt->end (); ++ne)
+        {
+          for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator e = ne->second->begin ();
+               e != ne->second->end (); ++e)
+            {
+              os << i << " dvt " << GetIndex (ne->first);
+              PrintEntry (os, e->first, e->second);
+            }
+        }
+    }
+  os << "events " << m_events << " messages " << m_messages << " pending_replies " << m_pendingReplies << "\n";
+}
+
+}
@@ -0,0 +1,256 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef BSDVR_ENGINE_NETWORK_H
+#define BSDVR_ENGINE_NETWORK_H
+
+#include <deque>
+#include <fstream>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-interface-address.h"
+#include "ns3/bsdvr-rtable.h"
+#include "ns3/bsdvr-rqueue.h"
+#include "ns3/bsdvr-engine.h"
+#include "ns3/bsdvr-stats.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup Bsdvr
+ * \brief A network of bsdvr::Engine instances linked without a simulator.
+ *
+ * Every node has its own routing tables and engine, and node i has the
+ * address 10.0.0.0 + i + 1. Links are added with AddLink; Start queues the
+ * HELLO of every node, in index order, as heard by each of its neighbors;
+ * FailLink and RestoreLink queue the link events at both ends, and FailNode
+ * and RestoreNode those of all the links of a node; InjectUpdate queues an
+ * UPDATE with them. Run then
+ * processes the queued events: the UPDATEs each engine asks for are
+ * delivered in FIFO order to the neighbor engines over the links that are up,
+ * ahead of any queued link event since an UPDATE takes far less than a HELLO
+ * interval. The pending replies each engine asks for go to the
+ * BsdvrPendingReplyQueue of its node, as in RoutingProtocol, and their
+ * timers fire when no event is left: node by node, then neighbor by
+ * neighbor in link order, oldest first. The outcome
+ * only depends on the control plane, which makes the network fit for golden
+ * tests, fuzzing and trace recording.
+ */
+class BsdvrEngineNetwork
+{
+public:
+  /// One control plane event
+  struct Event
+  {
+    char m_type;         ///< 'U' link up, 'D' link down, 'R' UPDATE received, 'T' pending reply timeout
+    uint32_t m_node;     ///< index of the node the event happens at
+    uint32_t m_peer;     ///< index of the neighbor, or of the UPDATE sender
+    Ipv4Address m_dst;   ///< destination of an UPDATE or pending reply
+    uint32_t m_hop;      ///< hop count carried by an UPDATE
+    uint32_t m_state;    ///< binary state carried by an UPDATE
+  };
+
+  /**
+   * constructor
+   * \param size the number of nodes
+   * \param threshold the hop threshold
+   */
+  BsdvrEngineNetwork (uint32_t size, uint32_t threshold);
+  ~BsdvrEngineNetwork ();
+
+  /**
+   * \param i a node index
+   * \returns the address of the node
+   */
+  static Ipv4Address GetAddress (uint32_t i);
+  /**
+   * \param address a node address
+   * \returns the index of the node
+   */
+  static uint32_t GetIndex (Ipv4Address address);
+
+  /**
+   * Link two nodes, the link is up
+   * \param a a node index
+   * \param b a node index
+   */
+  void AddLink (uint32_t a, uint32_t b);
+  /**
+   * Queue the HELLO of every node, in node order, heard by all its neighbors
+   */
+  void Start ();
+  /**
+   * Fail a link and, if it was up, queue the link failure at both ends
+   * \param a a node index
+   * \param b a node index
+   */
+  void FailLink (uint32_t a, uint32_t b);
+  /**
+   * Restore a failed link and, if it is then up, queue a HELLO at both ends
+   * \param a a node index
+   * \param b a node index
+   */
+  void RestoreLink (uint32_t a, uint32_t b);
+  /**
+   * Fail a node: the failure of each of its links that is up is queued at
+   * both ends. The node keeps its tables, as one out of radio range would.
+   * \param i a node index
+   */
+  void FailNode (uint32_t i);
+  /**
+   * Restore a failed node and queue a HELLO at both ends of each of its
+   * links that is then up
+   * \param i a node index
+   */
+  void RestoreNode (uint32_t i);
+  /**
+   * Queue, with the link events, an UPDATE a node sends to a neighbor about
+   * a destination, in the given state and with the hop count of the node's
+   * FT entry, the threshold if it has none. An INACTIVE UPDATE is what the
+   * node sends when it loses its route, and may have the neighbor queue a
+   * pending reply. Nothing is queued if the link is down.
+   * \param from the index of the sending node
+   * \param to the index of the neighbor
+   * \param dst the index of the destination
+   * \param state the UpdateState carried
+   */
+  void InjectUpdate (uint32_t from, uint32_t to, uint32_t dst, uint32_t state);
+  /**
+   * \param a a node index
+   * \param b a node index
+   * \returns true unless the link between a and b or one of the nodes failed
+   */
+  bool IsUp (uint32_t a, uint32_t b) const;
+  /**
+   * \param i a node index
+   * \returns true unless the node failed
+   */
+  bool IsNodeUp (uint32_t i) const
+  {
+    return !m_failed[i];
+  }
+  /**
+   * Process queued events, then fire pending reply timers, until none is left
+   * \param maxEvents the number of processed events, since construction,
+   *        after which the run stops
+   * \returns true if the network is quiet, false if the run was stopped
+   */
+  bool Run (uint64_t maxEvents);
+
+  /**
+   * Apply an event to the engine of its node, without delivering anything
+   * \param e the event
+   * \param out the outputs, cleared first
+   * \param messages the UPDATEs the node sends for the event, cleared first
+   */
+  void Apply (Event const & e, bsdvr::EngineOutput & out, std::vector<bsdvr::EngineMessage> & messages);
+
+  /**
+   * Write every processed event to a trace file, in the bsdvr-replay format
+   * \param file the file name, no trace if empty
+   * \returns false if the file cannot be written
+   */
+  bool Record (std::string const & file);
+
+  /// \returns the number of nodes
+  uint32_t GetSize () const
+  {
+    return m_nodes.size ();
+  }
+  /**
+   * \param i a node index
+   * \returns the indices of the nodes linked to node i, up or not
+   */
+  std::vector<uint32_t> const & GetLinks (uint32_t i) const
+  {
+    return m_links[i];
+  }
+  /**
+   * \param i a node index
+   * \returns the routing tables of node i
+   */
+  bsdvr::RoutingTable const & GetRoutingTable (uint32_t i) const
+  {
+    return m_nodes[i]->m_table;
+  }
+  /// \returns the number of processed events
+  uint64_t GetEvents () const
+  {
+    return m_events;
+  }
+  /// \returns the number of UPDATEs the engines asked for, sent or not
+  uint64_t GetMessages () const
+  {
+    return m_messages;
+  }
+  /// \returns the number of pending reply entries queued
+  uint64_t GetPendingReplies () const
+  {
+    return m_pendingReplies;
+  }
+  /// \returns the counters of all engines
+  bsdvr::Statistics GetStatistics () const;
+  /// \returns an FNV-1a hash of all forwarding tables
+  uint64_t GetChecksum () const;
+  /**
+   * Print the FT and DVT of every node, one entry per line, and the counters
+   *
+   * Nodes are printed by index. FT lines are "<node> ft <dst> <next hop>
+   * <hops> A|I", DVT lines "<node> dvt <neighbor> <dst> <next hop> <hops> A|I".
+   *
+   * \param os the output stream
+   */
+  void Print (std::ostream & os) const;
+
+private:
+  /// A node: routing tables, engine and interface
+  struct Node
+  {
+    /// The RoutingProtocol defaults of MaxPRQueueLen and MaxPRQueueTime
+    Node ()
+      : m_engine (m_table),
+        m_replies (50, Seconds (1))
+    {
+    }
+    bsdvr::RoutingTable m_table;             ///< routing tables
+    bsdvr::Engine m_engine;                  ///< control plane working on m_table
+    Ipv4InterfaceAddress m_iface;            ///< interface, source of the UPDATEs
+    bsdvr::BsdvrPendingReplyQueue m_replies; ///< pending replies
+  };
+
+  /**
+   * Queue a link event
+   * \param type 'U' or 'D'
+   * \param node the node index
+   * \param peer the neighbor index
+   */
+  void Push (char type, uint32_t node, uint32_t peer);
+  /**
+   * Append an event to the trace
+   * \param e the event
+   */
+  void Write (Event const & e);
+  /**
+   * Fire the timers of all queued pending replies
+   */
+  void FireReplyTimers ();
+
+  std::vector<Node *> m_nodes;                       ///< nodes by index
+  uint32_t m_threshold;                              ///< hop threshold
+  std::vector<std::vector<uint32_t> > m_links;       ///< neighbors of each node
+  std::set<std::pair<uint32_t, uint32_t> > m_down;   ///< failed links, lower index first
+  std::vector<bool> m_failed;                        ///< failed nodes
+  std::deque<Event> m_queue;                         ///< UPDATEs to deliver
+  std::deque<Event> m_linkEvents;                    ///< link events to process
+  uint64_t m_queuedReplies;                          ///< pending reply entries queued in all nodes
+  std::ofstream m_trace;                             ///< trace file
+  uint64_t m_events;                                 ///< processed events
+  uint64_t m_messages;                               ///< UPDATEs asked for
+  uint64_t m_pendingReplies;                         ///< pending reply entries queued since construction
+  uint64_t m_replyTimeouts;                          ///< pending reply timers fired
+};
+
+}
+
+#endif /* BSDVR_ENGINE_NETWORK_H */
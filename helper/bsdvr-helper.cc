@@ -2,10 +2,12 @@
 
 #include "bsdvr-helper.h"
 #include "ns3/bsdvr.h"
+#include "ns3/bsdvr-profiler.h"
 #include "ns3/node-list.h"
 #include "ns3/names.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-list-routing.h"
+#include "ns3/simulator.h"
 
 namespace ns3 {
 
@@ -79,5 +81,172 @@ namespace ns3 {
     return (currentStream - stream);
   }
 
-}
+  Ptr<bsdvr::RoutingProtocol>
+  BsdvrHelper::GetRoutingProtocol (Ptr<Node> node)
+  {
+    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+    if (ipv4 == 0)
+      {
+        return 0;
+      }
+    Ptr<Ipv4RoutingProtocol> proto = ipv4->GetRoutingProtocol ();
+    Ptr<bsdvr::RoutingProtocol> bsdvr = DynamicCast<bsdvr::RoutingProtocol> (proto);
+    if (bsdvr)
+      {
+        return bsdvr;
+      }
+    // Bsdvr may also be in a list
+    Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting> (proto);
+    if (list)
+      {
+        int16_t priority;
+        for (uint32_t i = 0; i < list->GetNRoutingProtocols (); i++)
+          {
+            bsdvr = DynamicCast<bsdvr::RoutingProtocol> (list->GetRoutingProtocol (i, priority));
+            if (bsdvr)
+              {
+                return bsdvr;
+              }
+          }
+      }
+    return 0;
+  }
+
+  bsdvr::Statistics
+  BsdvrHelper::GetStatistics (NodeContainer c) const
+  {
+    bsdvr::Statistics total;
+    for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+      {
+        Ptr<bsdvr::RoutingProtocol> bsdvr = GetRoutingProtocol (*i);
+        if (bsdvr)
+          {
+            total += bsdvr->GetStatistics ();
+          }
+      }
+    return total;
+  }
+
+  void
+  BsdvrHelper::PrintStatistics (NodeContainer c, Ptr<OutputStreamWrapper> stream) const
+  {
+    std::ostream* os = stream->GetStream ();
+    *os << "node,";
+    bsdvr::Statistics::PrintCsvHeader (*os);
+    *os << std::endl;
+    for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+      {
+        Ptr<bsdvr::RoutingProtocol> bsdvr = GetRoutingProtocol (*i);
+        if (bsdvr)
+          {
+            *os << (*i)->GetId () << ",";
+            bsdvr->GetStatistics ().PrintCsv (*os);
+            *os << std::endl;
+          }
+      }
+  }
+
+  bsdvr::MemoryUsage
+  BsdvrHelper::GetMemoryUsage (NodeContainer c) const
+  {
+    bsdvr::MemoryUsage total;
+    for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+      {
+        Ptr<bsdvr::RoutingProtocol> bsdvr = GetRoutingProtocol (*i);
+        if (bsdvr)
+          {
+            total += bsdvr->GetMemoryUsage ();
+          }
+      }
+    return total;
+  }
+
+  void
+  BsdvrHelper::PrintMemoryUsage (NodeContainer c, Ptr<OutputStreamWrapper> stream) const
+  {
+    std::ostream* os = stream->GetStream ();
+    *os << "node,";
+    bsdvr::MemoryUsage::PrintCsvHeader (*os);
+    *os << std::endl;
+    for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+      {
+        Ptr<bsdvr::RoutingProtocol> bsdvr = GetRoutingProtocol (*i);
+        if (bsdvr)
+          {
+            *os << (*i)->GetId () << ",";
+            bsdvr->GetMemoryUsage ().PrintCsv (*os);
+            *os << std::endl;
+          }
+      }
+  }
 
+  void
+  BsdvrHelper::PrintQueueDelay (NodeContainer c, Ptr<OutputStreamWrapper> stream) const
+  {
+    std::ostream* os = stream->GetStream ();
+    bsdvr::DelayHistogram total;
+    for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+      {
+        Ptr<bsdvr::RoutingProtocol> bsdvr = GetRoutingProtocol (*i);
+        if (bsdvr)
+          {
+            *os << "Node " << (*i)->GetId () << std::endl;
+            bsdvr->GetQueueDelayHistogram ().Print (*os);
+            total += bsdvr->GetQueueDelayHistogram ();
+          }
+      }
+    *os << "All nodes" << std::endl;
+    total.Print (*os);
+  }
+
+  void
+  BsdvrHelper::DumpRoutingTableAllEvery (Time printInterval, Ptr<OutputStreamWrapper> stream,
+                                         bsdvr::TableDumpFormat format, bool includeDvt)
+  {
+    bsdvr::RoutingTable::DumpHeader (*stream->GetStream (), format);
+    Simulator::Schedule (printInterval, &BsdvrHelper::DumpEvery, printInterval, stream, format, includeDvt);
+  }
+
+  void
+  BsdvrHelper::DumpRoutingTableAllAt (Time printTime, Ptr<OutputStreamWrapper> stream,
+                                      bsdvr::TableDumpFormat format, bool includeDvt)
+  {
+    bsdvr::RoutingTable::DumpHeader (*stream->GetStream (), format);
+    Simulator::Schedule (printTime, &BsdvrHelper::DumpAll, stream, format, includeDvt);
+  }
+
+  void
+  BsdvrHelper::DumpAll (Ptr<OutputStreamWrapper> stream, bsdvr::TableDumpFormat format, bool includeDvt)
+  {
+    std::ostream* os = stream->GetStream ();
+    for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+      {
+        Ptr<bsdvr::RoutingProtocol> bsdvr = GetRoutingProtocol (*i);
+        if (bsdvr)
+          {
+            bsdvr->DumpRoutingTable (*os, format, includeDvt);
+          }
+      }
+  }
+
+  void
+  BsdvrHelper::DumpEvery (Time printInterval, Ptr<OutputStreamWrapper> stream,
+                          bsdvr::TableDumpFormat format, bool includeDvt)
+  {
+    DumpAll (stream, format, includeDvt);
+    Simulator::Schedule (printInterval, &BsdvrHelper::DumpEvery, printInterval, stream, format, includeDvt);
+  }
+
+  void
+  BsdvrHelper::PrintProfile (Ptr<OutputStreamWrapper> stream)
+  {
+    bsdvr::Profiler::Print (*stream->GetStream ());
+  }
+
+  void
+  BsdvrHelper::PrintProfileAt (Time printTime, Ptr<OutputStreamWrapper> stream)
+  {
+    Simulator::Schedule (printTime, &BsdvrHelper::PrintProfile, stream);
+  }
+
+}
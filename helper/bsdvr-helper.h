@@ -6,8 +6,16 @@
 #include "ns3/node.h"
 #include "ns3/node-container.h"
 #include "ns3/ipv4-routing-helper.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/bsdvr-stats.h"
+#include "ns3/bsdvr-rtable.h"
 
 namespace ns3 {
+
+namespace bsdvr {
+class RoutingProtocol;
+}
+
 /**
  * \ingroup Bsdvr
  * \brief Helper class that adds BSDVR routing to nodes.
@@ -57,7 +65,116 @@ public:
    */
   int64_t AssignStreams (NodeContainer c, int64_t stream);
 
+  /**
+   * Find the BSDVR instance of a node, either installed directly or
+   * as a member of an Ipv4ListRouting
+   *
+   * \param node the node
+   * \returns the BSDVR instance, or 0 if the node does not run BSDVR
+   */
+  static Ptr<bsdvr::RoutingProtocol> GetRoutingProtocol (Ptr<Node> node);
+
+  /**
+   * Sum the routing statistics of the BSDVR instances in a container
+   *
+   * \param c NodeContainer of the set of nodes to aggregate
+   * \returns the aggregated statistics
+   */
+  bsdvr::Statistics GetStatistics (NodeContainer c) const;
+
+  /**
+   * Print the routing statistics of every BSDVR node in a container as
+   * CSV, one line per node preceded by a header line
+   *
+   * \param c NodeContainer of the set of nodes to print
+   * \param stream the output stream
+   */
+  void PrintStatistics (NodeContainer c, Ptr<OutputStreamWrapper> stream) const;
+
+  /**
+   * Sum the estimated memory usage of the BSDVR instances in a container
+   *
+   * \param c NodeContainer of the set of nodes to aggregate
+   * \returns the aggregated memory usage
+   */
+  bsdvr::MemoryUsage GetMemoryUsage (NodeContainer c) const;
+
+  /**
+   * Print the estimated memory usage of every BSDVR node in a container as
+   * CSV, one line per node preceded by a header line
+   *
+   * \param c NodeContainer of the set of nodes to print
+   * \param stream the output stream
+   */
+  void PrintMemoryUsage (NodeContainer c, Ptr<OutputStreamWrapper> stream) const;
+
+  /**
+   * Print the deferred queue delay histogram of every BSDVR node in a
+   * container, followed by the histogram of all of them
+   *
+   * \param c NodeContainer of the set of nodes to print
+   * \param stream the output stream
+   */
+  void PrintQueueDelay (NodeContainer c, Ptr<OutputStreamWrapper> stream) const;
+
+  /**
+   * Write the routing tables of all BSDVR nodes into one column file at
+   * regular intervals, without the copy and formatting costs of
+   * PrintRoutingTableAllEvery. The column header is written immediately.
+   *
+   * \param printInterval the time interval between dumps
+   * \param stream the output stream, opened in binary mode for DUMP_BINARY
+   * \param format the row format
+   * \param includeDvt whether the DVT rows are written too
+   */
+  static void DumpRoutingTableAllEvery (Time printInterval, Ptr<OutputStreamWrapper> stream,
+                                        bsdvr::TableDumpFormat format = bsdvr::DUMP_CSV, bool includeDvt = false);
+  /**
+   * Write the routing tables of all BSDVR nodes into one column file at a
+   * given time. The column header is written immediately.
+   *
+   * \param printTime the time at which the tables are written
+   * \param stream the output stream, opened in binary mode for DUMP_BINARY
+   * \param format the row format
+   * \param includeDvt whether the DVT rows are written too
+   */
+  static void DumpRoutingTableAllAt (Time printTime, Ptr<OutputStreamWrapper> stream,
+                                     bsdvr::TableDumpFormat format = bsdvr::DUMP_CSV, bool includeDvt = false);
+
+  /**
+   * Write the control-plane profile of all BSDVR nodes, see
+   * bsdvr::Profiler; the counters are zero unless the module was
+   * configured with --enable-bsdvr-profiling
+   *
+   * \param stream the output stream
+   */
+  static void PrintProfile (Ptr<OutputStreamWrapper> stream);
+  /**
+   * Write the control-plane profile of all BSDVR nodes at a given time
+   *
+   * \param printTime the time at which the profile is written
+   * \param stream the output stream
+   */
+  static void PrintProfileAt (Time printTime, Ptr<OutputStreamWrapper> stream);
+
 private:
+  /**
+   * Write the routing tables of all BSDVR nodes
+   * \param stream the output stream
+   * \param format the row format
+   * \param includeDvt whether the DVT rows are written too
+   */
+  static void DumpAll (Ptr<OutputStreamWrapper> stream, bsdvr::TableDumpFormat format, bool includeDvt);
+  /**
+   * Write the routing tables of all BSDVR nodes and reschedule
+   * \param printInterval the time interval between dumps
+   * \param stream the output stream
+   * \param format the row format
+   * \param includeDvt whether the DVT rows are written too
+   */
+  static void DumpEvery (Time printInterval, Ptr<OutputStreamWrapper> stream,
+                         bsdvr::TableDumpFormat format, bool includeDvt);
+
   /** the factory to create AODV routing object */
   ObjectFactory m_agentFactory;
 };
@@ -0,0 +1,259 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "bsdvr-loop-checker.h"
+#include <algorithm>
+#include "bsdvr-helper.h"
+#include "ns3/bsdvr.h"
+#include "ns3/ipv4.h"
+#include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BsdvrLoopChecker");
+
+NS_OBJECT_ENSURE_REGISTERED (BsdvrLoopChecker);
+
+TypeId
+BsdvrLoopChecker::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BsdvrLoopChecker")
+    .SetParent<Object> ()
+    .SetGroupName ("Bsdvr")
+    .AddConstructor<BsdvrLoopChecker> ()
+    .AddAttribute ("SampleInterval", "Time between two checks of all forwarding tables.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&BsdvrLoopChecker::m_interval),
+                   MakeTimeChecker ())
+    .AddAttribute ("TrackHopIncrease", "Report ACTIVE entries whose hop count went up since the previous sample.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&BsdvrLoopChecker::m_trackHops),
+                   MakeBooleanChecker ())
+    .AddTraceSource ("Loop", "A forwarding loop was found.",
+                     MakeTraceSourceAccessor (&BsdvrLoopChecker::m_loopTrace),
+                     "ns3::BsdvrLoopChecker::LoopTracedCallback")
+    .AddTraceSource ("HopIncrease", "The hop count of an ACTIVE entry went up since the previous sample.",
+                     MakeTraceSourceAccessor (&BsdvrLoopChecker::m_hopIncreaseTrace),
+                     "ns3::BsdvrLoopChecker::HopIncreaseTracedCallback")
+    ;
+  return tid;
+}
+
+BsdvrLoopChecker::BsdvrLoopChecker ()
+  : m_trackHops (true),
+    m_samples (0),
+    m_loops (0),
+    m_hopIncreases (0),
+    m_maxStreak (0)
+{
+}
+
+BsdvrLoopChecker::~BsdvrLoopChecker ()
+{
+}
+
+void
+BsdvrLoopChecker::DoDispose ()
+{
+  m_sample.Cancel ();
+  m_nodes.clear ();
+  m_protocols.clear ();
+  Object::DoDispose ();
+}
+
+void
+BsdvrLoopChecker::Install (NodeContainer c, Time start)
+{
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<bsdvr::RoutingProtocol> bsdvr = BsdvrHelper::GetRoutingProtocol (*i);
+      NS_ASSERT_MSG (bsdvr, "BSDVR not installed on node " << (*i)->GetId ());
+      m_nodes.push_back (*i);
+      m_protocols.push_back (bsdvr);
+    }
+  m_sample.Cancel ();
+  m_sample = Simulator::Schedule (start, &BsdvrLoopChecker::Sample, this);
+}
+
+void
+BsdvrLoopChecker::Sample ()
+{
+  Check ();
+  m_sample = Simulator::Schedule (m_interval, &BsdvrLoopChecker::Sample, this);
+}
+
+void
+BsdvrLoopChecker::IndexAddresses ()
+{
+  m_owner.clear ();
+  for (uint32_t n = 0; n < m_nodes.size (); n++)
+    {
+      Ptr<Ipv4> ipv4 = m_nodes[n]->GetObject<Ipv4> ();
+      for (uint32_t i = 0; i < ipv4->GetNInterfaces (); i++)
+        {
+          for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++)
+            {
+              Ipv4Address local = ipv4->GetAddress (i, j).GetLocal ();
+              if (!local.IsLocalhost ())
+                {
+                  m_owner[local] = n;
+                }
+            }
+        }
+    }
+}
+
+uint32_t
+BsdvrLoopChecker::Check ()
+{
+  IndexAddresses ();
+  std::set<Ipv4Address> destinations;
+  for (uint32_t n = 0; n < m_protocols.size (); n++)
+    {
+      std::map<Ipv4Address, bsdvr::RoutingTableEntry> const * ft = m_protocols[n]->GetRoutingTable ().GetForwardingTable ();
+      for (std::map<Ipv4Address, bsdvr::RoutingTableEntry>::const_iterator i = ft->begin (); i != ft->end (); ++i)
+        {
+          if (m_owner.find (i->first) != m_owner.end ())
+            {
+              destinations.insert (i->first);
+            }
+        }
+      if (m_trackHops)
+        {
+          TrackHops (n);
+        }
+    }
+  uint32_t loops = 0;
+  for (std::set<Ipv4Address>::const_iterator d = destinations.begin (); d != destinations.end (); ++d)
+    {
+      loops += CheckDestination (*d);
+    }
+  m_samples++;
+  m_loops += loops;
+  NS_LOG_INFO ("Sample " << m_samples << ": " << destinations.size () << " destinations, " << loops << " loops");
+  return loops;
+}
+
+uint32_t
+BsdvrLoopChecker::CheckDestination (Ipv4Address dst)
+{
+  enum Mark
+  {
+    UNVISITED = 0,
+    ON_PATH = 1,
+    DONE = 2
+  };
+  uint32_t owner = m_owner.find (dst)->second;
+  uint32_t loops = 0;
+  std::vector<uint8_t> mark (m_nodes.size (), UNVISITED);
+  std::vector<uint32_t> path;
+  for (uint32_t start = 0; start < m_nodes.size (); start++)
+    {
+      uint32_t cur = start;
+      bool looped = false;
+      path.clear ();
+      while (mark[cur] != DONE)
+        {
+          if (mark[cur] == ON_PATH)
+            {
+              // The walk came back to a node of its own path
+              looped = true;
+              break;
+            }
+          mark[cur] = ON_PATH;
+          path.push_back (cur);
+          if (cur == owner)
+            {
+              break;
+            }
+          std::map<Ipv4Address, bsdvr::RoutingTableEntry> const * ft = m_protocols[cur]->GetRoutingTable ().GetForwardingTable ();
+          std::map<Ipv4Address, bsdvr::RoutingTableEntry>::const_iterator e = ft->find (dst);
+          if (e == ft->end () || e->second.GetRouteState () != bsdvr::ACTIVE)
+            {
+              break;
+            }
+          std::map<Ipv4Address, uint32_t>::const_iterator next = m_owner.find (e->second.GetNextHop ());
+          if (next == m_owner.end ())
+            {
+              break;
+            }
+          cur = next->second;
+        }
+      if (looped)
+        {
+          uint32_t length = path.end () - std::find (path.begin (), path.end (), cur);
+          NS_LOG_WARN ("Loop of " << length << " nodes towards " << dst << " through node " << m_nodes[cur]->GetId ());
+          m_loopTrace (dst, m_nodes[cur]->GetId (), length);
+          m_loopDestinations.insert (dst);
+          loops++;
+        }
+      for (std::vector<uint32_t>::const_iterator p = path.begin (); p != path.end (); ++p)
+        {
+          mark[*p] = DONE;
+        }
+    }
+  return loops;
+}
+
+void
+BsdvrLoopChecker::TrackHops (uint32_t index)
+{
+  uint32_t nodeId = m_nodes[index]->GetId ();
+  std::map<Ipv4Address, bsdvr::RoutingTableEntry> const * ft = m_protocols[index]->GetRoutingTable ().GetForwardingTable ();
+  for (std::map<Ipv4Address, bsdvr::RoutingTableEntry>::const_iterator i = ft->begin (); i != ft->end (); ++i)
+    {
+      std::pair<uint32_t, Ipv4Address> key (index, i->first);
+      if (i->second.GetRouteState () != bsdvr::ACTIVE)
+        {
+          m_hops.erase (key);
+          continue;
+        }
+      uint32_t hop = i->second.GetHop ();
+      std::map<std::pair<uint32_t, Ipv4Address>, HopHistory>::iterator h = m_hops.find (key);
+      if (h == m_hops.end ())
+        {
+          HopHistory history;
+          history.m_hop = hop;
+          history.m_streak = 0;
+          m_hops.insert (std::make_pair (key, history));
+          continue;
+        }
+      if (hop > h->second.m_hop)
+        {
+          h->second.m_streak++;
+          m_hopIncreases++;
+          m_maxStreak = std::max (m_maxStreak, h->second.m_streak);
+          m_hopIncreaseTrace (nodeId, i->first, h->second.m_hop, hop, h->second.m_streak);
+        }
+      else
+        {
+          h->second.m_streak = 0;
+        }
+      h->second.m_hop = hop;
+    }
+}
+
+uint64_t
+BsdvrLoopChecker::GetLoopCount () const
+{
+  return m_loops;
+}
+
+void
+BsdvrLoopChecker::PrintSummary (std::ostream & os) const
+{
+  os << "BSDVR loop check: " << m_samples << " samples of " << m_nodes.size () << " nodes" << std::endl
+     << "Loops " << m_loops << " over " << m_loopDestinations.size () << " destinations" << std::endl;
+  for (std::set<Ipv4Address>::const_iterator d = m_loopDestinations.begin (); d != m_loopDestinations.end (); ++d)
+    {
+      os << "  " << *d << std::endl;
+    }
+  if (m_trackHops)
+    {
+      os << "HopIncreases " << m_hopIncreases << ", longest streak " << m_maxStreak << std::endl;
+    }
+}
+
+}
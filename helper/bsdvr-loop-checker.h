@@ -0,0 +1,144 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef BSDVR_LOOP_CHECKER_H
+#define BSDVR_LOOP_CHECKER_H
+
+#include <map>
+#include <set>
+#include <vector>
+#include <ostream>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/node-container.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+namespace bsdvr {
+class RoutingProtocol;
+}
+
+/**
+ * \ingroup Bsdvr
+ * \brief Global check of the forwarding tables for loops and growing hop counts.
+ *
+ * At every sample the checker follows, for each destination, the ACTIVE next
+ * hops of all installed nodes and reports every forwarding loop found. With
+ * TrackHopIncrease it also remembers the hop count of every ACTIVE entry and
+ * reports entries whose hop count went up since the previous sample, with the
+ * number of consecutive increases; a long streak is the signature of
+ * count-to-infinity.
+ */
+class BsdvrLoopChecker : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * TracedCallback signature for forwarding loops.
+   *
+   * \param [in] dst the destination
+   * \param [in] nodeId a node on the loop
+   * \param [in] length the number of nodes on the loop
+   */
+  typedef void (* LoopTracedCallback)(Ipv4Address dst, uint32_t nodeId, uint32_t length);
+  /**
+   * TracedCallback signature for hop count increases.
+   *
+   * \param [in] nodeId the node
+   * \param [in] dst the destination
+   * \param [in] oldHop the hop count at the previous sample
+   * \param [in] newHop the current hop count
+   * \param [in] streak the number of consecutive samples with an increase
+   */
+  typedef void (* HopIncreaseTracedCallback)(uint32_t nodeId, Ipv4Address dst, uint32_t oldHop, uint32_t newHop, uint32_t streak);
+
+  BsdvrLoopChecker ();
+  virtual ~BsdvrLoopChecker ();
+
+  /**
+   * Check the BSDVR instances of a set of nodes every SampleInterval
+   * \param c the nodes
+   * \param start the time of the first sample
+   */
+  void Install (NodeContainer c, Time start);
+  /**
+   * Sample all forwarding tables now
+   * \returns the number of loops found
+   */
+  uint32_t Check ();
+  /**
+   * Print the totals over all samples so far
+   * \param os the output stream
+   */
+  void PrintSummary (std::ostream & os) const;
+  /**
+   * \returns the number of loops found over all samples
+   */
+  uint64_t GetLoopCount () const;
+
+protected:
+  virtual void DoDispose ();
+
+private:
+  /// Sample and reschedule
+  void Sample ();
+  /// Map every non-loopback interface address to its node index
+  void IndexAddresses ();
+  /**
+   * Follow the next hops of all nodes towards one destination
+   * \param dst the destination
+   * \returns the number of loops found
+   */
+  uint32_t CheckDestination (Ipv4Address dst);
+  /**
+   * Compare the hop counts of one node with the previous sample
+   * \param index the node index
+   */
+  void TrackHops (uint32_t index);
+
+  /// Hop count history of one FT entry
+  struct HopHistory
+  {
+    uint32_t m_hop;     ///< hop count at the previous sample
+    uint32_t m_streak;  ///< consecutive samples with an increase
+  };
+
+  /// Time between samples
+  Time m_interval;
+  /// Whether hop count increases are tracked
+  bool m_trackHops;
+  /// Checked nodes
+  std::vector<Ptr<Node> > m_nodes;
+  /// BSDVR instances of the checked nodes
+  std::vector<Ptr<bsdvr::RoutingProtocol> > m_protocols;
+  /// Interface address to node index
+  std::map<Ipv4Address, uint32_t> m_owner;
+  /// Hop count history, map (node index, destination) -> history
+  std::map<std::pair<uint32_t, Ipv4Address>, HopHistory> m_hops;
+  /// Sample event
+  EventId m_sample;
+  /// Samples taken
+  uint64_t m_samples;
+  /// Loops found
+  uint64_t m_loops;
+  /// Destinations with at least one loop
+  std::set<Ipv4Address> m_loopDestinations;
+  /// Hop count increases found
+  uint64_t m_hopIncreases;
+  /// Longest streak of hop count increases
+  uint32_t m_maxStreak;
+  /// Trace of forwarding loops
+  TracedCallback<Ipv4Address, uint32_t, uint32_t> m_loopTrace;
+  /// Trace of hop count increases
+  TracedCallback<uint32_t, Ipv4Address, uint32_t, uint32_t, uint32_t> m_hopIncreaseTrace;
+};
+
+}
+
+#endif /* BSDVR_LOOP_CHECKER_H */
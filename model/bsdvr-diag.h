@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef BSDVRDIAG_H
+#define BSDVRDIAG_H
+
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup bsdvr
+ * Structured diagnostics of the BSDVR control plane.
+ *
+ * A diagnostic is logged through NS_LOG and reported to the Diagnostic trace
+ * source of the RoutingProtocol. BSDVR_DIAG_LEVEL selects at compile time
+ * which diagnostics exist at all: 0 none, 1 errors, 2 warnings, 3 info.
+ * It defaults to 3 where NS_LOG is enabled and to 0 otherwise, so optimized
+ * builds contain no diagnostic code; ./waf configure --bsdvr-diag-level
+ * overrides it.
+ */
+
+#ifndef BSDVR_DIAG_LEVEL
+#ifdef NS3_LOG_ENABLE
+#define BSDVR_DIAG_LEVEL 3
+#else
+#define BSDVR_DIAG_LEVEL 0
+#endif
+#endif
+
+namespace ns3 {
+namespace bsdvr {
+
+/**
+ * \ingroup bsdvr
+ * \brief Diagnostic severities
+ */
+enum DiagLevel
+{
+  DIAG_ERROR = 1,   //!< ERROR
+  DIAG_WARN = 2,    //!< WARN
+  DIAG_INFO = 3,    //!< INFO
+};
+
+/**
+ * \ingroup bsdvr
+ * \brief Diagnostic events
+ */
+enum DiagEvent
+{
+  DIAG_PENDING_REPLY_IMMEDIATE = 0,  //!< pending reply sent on receipt of an INACTIVE UPDATE
+  DIAG_PENDING_REPLY_QUEUED = 1,     //!< pending reply entry queued
+  DIAG_PENDING_REPLY_TIMEOUT = 2,    //!< pending reply sent on timer expiry
+  DIAG_TABLE_EXCEPTION = 3,          //!< exception while updating the DVT or FT
+};
+
+}  // namespace bsdvr
+}  // namespace ns3
+
+/**
+ * Report a diagnostic from a RoutingProtocol or Engine member function
+ * \param event the DiagEvent
+ * \param peer the neighbor involved
+ * \param dst the destination involved
+ * \param msg the NS_LOG message
+ */
+#if BSDVR_DIAG_LEVEL >= 1
+#define BSDVR_DIAG_ERROR(event, peer, dst, msg)                         \
+  do                                                                    \
+    {                                                                   \
+      NS_LOG_ERROR (msg);                                               \
+      ReportDiagnostic (ns3::bsdvr::DIAG_ERROR, event, peer, dst);      \
+    }                                                                   \
+  while (false)
+#else
+#define BSDVR_DIAG_ERROR(event, peer, dst, msg)
+#endif
+
+/// \copydoc BSDVR_DIAG_ERROR
+#if BSDVR_DIAG_LEVEL >= 2
+#define BSDVR_DIAG_WARN(event, peer, dst, msg)                          \
+  do                                                                    \
+    {                                                                   \
+      NS_LOG_WARN (msg);                                                \
+      ReportDiagnostic (ns3::bsdvr::DIAG_WARN, event, peer, dst);       \
+    }                                                                   \
+  while (false)
+#else
+#define BSDVR_DIAG_WARN(event, peer, dst, msg)
+#endif
+
+/// \copydoc BSDVR_DIAG_ERROR
+#if BSDVR_DIAG_LEVEL >= 3
+#define BSDVR_DIAG_INFO(event, peer, dst, msg)                          \
+  do                                                                    \
+    {                                                                   \
+      NS_LOG_INFO (msg);                                                \
+      ReportDiagnostic (ns3::bsdvr::DIAG_INFO, event, peer, dst);       \
+    }                                                                   \
+  while (false)
+#else
+#define BSDVR_DIAG_INFO(event, peer, dst, msg)
+#endif
+
+#endif /* BSDVRDIAG_H */
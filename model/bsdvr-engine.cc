@@ -0,0 +1,509 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "bsdvr-engine.h"
+#include <algorithm>
+#include "bsdvr-profiler.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BsdvrEngine");
+
+namespace bsdvr {
+
+void
+EngineOutput::Clear ()
+{
+  m_changes.clear ();
+  m_excluded.clear ();
+  m_replies.clear ();
+  m_pendingReplies.clear ();
+  m_routeChanges.clear ();
+}
+
+Engine::Engine (RoutingTable & table)
+  : m_table (table),
+    m_threshold (bsdvr::constants::BSDVR_THRESHOLD),
+    m_recordRouteChanges (false)
+{
+}
+
+void
+Engine::AddNeighbor (Ipv4Address ne)
+{
+  if (!IsNeighbor (ne))
+    {
+      m_neighbors.push_back (ne);
+    }
+}
+
+void
+Engine::RemoveNeighbor (Ipv4Address ne)
+{
+  m_neighbors.erase (std::remove (m_neighbors.begin (), m_neighbors.end (), ne), m_neighbors.end ());
+}
+
+bool
+Engine::IsNeighbor (Ipv4Address ne) const
+{
+  /// FIXME: Improve search in neighbor vector
+  return std::find (m_neighbors.begin (), m_neighbors.end (), ne) != m_neighbors.end ();
+}
+
+void
+Engine::ReportDiagnostic (DiagLevel level, DiagEvent event, Ipv4Address peer, Ipv4Address dst)
+{
+  if (!m_diagnostic.IsNull ())
+    {
+      m_diagnostic (level, event, peer, dst);
+    }
+}
+
+/*
+ BSDVR Events
+ */
+
+bool
+Engine::LinkUp (RoutingTableEntry const & link, EngineOutput & out)
+{
+  Ipv4Address origin = link.GetDestination ();
+  NS_LOG_FUNCTION (this << origin);
+  /*
+   *  Whenever a node receives a Hello message from a neighbor, the node
+   * SHOULD make sure that it has an active route to the neighbor, and
+   * create one if necessary in dvt.
+   */
+  RoutingTableEntry toNeighbor;
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >* dvt = m_table.GetDistanceVectorTable ();
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >::iterator dvt_iter = dvt->find (origin);
+  if (dvt_iter == dvt->end ())
+    {
+      dvt_iter = dvt->insert (std::make_pair (origin, new std::map<Ipv4Address, RoutingTableEntry> ())).first;
+    }
+  std::map<Ipv4Address, RoutingTableEntry>* dv = dvt_iter->second; // neighbor node's dv
+  if (!m_table.LookupRoute (origin, toNeighbor, dv))
+    {
+      RoutingTableEntry newEntry = link;
+      m_table.AddRoute (newEntry, dv);
+      ComputeForwardingTable (out);
+      return true;
+    }
+  toNeighbor.SetOutputDevice (link.GetOutputDevice ());
+  toNeighbor.SetInterface (link.GetInterface ());
+  toNeighbor.SetHop (1);
+  toNeighbor.SetNextHop (origin);
+  m_table.Update (toNeighbor, dv);
+  return false;
+}
+
+void
+Engine::LinkDown (Ipv4Address ne, EngineOutput & out)
+{
+  NS_LOG_FUNCTION (this << ne);
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>*>* dvt = m_table.GetDistanceVectorTable ();
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>*>::iterator n_dvt = dvt->find (ne);
+  if (n_dvt != dvt->end ())
+    {
+      std::map<Ipv4Address, RoutingTableEntry>::iterator n_dvt_entry = n_dvt->second->find (ne);
+      if (n_dvt_entry != n_dvt->second->end ())
+        {
+          out.m_excluded.push_back (ne);
+          RoutingTableEntry rt = n_dvt_entry->second;
+          rt.SetRouteState (INACTIVE);
+          UpdateDistanceVectorTable (ne, rt);
+          ComputeForwardingTable (out);
+        }
+    }
+  // The neighbor still takes part in the computation above, as it did while
+  // Neighbors was closing the link
+  RemoveNeighbor (ne);
+}
+
+void
+Engine::RecvUpdate (RoutingTableEntry & rt, Ipv4Address origin, uint32_t hopCount, uint32_t state,
+                    EngineOutput & out)
+{
+  NS_LOG_FUNCTION (this << rt.GetNextHop () << rt.GetDestination ());
+  Ipv4Address dst = rt.GetDestination ();
+  UpdateDistanceVectorTable (rt.GetNextHop (), rt);
+  ComputeForwardingTable (out);
+  if (state == 0 && dst != origin)
+    {
+      RetransmitToNeighbor (origin, dst, hopCount, out);
+    }
+}
+
+void
+Engine::PendingReplyTimeout (Ipv4Address ne, Ipv4Address dst, EngineOutput & out)
+{
+  /// FIXME: make filter upper bound dynamic for variable number of nodes in the network
+  if ((Ipv4Address ("10.1.1.0") < ne) && (ne) < Ipv4Address ("10.1.1.51"))
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this << "Sending pending reply to " << ne << " for destination " << dst);
+  std::map<Ipv4Address, RoutingTableEntry>* ft = m_table.GetForwardingTable ();
+  std::map<Ipv4Address, RoutingTableEntry>::iterator dst_find = ft->find (dst);
+  // Checking if neighbor still active and dst entry available in ft
+  if (dst_find != ft->end () && IsNeighbor (ne))
+    {
+      if (dst_find->second.GetRouteState () == ACTIVE && dst_find->second.GetNextHop () != ne)
+        {
+          // sending pending reply to neighbor
+          BSDVR_DIAG_INFO (DIAG_PENDING_REPLY_TIMEOUT, ne, dst,
+                           "Sending Update to " << ne << " after expiry of pending reply timer");
+          EngineMessage m = { ne, dst };
+          out.m_replies.push_back (m);
+        }
+    }
+}
+
+/*
+ BSDVR Control Plane Functions
+ */
+
+bool
+Engine::IsBetterRoute (RoutingTableEntry const & r1, RoutingTableEntry const & r2) const
+{
+  if (m_threshold == bsdvr::constants::BSDVR_THRESHOLD)
+    {
+      return RouteComparator<DefaultThreshold> () (r1, r2);
+    }
+  return RouteComparator<DynamicThreshold> (DynamicThreshold (m_threshold)) (r1, r2);
+}
+
+void
+Engine::RemoveFakeRoutes (Ipv4Address nxtHp, RoutingTableEntry & rt)
+{
+  BSDVR_PROFILE_SCOPE (REMOVE_FAKE_ROUTES);
+  Ipv4Address curr_dst;
+  Ipv4Address curr_nxtHp;
+  RouteState curr_state;
+  std::list<Ipv4Address> fake_dsts;
+  Ipv4Address dst = rt.GetDestination ();
+  std::map<Ipv4Address, RoutingTableEntry> *ft = m_table.GetForwardingTable ();
+  // The neighbor check does not depend on the entry, hoist it out of the scan
+  bool viaNeighbor = (nxtHp == dst) && IsNeighbor (nxtHp);
+  if (rt.GetRouteState () == INACTIVE)
+    {
+      for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = ft->begin (); i != ft->end (); i++)
+        {
+          curr_dst = i->first;
+          curr_nxtHp = i->second.GetNextHop ();
+          curr_state = i->second.GetRouteState ();
+          if (curr_state == ACTIVE)
+            {
+              if (nxtHp == curr_nxtHp && dst == curr_dst)
+                {
+                  fake_dsts.push_back (curr_dst);
+                }
+              /// TODO: Confirm if neighbor check works right
+              if (viaNeighbor && curr_nxtHp == nxtHp && dst != curr_dst)
+                {
+                  fake_dsts.push_back (curr_dst);
+                }
+            }
+        }
+    }
+  if (fake_dsts.empty ())
+    {
+      return;
+    }
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* > *dvt = m_table.GetDistanceVectorTable ();
+  for (std::vector<Ipv4Address>::const_iterator i = m_neighbors.begin (); i != m_neighbors.end (); ++i)
+    {
+      std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >::iterator n_dvt = dvt->find (*i);
+      if (n_dvt == dvt->end ())
+        {
+          continue;
+        }
+      std::map<Ipv4Address, RoutingTableEntry>* n_dvt_entries = n_dvt->second;
+      for (std::list<Ipv4Address>::const_iterator k = fake_dsts.begin (); k != fake_dsts.end (); ++k)
+        {
+          if (n_dvt_entries->find (*k) != n_dvt_entries->end () && *i != (*ft)[*k].GetNextHop ())
+            {
+              n_dvt_entries->erase (*k);
+            }
+        }
+    }
+}
+
+void
+Engine::UpdateDistanceVectorTable (Ipv4Address nxtHp, RoutingTableEntry & rt)
+{
+  BSDVR_PROFILE_SCOPE (UPDATE_DISTANCE_VECTOR_TABLE);
+  Ipv4Address dst = rt.GetDestination ();
+  // Tables
+  std::map<Ipv4Address, RoutingTableEntry> *ft = m_table.GetForwardingTable ();
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* > *dvt = m_table.GetDistanceVectorTable ();
+
+  if (ft->find (dst) != ft->end ())
+    {
+      try
+      {
+        RemoveFakeRoutes (nxtHp, rt);
+      }
+      catch(const std::exception& e)
+      {
+        BSDVR_DIAG_ERROR (DIAG_TABLE_EXCEPTION, nxtHp, dst, "RemoveFakeRoutes: " << e.what ());
+      }
+    }
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >::iterator n_dvt = dvt->find (nxtHp);
+  if (n_dvt != dvt->end () && IsNeighbor (nxtHp))
+    {
+      /// NOTE: Assuming all neighbor hopCounts to be 1 so entries won't change will link quality
+      // Do nothing
+      return;
+    }
+  /// NOTE: As link quality is assumed constant, no total-cost calc. performed and
+  //check against THRESHOLD value to skip total-cost calc.
+  if (n_dvt == dvt->end ())
+    {
+      n_dvt = dvt->insert (std::make_pair (nxtHp, new std::map<Ipv4Address, RoutingTableEntry> ())).first;
+    }
+  (*n_dvt->second)[dst] = rt;
+}
+
+void
+Engine::RefreshForwardingTable (Ipv4Address dst, Ipv4Address nxtHp)
+{
+  // Tables
+  std::map<Ipv4Address, RoutingTableEntry> *ft = m_table.GetForwardingTable ();
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* > *dvt = m_table.GetDistanceVectorTable ();
+
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >::iterator n_dvt = dvt->find (nxtHp);
+  if (n_dvt != dvt->end ())
+    {
+      std::map<Ipv4Address, RoutingTableEntry>::iterator n_dvt_entry = n_dvt->second->find (dst);
+      if (n_dvt_entry != n_dvt->second->end ())
+        {
+          (*ft)[dst] = n_dvt_entry->second;
+        }
+    }
+  else
+    {
+      (*ft)[dst].SetRouteState (INACTIVE);
+    }
+}
+
+void
+Engine::ComputeForwardingTable (EngineOutput & out)
+{
+  BSDVR_PROFILE_SCOPE (COMPUTE_FORWARDING_TABLE);
+  m_stats.m_ftComputations++;
+  std::list<Ipv4Address>::size_type before = out.m_changes.size ();
+  // Select the comparator once, outside of the per-entry loop
+  if (m_threshold == bsdvr::constants::BSDVR_THRESHOLD)
+    {
+      DoComputeForwardingTable (RouteComparator<DefaultThreshold> (), out);
+    }
+  else
+    {
+      DoComputeForwardingTable (RouteComparator<DynamicThreshold> (DynamicThreshold (m_threshold)), out);
+    }
+  m_stats.m_ftChanges += out.m_changes.size () - before;
+}
+
+template <class Comparator>
+void
+Engine::DoComputeForwardingTable (Comparator const & isBetter, EngineOutput & out)
+{
+  Ipv4Address curr_nxtHp;
+  RoutingTableEntry old_entry;
+  RoutingTableEntry new_entry;
+  RoutingTableEntry curr_entry;
+  std::list<Ipv4Address> changes;
+  // Tables
+  std::map<Ipv4Address, RoutingTableEntry> *ft = m_table.GetForwardingTable ();
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* > *dvt = m_table.GetDistanceVectorTable ();
+  // Iterators
+  std::list<Ipv4Address>::iterator c;
+  std::map<Ipv4Address, RoutingTableEntry>::iterator ft_entry;
+  std::map<Ipv4Address, RoutingTableEntry>::iterator n_dvt_entry;
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >::iterator n_dvt_entries_find;
+  for (std::vector<Ipv4Address>::const_iterator i = m_neighbors.begin ();
+       i != m_neighbors.end (); ++i)
+      {
+        n_dvt_entries_find = dvt->find (*i);
+        if (n_dvt_entries_find != dvt->end ())
+          {
+            std::map<Ipv4Address, RoutingTableEntry>* n_dvt_entries = n_dvt_entries_find->second;
+            for (n_dvt_entry = n_dvt_entries->begin (); n_dvt_entry != n_dvt_entries->end (); n_dvt_entry++)
+            {
+              m_stats.m_destinationsEvaluated++;
+              ft_entry = ft->find (n_dvt_entry->first);
+              if (ft_entry != ft->end ())
+                {
+                  try
+                  {
+                    curr_nxtHp = ft_entry->second.GetNextHop ();
+                    old_entry = ft_entry->second;
+                    RefreshForwardingTable (n_dvt_entry->first, curr_nxtHp);
+                    new_entry = n_dvt_entry->second;
+                    curr_entry = ft_entry->second;
+                    if (isBetter (new_entry, curr_entry))
+                      {
+                        ft_entry->second = new_entry;
+                        c = std::find(changes.begin (), changes.end (), n_dvt_entry->first);
+                        if (c != changes.end ())
+                          {
+                            changes.push_back (n_dvt_entry->first);
+                          }
+                      }
+                    else if ((curr_entry.GetHop () != old_entry.GetHop ()) || (curr_entry.GetRouteState () != old_entry.GetRouteState ()))
+                      {
+                        c = std::find(changes.begin (), changes.end (), n_dvt_entry->first);
+                        if (c != changes.end ())
+                          {
+                            changes.push_back (n_dvt_entry->first);
+                          }
+                      }
+                  }
+                  catch(const std::exception& e)
+                  {
+                    BSDVR_DIAG_ERROR (DIAG_TABLE_EXCEPTION, *i, n_dvt_entry->first,
+                                      "ComputeForwardingTable: " << e.what ());
+                  }
+                  if (m_recordRouteChanges && n_dvt_entry->first != m_mainAddress)
+                    {
+                      RoutingTableEntry const & installed = ft_entry->second;
+                      if (installed.GetNextHop () != curr_nxtHp || installed.GetHop () != old_entry.GetHop ()
+                          || installed.GetRouteState () != old_entry.GetRouteState ())
+                        {
+                          EngineRouteChange change = { curr_nxtHp, installed };
+                          out.m_routeChanges.push_back (change);
+                        }
+                    }
+                }
+              else
+                {
+                  new_entry = n_dvt_entry->second;
+                  (*ft)[n_dvt_entry->first] = new_entry;
+                  changes.push_back (n_dvt_entry->first);
+                  if (m_recordRouteChanges && n_dvt_entry->first != m_mainAddress)
+                    {
+                      EngineRouteChange change = { Ipv4Address (), new_entry };
+                      out.m_routeChanges.push_back (change);
+                    }
+                }
+            }
+          }
+      }
+  changes.remove (m_mainAddress);
+  out.m_changes.splice (out.m_changes.end (), changes);
+}
+
+void
+Engine::RetransmitToNeighbor (Ipv4Address origin, Ipv4Address dst, uint32_t hopCount, EngineOutput & out)
+{
+  BSDVR_PROFILE_SCOPE (RETRANSMIT_TO_NEIGHBOR);
+  Ipv4Address nxtHp;
+  Ipv4Address ne = origin;
+  NS_LOG_FUNCTION (this << ne);
+  std::map<Ipv4Address, RoutingTableEntry>* ft = m_table.GetForwardingTable ();
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>*>* dvt = m_table.GetDistanceVectorTable ();
+  // Iterators
+  std::map<Ipv4Address, RoutingTableEntry>::iterator dst_find;
+  std::map<Ipv4Address, RoutingTableEntry>::iterator dv_entry;
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>*>::iterator n_dvt_find;
+  // Retransmission params
+  u_int32_t c1, c2, c3, c5, l2;
+  /// FIXME: make filter upper bound dynamic for variable number of nodes in the network
+  if ((Ipv4Address ("10.1.1.0") < ne) && (ne) < Ipv4Address ("10.1.1.51"))
+    {
+      return;
+    }
+  dst_find = ft->find (dst);
+  // Checking if neighbor still active and dst entry available in ft
+  if (dst_find != ft->end () && IsNeighbor (ne))
+    {
+      // cost for reaching ne from current nxtHp for dst in ft
+      c5 = 0;
+      nxtHp = dst_find->second.GetNextHop ();
+      if (dst_find->second.GetRouteState () == ACTIVE && nxtHp != ne)
+        {
+          n_dvt_find = dvt->find (nxtHp);
+          if (n_dvt_find != dvt->end ())
+            {
+              dv_entry = n_dvt_find->second->find (ne);
+              if (dv_entry != n_dvt_find->second->end ())
+                {
+                  c5 = dv_entry->second.GetHop ();
+                }
+            }
+          // cost for reaching dst at ne
+          c2 = hopCount;
+          // cost for reaching dst at ne
+          l2 = 1;
+          // cost for reaching current nxtHp for dst
+          c1 = dst_find->second.GetHop ();
+          // cost for reaching dst at nxtHp
+          c3 = c1 - l2;
+          if ((c3 == 0) || (c5 == c2+c3))
+            {
+              // send immediate reply
+              BSDVR_DIAG_INFO (DIAG_PENDING_REPLY_IMMEDIATE, ne, dst, "Send pending reply immediately to " << ne);
+              EngineMessage m = { ne, dst };
+              out.m_replies.push_back (m);
+            }
+          else
+            {
+              // populate pending reply entry in queue
+              BSDVR_DIAG_INFO (DIAG_PENDING_REPLY_QUEUED, ne, dst, "Adding pending reply entry to queue for " << ne);
+              EnginePendingReply en = { ne, dst };
+              out.m_pendingReplies.push_back (en);
+            }
+        }
+    }
+}
+
+/*
+ BSDVR Message Expansion
+ */
+
+void
+Engine::GetTriggeredUpdates (std::list<Ipv4Address> const & changes, std::list<Ipv4Address> const & nex,
+                             std::vector<EngineMessage> & messages) const
+{
+  std::map<Ipv4Address, RoutingTableEntry> const * ft = m_table.GetForwardingTable ();
+  for (std::vector<Ipv4Address>::const_iterator i = m_neighbors.begin ();
+       i != m_neighbors.end (); ++i)
+    {
+      Ipv4Address ne = *i;
+      if (std::find (nex.begin (), nex.end (), ne) != nex.end ())
+        {
+          continue;
+        }
+      for (std::list<Ipv4Address>::const_iterator j = changes.begin ();
+           j != changes.end (); ++j)
+        {
+          if (*j != ne && ft->find (*j) != ft->end ())
+            {
+              EngineMessage m = { ne, *j };
+              messages.push_back (m);
+            }
+        }
+    }
+}
+
+void
+Engine::GetFullUpdate (Ipv4Address ne, std::vector<EngineMessage> & messages) const
+{
+  std::map<Ipv4Address, RoutingTableEntry> const * ft = m_table.GetForwardingTable ();
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = ft->begin ();
+       i != ft->end (); ++i)
+    {
+      if (i->second.GetDestination () == Ipv4Address ())
+      {
+        continue;
+      }
+      /// FIXME: revisit if this filter is still required and is working as intended
+      if (i->first != m_mainAddress && i->first != ne && i->first != Ipv4Address ("127.0.0.1"))
+        {
+          EngineMessage m = { ne, i->first };
+          messages.push_back (m);
+        }
+    }
+}
+
+}  // namespace bsdvr
+}  // namespace ns3
@@ -0,0 +1,326 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef BSDVRENGINE_H
+#define BSDVRENGINE_H
+
+#include <list>
+#include <vector>
+#include "bsdvr-rtable.h"
+#include "bsdvr-stats.h"
+#include "bsdvr-diag.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/callback.h"
+
+namespace ns3 {
+namespace bsdvr {
+
+/**
+ * \ingroup bsdvr
+ * \brief An UPDATE the engine asks its node to send
+ */
+struct EngineMessage
+{
+  Ipv4Address m_neighbor;     ///< neighbor the UPDATE is sent to
+  Ipv4Address m_destination;  ///< forwarding table destination it advertises
+};
+
+/**
+ * \ingroup bsdvr
+ * \brief A pending reply the engine asks its node to queue
+ */
+struct EnginePendingReply
+{
+  Ipv4Address m_neighbor;     ///< neighbor waiting for the reply
+  Ipv4Address m_destination;  ///< destination of the reply
+};
+
+/**
+ * \ingroup bsdvr
+ * \brief A forwarding table change made by the engine
+ */
+struct EngineRouteChange
+{
+  Ipv4Address m_oldNextHop;   ///< previous next hop, 0.0.0.0 for a new destination
+  RoutingTableEntry m_route;  ///< installed entry
+};
+
+/**
+ * \ingroup bsdvr
+ * \brief Outputs of one engine event
+ *
+ * The vectors keep their capacity across Clear (), so one EngineOutput reused
+ * for every event does not allocate in steady state.
+ */
+struct EngineOutput
+{
+  /// Forwarding table destinations to announce to the neighbors
+  std::list<Ipv4Address> m_changes;
+  /// Neighbors m_changes are not announced to
+  std::list<Ipv4Address> m_excluded;
+  /// UPDATEs to send right away
+  std::vector<EngineMessage> m_replies;
+  /// Pending replies to queue
+  std::vector<EnginePendingReply> m_pendingReplies;
+  /// Forwarding table changes, filled only when recorded (see Engine::SetRecordRouteChanges)
+  std::vector<EngineRouteChange> m_routeChanges;
+  /// Empty all the outputs
+  void Clear ();
+};
+
+/**
+ * \ingroup bsdvr
+ * \brief BSDVR control plane: distance vector and forwarding table maintenance
+ *
+ * The engine holds no socket, timer or clock. It is driven by explicit events
+ * (a neighbor heard or lost, an UPDATE received, a pending reply timer fired)
+ * and returns what the node has to do in an EngineOutput. RoutingProtocol
+ * turns the outputs into packets and timers; bsdvr-replay feeds recorded
+ * events to an engine alone to profile the control plane without a network.
+ *
+ * The neighbor set is kept in the order neighbors were first heard, which is
+ * the order Neighbors keeps and the order the tables are scanned in.
+ */
+class Engine
+{
+public:
+  /**
+   * constructor
+   * \param table the routing tables the engine maintains
+   */
+  explicit Engine (RoutingTable & table);
+
+  /**
+   * Set the address of the node, never advertised as a change
+   * \param address the main address
+   */
+  void SetMainAddress (Ipv4Address address)
+  {
+    m_mainAddress = address;
+  }
+  /**
+   * \returns the main address
+   */
+  Ipv4Address GetMainAddress () const
+  {
+    return m_mainAddress;
+  }
+  /**
+   * Set the hop threshold
+   * \param threshold the hop threshold
+   */
+  void SetThreshold (uint32_t threshold)
+  {
+    m_threshold = threshold;
+  }
+  /**
+   * \returns the hop threshold
+   */
+  uint32_t GetThreshold () const
+  {
+    return m_threshold;
+  }
+  /**
+   * Select whether forwarding table changes are reported in EngineOutput::m_routeChanges
+   * \param record true to report them
+   */
+  void SetRecordRouteChanges (bool record)
+  {
+    m_recordRouteChanges = record;
+  }
+  /**
+   * Set the callback the BSDVR_DIAG_* diagnostics are reported to
+   * \param cb the callback
+   */
+  void SetDiagnosticCallback (Callback<void, DiagLevel, DiagEvent, Ipv4Address, Ipv4Address> cb)
+  {
+    m_diagnostic = cb;
+  }
+  /**
+   * \returns the counters of the forwarding table computations
+   */
+  Statistics const & GetStatistics () const
+  {
+    return m_stats;
+  }
+  /**
+   * \returns the routing tables
+   */
+  RoutingTable & GetRoutingTable ()
+  {
+    return m_table;
+  }
+
+  /**
+   * \name Neighbor set
+   * \{
+   */
+  /**
+   * Add a neighbor, if not already in the set
+   * \param ne the neighbor
+   */
+  void AddNeighbor (Ipv4Address ne);
+  /**
+   * Remove a neighbor, keeping the order of the others
+   * \param ne the neighbor
+   */
+  void RemoveNeighbor (Ipv4Address ne);
+  /// Remove all neighbors
+  void ClearNeighbors ()
+  {
+    m_neighbors.clear ();
+  }
+  /**
+   * \param ne the address to look for
+   * \returns true if ne is in the neighbor set
+   */
+  bool IsNeighbor (Ipv4Address ne) const;
+  /**
+   * \returns the neighbors, in the order they were added
+   */
+  std::vector<Ipv4Address> const & GetNeighbors () const
+  {
+    return m_neighbors;
+  }
+  /** \} */
+
+  /**
+   * \name Events
+   * \{
+   */
+  /**
+   * A HELLO was heard from a neighbor: make sure its DVT holds a route to it
+   * \param link one hop route to the neighbor
+   * \param out the outputs
+   * \returns true if the link is new, in which case the node owes the
+   *          neighbor its forwarding table (see GetFullUpdate)
+   */
+  bool LinkUp (RoutingTableEntry const & link, EngineOutput & out);
+  /**
+   * The link to a neighbor failed: mark it INACTIVE, recompute the forwarding
+   * table and remove the neighbor from the set
+   * \param ne the neighbor
+   * \param out the outputs; m_excluded holds ne
+   */
+  void LinkDown (Ipv4Address ne, EngineOutput & out);
+  /**
+   * An UPDATE was received
+   * \param rt the advertised route, with the sender as next hop and the hop
+   *        count and state already adjusted by the node
+   * \param origin the origin of the UPDATE
+   * \param hopCount the hop count carried by the UPDATE
+   * \param state the binary state carried by the UPDATE
+   * \param out the outputs
+   */
+  void RecvUpdate (RoutingTableEntry & rt, Ipv4Address origin, uint32_t hopCount, uint32_t state,
+                   EngineOutput & out);
+  /**
+   * The pending reply timer of a neighbor fired
+   * \param ne the neighbor waiting for the reply
+   * \param dst the destination of the reply
+   * \param out the outputs; m_replies holds the reply if still due
+   */
+  void PendingReplyTimeout (Ipv4Address ne, Ipv4Address dst, EngineOutput & out);
+  /** \} */
+
+  /**
+   * \name Control plane steps, for events made of several UPDATEs
+   * \{
+   */
+  /**
+   * Find if a route to a destination is better than an alternative route
+   * \param r1 routing entry for a given destination
+   * \param r2 alternative routing entry for the same destination
+   * \returns true in success
+   */
+  bool IsBetterRoute (RoutingTableEntry const & r1, RoutingTableEntry const & r2) const;
+  /**
+   * Remove alternative routes from DVT to avoid fake routes - [doesnot remove direct neighbor routes]
+   * \param nxtHp nexthop's address
+   * \param rt  new entry with destination address dst
+   */
+  void RemoveFakeRoutes (Ipv4Address nxtHp, RoutingTableEntry & rt);
+  /**
+   * Update existing routes in DVT or add new routes
+   * \param nxtHp nexthop's address
+   * \param rt  new entry with destination address dst
+   */
+  void UpdateDistanceVectorTable (Ipv4Address nxtHp, RoutingTableEntry & rt);
+  /**
+   * Update changes in existing routes from updated DVT
+   * \param dst destination address
+   * \param nxtHp nexthop's address
+   */
+  void RefreshForwardingTable (Ipv4Address dst, Ipv4Address nxtHp);
+  /**
+   * Replace existing routes with by alternative routes from updated DVT if any
+   * \param out the outputs; m_changes receives the newly installed routes
+   *        in FT to broadcast to neighbors
+   */
+  void ComputeForwardingTable (EngineOutput & out);
+  /**
+   * Answer an INACTIVE UPDATE not on the primary path, right away or through
+   * a pending reply
+   * \param origin the origin of the UPDATE
+   * \param dst the destination of the UPDATE
+   * \param hopCount the hop count carried by the UPDATE
+   * \param out the outputs
+   */
+  void RetransmitToNeighbor (Ipv4Address origin, Ipv4Address dst, uint32_t hopCount, EngineOutput & out);
+  /** \} */
+
+  /**
+   * \name Message expansion
+   * \{
+   */
+  /**
+   * List the UPDATEs announcing forwarding table changes to the neighbors
+   * \param changes destinations in forwarding table that have their routes updated
+   * \param nex neighbors to exclude
+   * \param messages the list the UPDATEs are appended to
+   */
+  void GetTriggeredUpdates (std::list<Ipv4Address> const & changes, std::list<Ipv4Address> const & nex,
+                            std::vector<EngineMessage> & messages) const;
+  /**
+   * List the UPDATEs carrying the whole forwarding table to a new neighbor
+   * \param ne the neighbor
+   * \param messages the list the UPDATEs are appended to
+   */
+  void GetFullUpdate (Ipv4Address ne, std::vector<EngineMessage> & messages) const;
+  /** \} */
+
+private:
+  /**
+   * ComputeForwardingTable () with the route comparison resolved at compile time
+   * \param isBetter the route comparator
+   * \param out the outputs
+   */
+  template <class Comparator>
+  void DoComputeForwardingTable (Comparator const & isBetter, EngineOutput & out);
+  /**
+   * Report a diagnostic, called through the BSDVR_DIAG_* macros
+   * \param level the severity
+   * \param event the event
+   * \param peer the neighbor involved
+   * \param dst the destination involved
+   */
+  void ReportDiagnostic (DiagLevel level, DiagEvent event, Ipv4Address peer, Ipv4Address dst);
+
+  /// Routing tables
+  RoutingTable & m_table;
+  /// Neighbors, in the order they were added
+  std::vector<Ipv4Address> m_neighbors;
+  /// Address of the node
+  Ipv4Address m_mainAddress;
+  /// Hop threshold
+  uint32_t m_threshold;
+  /// Whether forwarding table changes are reported
+  bool m_recordRouteChanges;
+  /// Diagnostic callback
+  Callback<void, DiagLevel, DiagEvent, Ipv4Address, Ipv4Address> m_diagnostic;
+  /// Forwarding table computation counters
+  Statistics m_stats;
+};
+
+}  // namespace bsdvr
+}  // namespace ns3
+
+#endif /* BSDVRENGINE_H */
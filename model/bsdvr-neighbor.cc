@@ -163,5 +163,11 @@ Neighbors::ProcessTxError (WifiMacHeader const & hdr)
   Purge ();
 }
 
+uint64_t
+Neighbors::GetMemoryUsage () const
+{
+  return m_nb.capacity () * sizeof (Neighbor) + m_arp.capacity () * sizeof (Ptr<ArpCache>);
+}
+
 }  // namespace bsdvr
 }  // namespace ns3
\ No newline at end of file
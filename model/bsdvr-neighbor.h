@@ -125,6 +125,11 @@ public:
   {
     return m_nb;
   }
+  /**
+   * Estimate the bytes used by the neighbor and ARP cache vectors
+   * \returns the estimated size
+   */
+  uint64_t GetMemoryUsage () const;
 
 private:
   /// link failure callback
@@ -52,6 +52,9 @@ TypeHeader::Deserialize (Buffer::Iterator start)
       {
       case BSDVRTYPE_HELLO:
       case BSDVRTYPE_UPDATE:
+      case BSDVRTYPE_SNAPSHOT:
+      case BSDVRTYPE_SNAPSHOT_ACK:
+      case BSDVRTYPE_UPDATE_ACK:
         {
           m_type = (MessageType) type;
           break;
@@ -79,6 +82,21 @@ TypeHeader::Print (std::ostream &os) const
         os << "UPDATE";
         break;
       }
+    case BSDVRTYPE_SNAPSHOT:
+      {
+        os << "SNAPSHOT";
+        break;
+      }
+    case BSDVRTYPE_SNAPSHOT_ACK:
+      {
+        os << "SNAPSHOT_ACK";
+        break;
+      }
+    case BSDVRTYPE_UPDATE_ACK:
+      {
+        os << "UPDATE_ACK";
+        break;
+      }
     default:
       os << "UNKNOWN_TYPE";
     }
@@ -105,7 +123,9 @@ UpdateHeader::UpdateHeader (Ipv4Address origin, Ipv4Address dst, uint32_t hopcou
   : m_origin (origin),
     m_dst (dst),
     m_hopCount (hopcount),
-    m_binaryState (state)
+    m_binaryState (state),
+    m_seqNo (0),
+    m_oldestUnacked (0)
 {
 }
 
@@ -131,7 +151,7 @@ UpdateHeader::GetInstanceTypeId () const
 uint32_t
 UpdateHeader::GetSerializedSize () const
 {
-  return 16;
+  return (m_seqNo != 0) ? 24 : 16;
 }
 
 void
@@ -140,7 +160,16 @@ UpdateHeader::Serialize (Buffer::Iterator i) const
   WriteTo (i, m_origin);
   WriteTo (i, m_dst);
   i.WriteHtonU32 (m_hopCount);
-  i.WriteHtonU32 (m_binaryState);
+  if (m_seqNo != 0)
+    {
+      i.WriteHtonU32 (m_binaryState | SEQUENCED_FLAG);
+      i.WriteHtonU32 (m_seqNo);
+      i.WriteHtonU32 (m_oldestUnacked);
+    }
+  else
+    {
+      i.WriteHtonU32 (m_binaryState);
+    }
 }
 
 uint32_t
@@ -151,6 +180,14 @@ UpdateHeader::Deserialize (Buffer::Iterator start)
   ReadFrom (i, m_dst);
   m_hopCount = i.ReadNtohU32 ();
   m_binaryState = i.ReadNtohU32 ();
+  m_seqNo = 0;
+  m_oldestUnacked = 0;
+  if (m_binaryState & SEQUENCED_FLAG)
+    {
+      m_binaryState &= ~SEQUENCED_FLAG;
+      m_seqNo = i.ReadNtohU32 ();
+      m_oldestUnacked = i.ReadNtohU32 ();
+    }
 
   uint32_t dist = i.GetDistanceFrom (start);
   NS_ASSERT (dist == GetSerializedSize ());
@@ -163,14 +200,16 @@ UpdateHeader::Print (std::ostream &os) const
   os << "SourceIpv4: " << m_origin
      << "DestinationIpv4: " << m_dst
      << "Hopcount: " << m_hopCount
-     << "State: " << m_binaryState;
+     << "State: " << m_binaryState
+     << "SeqNo: " << m_seqNo;
 }
 
 bool
 UpdateHeader::operator== (UpdateHeader const & o) const
 {
   return(m_origin == o.m_origin && m_dst == o.m_dst
-         && m_hopCount == o.m_hopCount && m_binaryState == o.m_binaryState);
+         && m_hopCount == o.m_hopCount && m_binaryState == o.m_binaryState
+         && m_seqNo == o.m_seqNo && m_oldestUnacked == o.m_oldestUnacked);
 }
 
 std::ostream &
@@ -180,6 +219,47 @@ operator<< (std::ostream & os, UpdateHeader const & h)
   return os;
 }
 
+//-----------------------------------------------------------------------------
+// ACK BLOCK
+//-----------------------------------------------------------------------------
+
+/**
+ * \brief Serialize an acknowledgment block
+ * \param i the buffer iterator
+ * \param b the acknowledgment block
+ */
+static void
+WriteAckBlock (Buffer::Iterator & i, AckBlock const & b)
+{
+  WriteTo (i, b.m_neighbor);
+  i.WriteHtonU32 (b.m_cumAck);
+  i.WriteHtonU16 (b.m_sack.size ());
+  i.WriteHtonU16 (0); // reserved
+  for (std::vector<uint32_t>::const_iterator s = b.m_sack.begin (); s != b.m_sack.end (); ++s)
+    {
+      i.WriteHtonU32 (*s);
+    }
+}
+
+/**
+ * \brief Deserialize an acknowledgment block
+ * \param i the buffer iterator
+ * \param b the acknowledgment block
+ */
+static void
+ReadAckBlock (Buffer::Iterator & i, AckBlock & b)
+{
+  ReadFrom (i, b.m_neighbor);
+  b.m_cumAck = i.ReadNtohU32 ();
+  uint16_t count = i.ReadNtohU16 ();
+  i.ReadNtohU16 (); // reserved
+  b.m_sack.clear ();
+  for (uint16_t k = 0; k < count; ++k)
+    {
+      b.m_sack.push_back (i.ReadNtohU32 ());
+    }
+}
+
 //-----------------------------------------------------------------------------
 // HELLO
 //-----------------------------------------------------------------------------
@@ -212,7 +292,16 @@ HelloHeader::GetInstanceTypeId () const
 uint32_t
 HelloHeader::GetSerializedSize () const
 {
-  return 8;
+  if (m_records.empty () && m_acks.empty ())
+    {
+      return 8;
+    }
+  uint32_t size = 12 + 12 * m_records.size ();
+  for (std::vector<AckBlock>::const_iterator b = m_acks.begin (); b != m_acks.end (); ++b)
+    {
+      size += b->GetSerializedSize ();
+    }
+  return size;
 }
 
 void
@@ -220,6 +309,22 @@ HelloHeader::Serialize (Buffer::Iterator i) const
 {
   WriteTo (i, m_origin);
   WriteTo (i, m_dst);
+  if (m_records.empty () && m_acks.empty ())
+    {
+      return;
+    }
+  i.WriteHtonU16 (m_records.size ());
+  i.WriteHtonU16 (m_acks.size ());
+  for (std::vector<RouteRecord>::const_iterator r = m_records.begin (); r != m_records.end (); ++r)
+    {
+      WriteTo (i, r->m_dst);
+      i.WriteHtonU32 (r->m_hopCount);
+      i.WriteHtonU32 (r->m_binaryState);
+    }
+  for (std::vector<AckBlock>::const_iterator b = m_acks.begin (); b != m_acks.end (); ++b)
+    {
+      WriteAckBlock (i, *b);
+    }
 }
 
 uint32_t
@@ -228,6 +333,30 @@ HelloHeader::Deserialize (Buffer::Iterator start)
   Buffer::Iterator i = start;
   ReadFrom (i, m_origin);
   ReadFrom (i, m_dst);
+  // The HELLO ends its packet: the counts are there only if something follows
+  uint16_t count = 0;
+  uint16_t acks = 0;
+  if (i.GetRemainingSize () >= 4)
+    {
+      count = i.ReadNtohU16 ();
+      acks = i.ReadNtohU16 ();
+    }
+  m_records.clear ();
+  for (uint16_t k = 0; k < count; ++k)
+    {
+      RouteRecord r;
+      ReadFrom (i, r.m_dst);
+      r.m_hopCount = i.ReadNtohU32 ();
+      r.m_binaryState = i.ReadNtohU32 ();
+      m_records.push_back (r);
+    }
+  m_acks.clear ();
+  for (uint16_t k = 0; k < acks; ++k)
+    {
+      AckBlock b;
+      ReadAckBlock (i, b);
+      m_acks.push_back (b);
+    }
 
   uint32_t dist = i.GetDistanceFrom (start);
   NS_ASSERT (dist == GetSerializedSize ());
@@ -238,13 +367,16 @@ void
 HelloHeader::Print (std::ostream &os) const
 {
   os << "SourceIpv4: " << m_origin
-     << "DestinationIpv4: " << m_dst;
+     << "DestinationIpv4: " << m_dst
+     << "Records: " << m_records.size ()
+     << "Acks: " << m_acks.size ();
 }
 
 bool
 HelloHeader::operator== (HelloHeader const & o) const
 {
-  return(m_origin == o.m_origin && m_dst == o.m_dst);
+  return(m_origin == o.m_origin && m_dst == o.m_dst && m_records == o.m_records
+         && m_acks == o.m_acks);
 }
 
 std::ostream &
@@ -254,5 +386,266 @@ operator<< (std::ostream & os, HelloHeader const & h)
   return os;
 }
 
+//-----------------------------------------------------------------------------
+// SNAPSHOT
+//-----------------------------------------------------------------------------
+
+SnapshotHeader::SnapshotHeader (Ipv4Address origin, uint16_t id, uint16_t index, uint16_t count)
+  : m_origin (origin),
+    m_id (id),
+    m_index (index),
+    m_count (count)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (SnapshotHeader);
+
+TypeId
+SnapshotHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId("ns3::bsdvr-ns3::SnapshotHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Bsdvr")
+    .AddConstructor<SnapshotHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+SnapshotHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+SnapshotHeader::GetSerializedSize () const
+{
+  return FIXED_SIZE + RECORD_SIZE * m_records.size ();
+}
+
+void
+SnapshotHeader::Serialize (Buffer::Iterator i) const
+{
+  WriteTo (i, m_origin);
+  i.WriteHtonU16 (m_id);
+  i.WriteHtonU16 (m_index);
+  i.WriteHtonU16 (m_count);
+  i.WriteHtonU16 (m_records.size ());
+  for (std::vector<RouteRecord>::const_iterator r = m_records.begin (); r != m_records.end (); ++r)
+    {
+      WriteTo (i, r->m_dst);
+      i.WriteHtonU32 (r->m_hopCount);
+      i.WriteHtonU32 (r->m_binaryState);
+    }
+}
+
+uint32_t
+SnapshotHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  ReadFrom (i, m_origin);
+  m_id = i.ReadNtohU16 ();
+  m_index = i.ReadNtohU16 ();
+  m_count = i.ReadNtohU16 ();
+  uint16_t records = i.ReadNtohU16 ();
+  m_records.clear ();
+  for (uint16_t k = 0; k < records; ++k)
+    {
+      RouteRecord r;
+      ReadFrom (i, r.m_dst);
+      r.m_hopCount = i.ReadNtohU32 ();
+      r.m_binaryState = i.ReadNtohU32 ();
+      m_records.push_back (r);
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+SnapshotHeader::Print (std::ostream &os) const
+{
+  os << "SourceIpv4: " << m_origin
+     << "SnapshotId: " << m_id
+     << "Fragment: " << m_index << "/" << m_count
+     << "Records: " << m_records.size ();
+}
+
+bool
+SnapshotHeader::operator== (SnapshotHeader const & o) const
+{
+  return(m_origin == o.m_origin && m_id == o.m_id && m_index == o.m_index
+         && m_count == o.m_count && m_records == o.m_records);
+}
+
+std::ostream &
+operator<< (std::ostream & os, SnapshotHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// SNAPSHOT_ACK
+//-----------------------------------------------------------------------------
+
+SnapshotAckHeader::SnapshotAckHeader (Ipv4Address origin, uint16_t id)
+  : m_origin (origin),
+    m_id (id)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (SnapshotAckHeader);
+
+TypeId
+SnapshotAckHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId("ns3::bsdvr-ns3::SnapshotAckHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Bsdvr")
+    .AddConstructor<SnapshotAckHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+SnapshotAckHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+SnapshotAckHeader::GetSerializedSize () const
+{
+  return 8 + 2 * m_missing.size ();
+}
+
+void
+SnapshotAckHeader::Serialize (Buffer::Iterator i) const
+{
+  WriteTo (i, m_origin);
+  i.WriteHtonU16 (m_id);
+  i.WriteHtonU16 (m_missing.size ());
+  for (std::vector<uint16_t>::const_iterator m = m_missing.begin (); m != m_missing.end (); ++m)
+    {
+      i.WriteHtonU16 (*m);
+    }
+}
+
+uint32_t
+SnapshotAckHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  ReadFrom (i, m_origin);
+  m_id = i.ReadNtohU16 ();
+  uint16_t missing = i.ReadNtohU16 ();
+  m_missing.clear ();
+  for (uint16_t k = 0; k < missing; ++k)
+    {
+      m_missing.push_back (i.ReadNtohU16 ());
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+SnapshotAckHeader::Print (std::ostream &os) const
+{
+  os << "SourceIpv4: " << m_origin
+     << "SnapshotId: " << m_id
+     << "Missing: " << m_missing.size ();
+}
+
+bool
+SnapshotAckHeader::operator== (SnapshotAckHeader const & o) const
+{
+  return(m_origin == o.m_origin && m_id == o.m_id && m_missing == o.m_missing);
+}
+
+std::ostream &
+operator<< (std::ostream & os, SnapshotAckHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// UPDATE_ACK
+//-----------------------------------------------------------------------------
+
+UpdateAckHeader::UpdateAckHeader (Ipv4Address origin, AckBlock const & ack)
+  : m_origin (origin),
+    m_ack (ack)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (UpdateAckHeader);
+
+TypeId
+UpdateAckHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId("ns3::bsdvr-ns3::UpdateAckHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Bsdvr")
+    .AddConstructor<UpdateAckHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+UpdateAckHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+UpdateAckHeader::GetSerializedSize () const
+{
+  return 4 + m_ack.GetSerializedSize ();
+}
+
+void
+UpdateAckHeader::Serialize (Buffer::Iterator i) const
+{
+  WriteTo (i, m_origin);
+  WriteAckBlock (i, m_ack);
+}
+
+uint32_t
+UpdateAckHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  ReadFrom (i, m_origin);
+  ReadAckBlock (i, m_ack);
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+UpdateAckHeader::Print (std::ostream &os) const
+{
+  os << "SourceIpv4: " << m_origin
+     << "CumulativeAck: " << m_ack.m_cumAck
+     << "Sack: " << m_ack.m_sack.size ();
+}
+
+bool
+UpdateAckHeader::operator== (UpdateAckHeader const & o) const
+{
+  return(m_origin == o.m_origin && m_ack == o.m_ack);
+}
+
+std::ostream &
+operator<< (std::ostream & os, UpdateAckHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
 }  // namespace bsdvr
 }  // namespace ns3
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define BSDVRPACKET_H
 
 #include <iostream>
+#include <vector>
 #include "ns3/enum.h"
 #include "ns3/header.h"
 #include "ns3/nstime.h"
@@ -18,7 +19,20 @@ namespace bsdvr{
 enum MessageType
 {   
     BSDVRTYPE_HELLO  = 1,
-    BSDVRTYPE_UPDATE = 2
+    BSDVRTYPE_UPDATE = 2,
+    BSDVRTYPE_SNAPSHOT = 3,
+    BSDVRTYPE_SNAPSHOT_ACK = 4,
+    BSDVRTYPE_UPDATE_ACK = 5
+};
+/**
+ * \ingroup bsdvr
+ * \brief Binary state values carried by UPDATE messages and route records
+ */
+enum UpdateState
+{
+    UPDATE_STATE_INACTIVE = 0,  //!< the advertised route is inactive
+    UPDATE_STATE_ACTIVE   = 1,  //!< the advertised route is active
+    UPDATE_STATE_POISONED = 2   //!< poisoned reverse: the advertised route goes through the receiver
 };
 /**
 * \ingroup bsdvr
@@ -81,6 +95,10 @@ std::ostream & operator<< (std::ostream & os, TypeHeader const & h);
 /**
  * \ingroup bsdvr
  * \brief BSDVR Update Message Format
+ *
+ * A sequenced UPDATE sets the S flag (most significant bit of the State
+ * field) and appends its sequence number and the oldest sequence number
+ * the sender still waits an acknowledgment for.
  * \verbatim
  |      0        |      1        |      2        |       3       |
   0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 
@@ -91,7 +109,11 @@ std::ostream & operator<< (std::ostream & os, TypeHeader const & h);
  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  |                           HopCount                            |
  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- |                            State                              |
+ |S|                          State                              |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |                  Sequence Number (if S set)                   |
+ +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ |               Oldest Unacknowledged (if S set)                |
  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  * \endverbatim
  */
@@ -183,6 +205,32 @@ public:
   {
     return m_binaryState;
   }
+  /**
+   * \brief Set the sequence number, 0 for an unsequenced UPDATE
+   * \param seqNo the sequence number
+   * \param oldest the oldest sequence number not yet acknowledged by the neighbor
+   */
+  void SetSeqNo (uint32_t seqNo, uint32_t oldest)
+  {
+    m_seqNo = seqNo;
+    m_oldestUnacked = oldest;
+  }
+  /**
+   * \brief Get the sequence number
+   * \return the sequence number, 0 if the UPDATE is unsequenced
+   */
+  uint32_t GetSeqNo () const
+  {
+    return m_seqNo;
+  }
+  /**
+   * \brief Get the oldest sequence number not yet acknowledged by the neighbor
+   * \return the oldest unacknowledged sequence number
+   */
+  uint32_t GetOldestUnacked () const
+  {
+    return m_oldestUnacked;
+  }
   /**
    * \brief Comparison operator
    * \param o UPDATE header to compare
@@ -190,10 +238,14 @@ public:
    */
   bool operator== (UpdateHeader const & o) const;
 private:
+  /// Flag set in the serialized State field of a sequenced UPDATE
+  static const uint32_t SEQUENCED_FLAG = 0x80000000;
   Ipv4Address    m_origin;         ///< Originator IP Address
   Ipv4Address    m_dst;            ///< Destination IP Address
   uint32_t       m_hopCount;       ///< Number of Hops
   uint32_t       m_binaryState;    ///< Binary State
+  uint32_t       m_seqNo;          ///< Sequence Number
+  uint32_t       m_oldestUnacked;  ///< Oldest Unacknowledged Sequence Number
 };
 
 /**
@@ -203,9 +255,104 @@ private:
   */
 std::ostream & operator<< (std::ostream & os, UpdateHeader const &);
 
+/**
+ * \ingroup bsdvr
+ * \brief Route record (destination, hop count, state) in the same format as
+ * the corresponding fields of an UPDATE message
+ */
+struct RouteRecord
+{
+  /**
+   * constructor
+   *
+   * \param dst the destination IP address
+   * \param hopCount the hop count
+   * \param state the binary state of the route
+   */
+  RouteRecord (Ipv4Address dst = Ipv4Address (), uint32_t hopCount = 0, uint32_t state = 0)
+    : m_dst (dst),
+      m_hopCount (hopCount),
+      m_binaryState (state)
+  {
+  }
+  /**
+   * \brief Comparison operator
+   * \param o record to compare
+   * \return true if the records are equal
+   */
+  bool operator== (RouteRecord const & o) const
+  {
+    return (m_dst == o.m_dst && m_hopCount == o.m_hopCount && m_binaryState == o.m_binaryState);
+  }
+  Ipv4Address    m_dst;            ///< Destination IP Address
+  uint32_t       m_hopCount;       ///< Number of Hops
+  uint32_t       m_binaryState;    ///< Binary State
+};
+
+/**
+ * \ingroup bsdvr
+ * \brief Acknowledgment of the sequenced UPDATEs received from a neighbor
+ * \verbatim
+|      0        |      1        |      2        |       3       |
+ 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                       Neighbor Address                        |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                        Cumulative Ack                         |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|          SACK Count           |           Reserved            |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                 Selectively Acked Number (1)                  |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                              ...                              |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+* \endverbatim
+*/
+struct AckBlock
+{
+  /**
+   * constructor
+   *
+   * \param neighbor the neighbor whose UPDATEs are acknowledged
+   * \param cumAck every sequence number up to this one was received
+   */
+  AckBlock (Ipv4Address neighbor = Ipv4Address (), uint32_t cumAck = 0)
+    : m_neighbor (neighbor),
+      m_cumAck (cumAck)
+  {
+  }
+  /**
+   * \brief Get the serialized size of the block
+   * \return the size in bytes
+   */
+  uint32_t GetSerializedSize () const
+  {
+    return 12 + 4 * m_sack.size ();
+  }
+  /**
+   * \brief Comparison operator
+   * \param o block to compare
+   * \return true if the blocks are equal
+   */
+  bool operator== (AckBlock const & o) const
+  {
+    return (m_neighbor == o.m_neighbor && m_cumAck == o.m_cumAck && m_sack == o.m_sack);
+  }
+  Ipv4Address    m_neighbor;       ///< Neighbor IP Address
+  uint32_t       m_cumAck;         ///< Cumulative Ack
+  std::vector<uint32_t> m_sack;    ///< Sequence numbers received beyond the cumulative ack
+};
+
 /**
  * \ingroup bsdvr
  * \brief HELLO Message Format
+ *
+ * A HELLO may carry a bounded list of pending forwarding table changes
+ * (piggybacked UPDATE records) after its fixed part, followed by
+ * acknowledgments of sequenced UPDATEs (AckBlock) for its neighbors. The
+ * counts and what follows them are only present when there is a record or
+ * an ack block, so a plain HELLO keeps its 8 bytes; the HELLO is the last
+ * header of its packet, which tells the two forms apart.
  * \verbatim
 |      0        |      1        |      2        |       3       |
  0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 
@@ -214,6 +361,20 @@ std::ostream & operator<< (std::ostream & os, UpdateHeader const &);
 +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 |                   Destination Neighbor Address                |
 +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|         Record Count          |        Ack Block Count        |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                Record Destination Address (1)                 |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                      Record HopCount (1)                      |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                       Record State (1)                        |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                              ...                              |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                         Ack Block (1)                         |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                              ...                              |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 * \endverbatim
 */
 class HelloHeader : public Header
@@ -270,6 +431,46 @@ public:
   {
     return m_dst;
   }
+  /**
+   * \brief Append a piggybacked route record
+   * \param r the route record
+   */
+  void AddRecord (RouteRecord const & r)
+  {
+    m_records.push_back (r);
+  }
+  /**
+   * \brief Get the piggybacked route records
+   * \return the route records
+   */
+  std::vector<RouteRecord> const & GetRecords () const
+  {
+    return m_records;
+  }
+  /**
+   * \brief Get the number of piggybacked route records
+   * \return the number of route records
+   */
+  uint32_t GetRecordCount () const
+  {
+    return m_records.size ();
+  }
+  /**
+   * \brief Append a piggybacked acknowledgment
+   * \param b the acknowledgment block
+   */
+  void AddAck (AckBlock const & b)
+  {
+    m_acks.push_back (b);
+  }
+  /**
+   * \brief Get the piggybacked acknowledgments
+   * \return the acknowledgment blocks
+   */
+  std::vector<AckBlock> const & GetAcks () const
+  {
+    return m_acks;
+  }
   /**
    * \brief Comparison operator
    * \param o HELLO header to compare
@@ -279,6 +480,8 @@ public:
 private:
   Ipv4Address    m_origin;         ///< Originator IP Address
   Ipv4Address    m_dst;            ///< Destination IP Address
+  std::vector<RouteRecord> m_records; ///< Piggybacked route records
+  std::vector<AckBlock> m_acks;    ///< Piggybacked acknowledgments
 };
 
 /**
@@ -288,6 +491,290 @@ private:
   */
 std::ostream & operator<< (std::ostream & os, HelloHeader const &);
 
+/**
+ * \ingroup bsdvr
+ * \brief SNAPSHOT Message Format
+ *
+ * One fragment of a forwarding table snapshot sent to a new neighbor.
+ * \verbatim
+|      0        |      1        |      2        |       3       |
+ 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                      Originator Address                       |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|          Snapshot Id          |        Fragment Index         |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|        Fragment Count         |         Record Count          |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                Record Destination Address (1)                 |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                      Record HopCount (1)                      |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                       Record State (1)                        |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                              ...                              |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+* \endverbatim
+*/
+class SnapshotHeader : public Header
+{
+public:
+  /**
+   * constructor
+   *
+   * \param origin the origin IP address
+   * \param id the snapshot id
+   * \param index the fragment index
+   * \param count the number of fragments in the snapshot
+   */
+  SnapshotHeader (Ipv4Address origin = Ipv4Address (), uint16_t id = 0, uint16_t index = 0, uint16_t count = 0);
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /// Size of the fixed part of the header, in bytes
+  static const uint32_t FIXED_SIZE = 12;
+  /// Size of a route record, in bytes
+  static const uint32_t RECORD_SIZE = 12;
+
+  // Fields
+  /**
+   * \brief Get the origin address
+   * \return the origin address
+   */
+  Ipv4Address GetOrigin () const
+  {
+    return m_origin;
+  }
+  /**
+   * \brief Get the snapshot id
+   * \return the snapshot id
+   */
+  uint16_t GetId () const
+  {
+    return m_id;
+  }
+  /**
+   * \brief Get the fragment index
+   * \return the fragment index
+   */
+  uint16_t GetFragmentIndex () const
+  {
+    return m_index;
+  }
+  /**
+   * \brief Get the number of fragments in the snapshot
+   * \return the number of fragments
+   */
+  uint16_t GetFragmentCount () const
+  {
+    return m_count;
+  }
+  /**
+   * \brief Append a route record
+   * \param r the route record
+   */
+  void AddRecord (RouteRecord const & r)
+  {
+    m_records.push_back (r);
+  }
+  /**
+   * \brief Get the route records
+   * \return the route records
+   */
+  std::vector<RouteRecord> const & GetRecords () const
+  {
+    return m_records;
+  }
+  /**
+   * \brief Comparison operator
+   * \param o SNAPSHOT header to compare
+   * \return true if the SNAPSHOT headers are equal
+   */
+  bool operator== (SnapshotHeader const & o) const;
+private:
+  Ipv4Address    m_origin;         ///< Originator IP Address
+  uint16_t       m_id;             ///< Snapshot Id
+  uint16_t       m_index;          ///< Fragment Index
+  uint16_t       m_count;          ///< Fragment Count
+  std::vector<RouteRecord> m_records; ///< Route records
+};
+
+/**
+  * \brief Stream output operator
+  * \param os output stream
+  * \return updated stream
+  */
+std::ostream & operator<< (std::ostream & os, SnapshotHeader const &);
+
+/**
+ * \ingroup bsdvr
+ * \brief SNAPSHOT_ACK Message Format
+ *
+ * Acknowledges every fragment of a snapshot except the listed missing ones.
+ * \verbatim
+|      0        |      1        |      2        |       3       |
+ 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                      Originator Address                       |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|          Snapshot Id          |         Missing Count         |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|     Missing Fragment (1)      |     Missing Fragment (2)      |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                              ...                              |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+* \endverbatim
+*/
+class SnapshotAckHeader : public Header
+{
+public:
+  /**
+   * constructor
+   *
+   * \param origin the origin IP address
+   * \param id the acknowledged snapshot id
+   */
+  SnapshotAckHeader (Ipv4Address origin = Ipv4Address (), uint16_t id = 0);
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  // Fields
+  /**
+   * \brief Get the origin address
+   * \return the origin address
+   */
+  Ipv4Address GetOrigin () const
+  {
+    return m_origin;
+  }
+  /**
+   * \brief Get the acknowledged snapshot id
+   * \return the snapshot id
+   */
+  uint16_t GetId () const
+  {
+    return m_id;
+  }
+  /**
+   * \brief Add a missing fragment index
+   * \param index the fragment index
+   */
+  void AddMissing (uint16_t index)
+  {
+    m_missing.push_back (index);
+  }
+  /**
+   * \brief Get the missing fragment indices
+   * \return the missing fragment indices
+   */
+  std::vector<uint16_t> const & GetMissing () const
+  {
+    return m_missing;
+  }
+  /**
+   * \brief Comparison operator
+   * \param o SNAPSHOT_ACK header to compare
+   * \return true if the SNAPSHOT_ACK headers are equal
+   */
+  bool operator== (SnapshotAckHeader const & o) const;
+private:
+  Ipv4Address    m_origin;         ///< Originator IP Address
+  uint16_t       m_id;             ///< Snapshot Id
+  std::vector<uint16_t> m_missing; ///< Missing fragment indices
+};
+
+/**
+  * \brief Stream output operator
+  * \param os output stream
+  * \return updated stream
+  */
+std::ostream & operator<< (std::ostream & os, SnapshotAckHeader const &);
+
+/**
+ * \ingroup bsdvr
+ * \brief UPDATE_ACK Message Format
+ * \verbatim
+|      0        |      1        |      2        |       3       |
+ 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 0 1 2 3 4 5 6 7 
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                      Originator Address                       |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+|                           Ack Block                           |
++-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+* \endverbatim
+*/
+class UpdateAckHeader : public Header
+{
+public:
+  /**
+   * constructor
+   *
+   * \param origin the origin IP address
+   * \param ack the acknowledgment block
+   */
+  UpdateAckHeader (Ipv4Address origin = Ipv4Address (), AckBlock const & ack = AckBlock ());
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  // Fields
+  /**
+   * \brief Get the origin address
+   * \return the origin address
+   */
+  Ipv4Address GetOrigin () const
+  {
+    return m_origin;
+  }
+  /**
+   * \brief Get the acknowledgment block
+   * \return the acknowledgment block
+   */
+  AckBlock const & GetAck () const
+  {
+    return m_ack;
+  }
+  /**
+   * \brief Comparison operator
+   * \param o UPDATE_ACK header to compare
+   * \return true if the UPDATE_ACK headers are equal
+   */
+  bool operator== (UpdateAckHeader const & o) const;
+private:
+  Ipv4Address    m_origin;         ///< Originator IP Address
+  AckBlock       m_ack;            ///< Acknowledgment block
+};
+
+/**
+  * \brief Stream output operator
+  * \param os output stream
+  * \return updated stream
+  */
+std::ostream & operator<< (std::ostream & os, UpdateAckHeader const &);
+
 }  // namespace bsdvr
 }  // namespace ns3
 
@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "bsdvr-profiler.h"
+#include <iomanip>
+#include <cstring>
+
+namespace ns3 {
+namespace bsdvr {
+
+Profiler::Entry Profiler::s_entries[Profiler::FUNCTION_COUNT];
+
+/// Names of the profiled functions, in Profiler::Function order
+static char const * const g_functionNames[Profiler::FUNCTION_COUNT] = {
+  "RecvUpdate",
+  "UpdateDistanceVectorTable",
+  "RemoveFakeRoutes",
+  "ComputeForwardingTable",
+  "RetransmitToNeighbor",
+  "SendTriggeredUpdateChangesToNeighbors",
+  "SendPacketFromQueue",
+};
+
+void
+Profiler::Record (Function f, uint64_t ns)
+{
+  Entry & e = s_entries[f];
+  e.m_calls++;
+  e.m_totalNs += ns;
+  if (ns > e.m_maxNs)
+    {
+      e.m_maxNs = ns;
+    }
+  uint32_t b = 0;
+  while ((ns >> (b + 1)) != 0 && b < BUCKETS - 1)
+    {
+      b++;
+    }
+  e.m_buckets[b]++;
+}
+
+void
+Profiler::Reset ()
+{
+  std::memset (s_entries, 0, sizeof (s_entries));
+}
+
+void
+Profiler::Print (std::ostream & os)
+{
+  std::ios oldState (nullptr);
+  oldState.copyfmt (os);
+  os << std::resetiosflags (std::ios::adjustfield) << std::setiosflags (std::ios::left);
+  os << "BSDVR control-plane profile (inclusive wall-clock times, all nodes)\n";
+  os << std::setw (40) << "Function" << std::setw (12) << "Calls" << std::setw (14) << "Total [ms]"
+     << std::setw (12) << "Mean [ns]" << std::setw (12) << "Max [ns]" << "\n";
+  for (uint32_t f = 0; f < FUNCTION_COUNT; f++)
+    {
+      Entry const & e = s_entries[f];
+      os << std::setw (40) << g_functionNames[f] << std::setw (12) << e.m_calls
+         << std::setw (14) << e.m_totalNs / 1e6
+         << std::setw (12) << (e.m_calls ? e.m_totalNs / e.m_calls : 0)
+         << std::setw (12) << e.m_maxNs << "\n";
+    }
+  for (uint32_t f = 0; f < FUNCTION_COUNT; f++)
+    {
+      Entry const & e = s_entries[f];
+      if (e.m_calls == 0)
+        {
+          continue;
+        }
+      os << "\n" << g_functionNames[f] << " histogram\n";
+      for (uint32_t b = 0; b < BUCKETS; b++)
+        {
+          if (e.m_buckets[b] == 0)
+            {
+              continue;
+            }
+          os << "  >= " << std::setw (14) << (b == 0 ? 0 : uint64_t (1) << b) << "ns " << e.m_buckets[b] << "\n";
+        }
+    }
+  os.copyfmt (oldState);
+}
+
+}  // namespace bsdvr
+}  // namespace ns3
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef BSDVRPROFILER_H
+#define BSDVRPROFILER_H
+
+#include <chrono>
+#include <ostream>
+#include <stdint.h>
+
+namespace ns3 {
+namespace bsdvr {
+
+/**
+ * \ingroup bsdvr
+ * \brief Wall-clock profile of control-plane functions, shared by all nodes
+ *
+ * Times are inclusive: RemoveFakeRoutes is also counted in the
+ * UpdateDistanceVectorTable and RecvUpdate frames that call it. The report
+ * is written by BsdvrHelper::PrintProfile or PrintProfileAt. Only compiled
+ * in the bsdvr module with ./waf configure --enable-bsdvr-profiling, see
+ * BSDVR_PROFILE_SCOPE; otherwise all counters stay zero.
+ */
+class Profiler
+{
+public:
+  /// Profiled functions
+  enum Function
+  {
+    RECV_UPDATE,
+    UPDATE_DISTANCE_VECTOR_TABLE,
+    REMOVE_FAKE_ROUTES,
+    COMPUTE_FORWARDING_TABLE,
+    RETRANSMIT_TO_NEIGHBOR,
+    SEND_TRIGGERED_UPDATE_CHANGES,
+    SEND_PACKET_FROM_QUEUE,
+    FUNCTION_COUNT
+  };
+  /// Number of log2 histogram buckets; bucket i > 0 counts times in [2^i, 2^(i+1)) ns
+  static const uint32_t BUCKETS = 40;
+  /**
+   * Account one call
+   * \param f the function
+   * \param ns the elapsed wall-clock time in nanoseconds
+   */
+  static void Record (Function f, uint64_t ns);
+  /**
+   * Print call counts, times and histograms of all functions
+   * \param os the output stream
+   */
+  static void Print (std::ostream & os);
+  /// Clear all counters
+  static void Reset ();
+
+private:
+  /// Counters of one function
+  struct Entry
+  {
+    uint64_t m_calls;             ///< number of calls
+    uint64_t m_totalNs;           ///< total time
+    uint64_t m_maxNs;             ///< longest call
+    uint64_t m_buckets[BUCKETS];  ///< log2 histogram
+  };
+  static Entry s_entries[FUNCTION_COUNT];  ///< counters per function
+};
+
+/**
+ * \ingroup bsdvr
+ * \brief Times the enclosing scope into the Profiler
+ */
+class ProfileScope
+{
+public:
+  /**
+   * constructor
+   * \param f the profiled function
+   */
+  explicit ProfileScope (Profiler::Function f)
+    : m_function (f),
+      m_start (std::chrono::steady_clock::now ())
+  {
+  }
+  ~ProfileScope ()
+  {
+    std::chrono::steady_clock::duration d = std::chrono::steady_clock::now () - m_start;
+    Profiler::Record (m_function, std::chrono::duration_cast<std::chrono::nanoseconds> (d).count ());
+  }
+
+private:
+  Profiler::Function m_function;                    ///< profiled function
+  std::chrono::steady_clock::time_point m_start;    ///< scope entry time
+};
+
+}  // namespace bsdvr
+}  // namespace ns3
+
+#ifdef BSDVR_PROFILING
+/// Time the enclosing scope as Profiler::f
+#define BSDVR_PROFILE_SCOPE(f) ns3::bsdvr::ProfileScope bsdvrProfileScope (ns3::bsdvr::Profiler::f)
+#else
+#define BSDVR_PROFILE_SCOPE(f)
+#endif
+
+#endif /* BSDVRPROFILER_H */
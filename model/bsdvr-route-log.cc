@@ -0,0 +1,205 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "bsdvr-route-log.h"
+#include <fstream>
+#include <set>
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BsdvrRouteLog");
+
+namespace bsdvr {
+
+/// Append an integer of the given width in network byte order
+static void
+WriteN (std::vector<uint8_t> & buf, uint64_t v, uint32_t width)
+{
+  for (uint32_t i = width; i > 0; i--)
+    {
+      buf.push_back ((v >> (8 * (i - 1))) & 0xff);
+    }
+}
+
+/// Read an integer of the given width in network byte order
+static uint64_t
+ReadN (uint8_t const * p, uint32_t width)
+{
+  uint64_t v = 0;
+  for (uint32_t i = 0; i < width; i++)
+    {
+      v = (v << 8) | p[i];
+    }
+  return v;
+}
+
+/**
+ * Open a log file for a block: truncated by the first write of the process,
+ * so that a rerun does not follow the records of the previous run, and
+ * appended to afterwards, by this log or any other sharing the file
+ * \param fileName the file name
+ * \param os the stream to open
+ */
+static void
+OpenLogFile (std::string const & fileName, std::ofstream & os)
+{
+  static std::set<std::string> opened;
+  std::ios::openmode mode = std::ios::binary;
+  mode |= opened.insert (fileName).second ? std::ios::trunc : std::ios::app;
+  os.open (fileName.c_str (), mode);
+}
+
+RouteChangeLog::RouteChangeLog ()
+  : m_head (0),
+    m_count (0),
+    m_overwritten (0),
+    m_nodeId (0)
+{
+}
+
+void
+RouteChangeLog::Setup (uint32_t nodeId, uint32_t capacity, std::string fileName)
+{
+  m_nodeId = nodeId;
+  m_fileName = fileName;
+  m_records.assign (capacity, RouteChangeRecord ());
+  m_head = 0;
+  m_count = 0;
+  m_overwritten = 0;
+}
+
+void
+RouteChangeLog::Record (int64_t time, Ipv4Address dst, Ipv4Address oldNextHop, Ipv4Address newNextHop,
+                        uint32_t hop, uint8_t state, RouteChangeCause cause)
+{
+  if (m_count == m_records.size ())
+    {
+      if (!m_fileName.empty ())
+        {
+          Flush ();
+        }
+      else
+        {
+          m_overwritten++;
+          m_count--;
+        }
+    }
+  RouteChangeRecord & r = m_records[m_head];
+  r.m_time = time;
+  r.m_dst = dst.Get ();
+  r.m_oldNextHop = oldNextHop.Get ();
+  r.m_newNextHop = newNextHop.Get ();
+  r.m_hop = hop;
+  r.m_state = state;
+  r.m_cause = cause;
+  m_head = (m_head + 1) % m_records.size ();
+  m_count++;
+}
+
+std::vector<RouteChangeRecord>
+RouteChangeLog::GetRecords () const
+{
+  std::vector<RouteChangeRecord> records;
+  records.reserve (m_count);
+  uint32_t capacity = m_records.size ();
+  for (uint32_t i = 0; i < m_count; i++)
+    {
+      records.push_back (m_records[(m_head + capacity - m_count + i) % capacity]);
+    }
+  return records;
+}
+
+void
+RouteChangeLog::Flush ()
+{
+  if (m_fileName.empty () || m_count == 0)
+    {
+      return;
+    }
+  std::vector<uint8_t> buf;
+  buf.reserve (HEADER_SIZE + m_count * RECORD_SIZE);
+  WriteN (buf, MAGIC, 4);
+  WriteN (buf, VERSION, 2);
+  WriteN (buf, RECORD_SIZE, 2);
+  WriteN (buf, m_nodeId, 4);
+  WriteN (buf, m_count, 4);
+  WriteN (buf, m_overwritten, 4);
+  uint32_t capacity = m_records.size ();
+  for (uint32_t i = 0; i < m_count; i++)
+    {
+      RouteChangeRecord const & r = m_records[(m_head + capacity - m_count + i) % capacity];
+      WriteN (buf, r.m_time, 8);
+      WriteN (buf, r.m_dst, 4);
+      WriteN (buf, r.m_oldNextHop, 4);
+      WriteN (buf, r.m_newNextHop, 4);
+      WriteN (buf, r.m_hop, 4);
+      WriteN (buf, r.m_state, 1);
+      WriteN (buf, r.m_cause, 1);
+    }
+  std::ofstream os;
+  OpenLogFile (m_fileName, os);
+  if (!os.write (reinterpret_cast<char const *> (&buf[0]), buf.size ()))
+    {
+      NS_LOG_WARN ("Failed to write " << m_count << " route change records to " << m_fileName);
+    }
+  m_head = 0;
+  m_count = 0;
+  m_overwritten = 0;
+}
+
+bool
+RouteChangeLog::ReadBlock (std::istream & is, uint32_t & nodeId, std::vector<RouteChangeRecord> & records)
+{
+  uint8_t header[HEADER_SIZE];
+  if (!is.read (reinterpret_cast<char *> (header), HEADER_SIZE))
+    {
+      return false;
+    }
+  if (ReadN (header, 4) != MAGIC || ReadN (header + 4, 2) != VERSION || ReadN (header + 6, 2) != RECORD_SIZE)
+    {
+      return false;
+    }
+  nodeId = ReadN (header + 8, 4);
+  uint32_t count = ReadN (header + 12, 4);
+  std::vector<uint8_t> buf (count * RECORD_SIZE);
+  if (count > 0 && !is.read (reinterpret_cast<char *> (&buf[0]), buf.size ()))
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < count; i++)
+    {
+      uint8_t const * p = &buf[i * RECORD_SIZE];
+      RouteChangeRecord r;
+      r.m_time = ReadN (p, 8);
+      r.m_dst = ReadN (p + 8, 4);
+      r.m_oldNextHop = ReadN (p + 12, 4);
+      r.m_newNextHop = ReadN (p + 16, 4);
+      r.m_hop = ReadN (p + 20, 4);
+      r.m_state = p[24];
+      r.m_cause = p[25];
+      records.push_back (r);
+    }
+  return true;
+}
+
+char const *
+RouteChangeLog::GetCauseName (uint8_t cause)
+{
+  switch (cause)
+    {
+    case CAUSE_UPDATE:
+      return "UPDATE";
+    case CAUSE_LINK_FAILURE:
+      return "LINK_FAILURE";
+    case CAUSE_PENDING_REPLY:
+      return "PENDING_REPLY";
+    case CAUSE_HELLO:
+      return "HELLO";
+    case CAUSE_SNAPSHOT:
+      return "SNAPSHOT";
+    default:
+      return "UNKNOWN";
+    }
+}
+
+}  // namespace bsdvr
+}  // namespace ns3
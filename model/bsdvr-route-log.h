@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef BSDVRROUTELOG_H
+#define BSDVRROUTELOG_H
+
+#include <vector>
+#include <string>
+#include <istream>
+#include <stdint.h>
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+namespace bsdvr {
+
+/**
+ * \ingroup bsdvr
+ * \brief What led to a forwarding table change
+ */
+enum RouteChangeCause
+{
+  CAUSE_UPDATE = 0,         //!< UPDATE from a neighbor
+  CAUSE_LINK_FAILURE = 1,   //!< Neighbor loss
+  CAUSE_PENDING_REPLY = 2,  //!< ACTIVE UPDATE answering our INACTIVE route
+  CAUSE_HELLO = 3,          //!< HELLO, new neighbor or piggybacked records
+  CAUSE_SNAPSHOT = 4,       //!< Snapshot fragment from a new neighbor
+};
+
+/**
+ * \ingroup bsdvr
+ * \brief One forwarding table change
+ */
+struct RouteChangeRecord
+{
+  int64_t m_time;        ///< simulation time in nanoseconds
+  uint32_t m_dst;        ///< destination
+  uint32_t m_oldNextHop; ///< previous next hop, 0 for a new destination
+  uint32_t m_newNextHop; ///< installed next hop
+  uint32_t m_hop;        ///< installed hop count
+  uint8_t m_state;       ///< installed binary state
+  uint8_t m_cause;       ///< RouteChangeCause
+};
+
+/**
+ * \ingroup bsdvr
+ * \brief Fixed-size buffer of binary route change records
+ *
+ * With a file name set, the buffer is appended to the file as one block
+ * whenever it fills up and on Flush (). Without one it is a ring that keeps
+ * the most recent records. Several nodes may share a file since every block
+ * carries its node id. The first block a process writes to a file truncates
+ * it, so a file holds the records of one run only.
+ *
+ * Block layout, network byte order:
+ * \verbatim
+   magic (4) | version (2) | record size (2) | node id (4) | record count (4) | overwritten (4)
+   count x ( time ns (8) | dst (4) | old next hop (4) | new next hop (4) | hop (4) | state (1) | cause (1) )
+   \endverbatim
+ */
+class RouteChangeLog
+{
+public:
+  /// constructor
+  RouteChangeLog ();
+  /**
+   * Allocate the buffer, discarding any buffered records
+   * \param nodeId the node the records belong to
+   * \param capacity the number of records, 0 disables the log
+   * \param fileName the output file, empty to keep an in-memory ring
+   */
+  void Setup (uint32_t nodeId, uint32_t capacity, std::string fileName);
+  /**
+   * \returns true if the log records changes
+   */
+  bool IsEnabled () const
+  {
+    return !m_records.empty ();
+  }
+  /**
+   * Record a route change
+   * \param time the simulation time in nanoseconds
+   * \param dst the destination
+   * \param oldNextHop the previous next hop
+   * \param newNextHop the installed next hop
+   * \param hop the installed hop count
+   * \param state the installed binary state
+   * \param cause the cause of the change
+   */
+  void Record (int64_t time, Ipv4Address dst, Ipv4Address oldNextHop, Ipv4Address newNextHop,
+               uint32_t hop, uint8_t state, RouteChangeCause cause);
+  /// Write the buffered records to the file, if any
+  void Flush ();
+  /**
+   * \returns the buffered records, oldest first
+   */
+  std::vector<RouteChangeRecord> GetRecords () const;
+  /**
+   * Read the next block of a log file
+   * \param is the input stream
+   * \param nodeId the node id of the block
+   * \param records the records of the block, appended
+   * \returns false at the end of the stream or on a malformed block
+   */
+  static bool ReadBlock (std::istream & is, uint32_t & nodeId, std::vector<RouteChangeRecord> & records);
+  /**
+   * \param cause the cause
+   * \returns the name of a RouteChangeCause
+   */
+  static char const * GetCauseName (uint8_t cause);
+
+  /// Block magic, "BSRL"
+  static const uint32_t MAGIC = 0x4253524c;
+  /// File format version
+  static const uint16_t VERSION = 1;
+  /// Size of a block header in bytes
+  static const uint32_t HEADER_SIZE = 20;
+  /// Size of a record in bytes
+  static const uint32_t RECORD_SIZE = 26;
+
+private:
+  std::vector<RouteChangeRecord> m_records;  ///< the buffer
+  uint32_t m_head;                           ///< next slot to write
+  uint32_t m_count;                          ///< buffered records
+  uint32_t m_overwritten;                    ///< records lost to the ring since the last flush
+  uint32_t m_nodeId;                         ///< node id written to every block
+  std::string m_fileName;                    ///< output file
+};
+
+}  // namespace bsdvr
+}  // namespace ns3
+
+#endif /* BSDVRROUTELOG_H */
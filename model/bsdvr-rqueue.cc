@@ -18,7 +18,7 @@ namespace bsdvr {
  */
 
 u_int32_t
-BsdvrPendingReplyQueue::GetSize ()
+BsdvrPendingReplyQueue::GetSize () const
 {
   return m_prqueue.size ();
 }
@@ -42,6 +42,7 @@ BsdvrPendingReplyQueue::Enqueue (PendingReplyEntry & pr_entry)
     {
       Drop (m_prqueue.front (), "Drop the most aged entry"); // Drop the most aged entry
       m_prqueue.erase (m_prqueue.begin ());
+      m_dropped++;
     }
   m_prqueue.push_back(pr_entry);
   return true;
@@ -58,6 +59,7 @@ BsdvrPendingReplyQueue::DropEntryWithNeighbor (Ipv4Address ne)
       if (i->GetNeighbor () == ne)
         {
           Drop (*i, "Droppoing entries for given neighbor");
+          m_dropped++;
         }
     }
   auto new_end = std::remove_if (m_prqueue.begin (), m_prqueue.end (),
@@ -129,6 +131,7 @@ BsdvrPendingReplyQueue::Purge ()
         if (pred (*i))
           {
             Drop (*i, "Pending reply entry timer expired ");
+            m_expired++;
             m_handlePRTimeout (*i);
           }
       }
@@ -149,7 +152,7 @@ BsdvrPendingReplyQueue::Drop (PendingReplyEntry en, std::string reason)
  */
 
 uint32_t
-BsdvrQueue::GetSize ()
+BsdvrQueue::GetSize () const
 {
   return m_queue.size ();
 }
@@ -168,6 +171,7 @@ BsdvrQueue::Enqueue (QueueEntry & entry)
         return false;
       }
   }
+  entry.SetEnqueueTime (Simulator::Now ());
   if (m_queue.size () == m_maxLen)
     {
       QueueEntry drp;
@@ -177,6 +181,7 @@ BsdvrQueue::Enqueue (QueueEntry & entry)
         }
       else
         {
+          Drop (entry, "No packet to drop, refusing the new one");
           return false;
         }
     }
@@ -236,6 +241,20 @@ BsdvrQueue::DropPacketWithDst (Ipv4Address dst)
                                 { return en.GetIpv4Header ().GetDestination () == dst;});
   m_queue.erase (new_end, m_queue.end ());
 }
+void
+BsdvrQueue::DropEntry (QueueEntry const & entry, std::string reason)
+{
+  for (std::vector<QueueEntry>::iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+    {
+      if (i->GetPacket ()->GetUid () == entry.GetPacket ()->GetUid ()
+          && i->GetIpv4Header ().GetDestination () == entry.GetIpv4Header ().GetDestination ())
+        {
+          Drop (*i, reason);
+          m_queue.erase (i);
+          return;
+        }
+    }
+}
 bool
 BsdvrQueue::Find (Ipv4Address dst)
 {
@@ -254,8 +273,12 @@ BsdvrQueue::Find (Ipv4Address dst)
 void
 BsdvrQueue::Drop (QueueEntry en, std::string reason)
 {
-  NS_LOG_LOGIC (reason << en.GetPacket ()->GetUid () << " " << en.GetIpv4Header ().GetDestination ());
-  return;
+  m_dropped++;
+  NS_LOG_LOGIC (reason << " " << en.GetPacket ()->GetUid () << " " << en.GetIpv4Header ().GetDestination ());
+  if (!m_handleDrop.IsNull ())
+    {
+      m_handleDrop (en, reason);
+    }
 }
 bool
 BsdvrQueue::DropPolicy (QueueEntry &en)
@@ -282,21 +305,41 @@ BsdvrQueue::DropPolicy (QueueEntry &en)
     }
     if (oaf != m_queue.end ()) // active forwarded first
       {
+        en = *oaf;
         m_queue.erase (oaf);
         return true;
       }
     else if (oif != m_queue.end ()) // inactive forwarded second
       {
+        en = *oif;
         m_queue.erase (oif);
         return true;
       }
     else if (onf != m_queue.end ()) // not forwarded last
       {
+        en = *onf;
         m_queue.erase (onf);
         return true;
       }
   return false; 
 }
 
+uint64_t
+BsdvrPendingReplyQueue::GetMemoryUsage () const
+{
+  return m_prqueue.capacity () * sizeof (PendingReplyEntry);
+}
+
+uint64_t
+BsdvrQueue::GetMemoryUsage () const
+{
+  uint64_t bytes = m_queue.capacity () * sizeof (QueueEntry);
+  for (std::vector<QueueEntry>::const_iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+    {
+      bytes += sizeof (Packet) + i->GetPacket ()->GetSize ();
+    }
+  return bytes;
+}
+
 }  // namespace bsdvr
 }  // namespace ns3
\ No newline at end of file
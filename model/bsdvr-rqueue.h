@@ -23,13 +23,15 @@ public:
     * \param s the packet forwarding status
     */
   Status (ForwardingStatus s = BSDVRTYPE_NOT_FORWARDED)
-  {  
+    : p_status (s),
+      p_valid (true)
+  {
   }
   void Print (std::ostream &os) const;
   /**
    * \returns the status
    */
-  ForwardingStatus Get ()
+  ForwardingStatus Get () const
   {
     return p_status;
   }
@@ -183,7 +185,8 @@ public:
       m_status (fs),
       m_header (h),
       m_ucb (ucb),
-      m_ecb (ecb)
+      m_ecb (ecb),
+      m_enqueueTime (Simulator::Now ())
   {
   }
   /**
@@ -276,6 +279,22 @@ public:
   {
     m_header = h;
   }
+  /**
+   * Get the time the entry entered the queue
+   * \returns the enqueue time
+   */
+  Time GetEnqueueTime () const
+  {
+    return m_enqueueTime;
+  }
+  /**
+   * Set the time the entry entered the queue
+   * \param t the enqueue time
+   */
+  void SetEnqueueTime (Time t)
+  {
+    m_enqueueTime = t;
+  }
 
 private:
   /// Data packet
@@ -288,6 +307,8 @@ private:
   UnicastForwardCallback m_ucb;
   /// Error callback
   ErrorCallback m_ecb;
+  /// Time the entry entered the queue
+  Time m_enqueueTime;
 };
 /**
  * \ingroup bsdvr
@@ -306,7 +327,9 @@ public:
    */
   BsdvrPendingReplyQueue (uint32_t maxLen, Time timeout)
     : m_maxLen (maxLen),
-      m_timeout (timeout)
+      m_timeout (timeout),
+      m_dropped (0),
+      m_expired (0)
   {
   }
   /**
@@ -338,7 +361,7 @@ public:
   /**
    * \returns the number of entries
    */
-  uint32_t GetSize ();
+  uint32_t GetSize () const;
 
   // Fields
   /**
@@ -389,6 +412,27 @@ public:
   {
     return m_handlePRTimeout;
   }
+  /**
+   * Get the number of entries dropped on overflow or with their neighbor
+   * \returns the number of dropped entries
+   */
+  uint64_t GetDropCount () const
+  {
+    return m_dropped;
+  }
+  /**
+   * Get the number of entries whose pending reply timer expired
+   * \returns the number of expired entries
+   */
+  uint64_t GetExpiredCount () const
+  {
+    return m_expired;
+  }
+  /**
+   * Estimate the bytes used by the queued entries
+   * \returns the estimated size
+   */
+  uint64_t GetMemoryUsage () const;
 
 private:
   /// pending reply timeout callback
@@ -407,6 +451,10 @@ private:
   uint32_t m_maxLen;
   /// the maximum period of time for which a pending reply can be buffered
   Time m_timeout;
+  /// number of entries dropped on overflow or with their neighbor
+  uint64_t m_dropped;
+  /// number of entries whose pending reply timer expired
+  uint64_t m_expired;
 };
 /**
  * \ingroup bsdvr
@@ -423,7 +471,8 @@ public:
    * \param maxLen the maximum length
    */
   BsdvrQueue (uint32_t maxLen)
-    : m_maxLen (maxLen)
+    : m_maxLen (maxLen),
+      m_dropped (0)
   {
   }
   /**
@@ -445,6 +494,12 @@ public:
    * \param dst the destination IP address
    */
   void DropPacketWithDst (Ipv4Address dst);
+  /**
+   * Remove an entry returned by Dequeue, counting it as dropped
+   * \param entry the entry
+   * \param reason the reason to drop the entry
+   */
+  void DropEntry (QueueEntry const & entry, std::string reason);
   /**
    * Finds whether a packet with destination dst exists in the queue
    * 
@@ -455,7 +510,7 @@ public:
   /**
    * \returns the number of entries
    */
-  uint32_t GetSize ();
+  uint32_t GetSize () const;
   /**
    * Get maximum queue length
    * \returns the maximum queue length
@@ -472,6 +527,35 @@ public:
   {
     m_maxLen = len;
   }
+  /**
+   * Get the number of packets dropped from, or refused by, the queue
+   * \returns the number of dropped packets
+   */
+  uint64_t GetDropCount () const
+  {
+    return m_dropped;
+  }
+  /**
+   * Estimate the bytes used by the queue entries and their packets
+   * \returns the estimated size
+   */
+  uint64_t GetMemoryUsage () const;
+  /**
+   * Set the callback notified of every dropped or refused entry
+   * \param cb the callback function, given the entry and the drop reason
+   */
+  void SetDropCallback (Callback<void, QueueEntry const &, std::string const &> cb)
+  {
+    m_handleDrop = cb;
+  }
+  /**
+   * Get the drop callback
+   * \returns the callback
+   */
+  Callback<void, QueueEntry const &, std::string const &> GetDropCallback () const
+  {
+    return m_handleDrop;
+  }
 
 
 private:
@@ -479,6 +563,10 @@ private:
   std::vector<QueueEntry> m_queue;
   /// The maximum number of packets that we allow a routing protocol to buffer.
   uint32_t m_maxLen;
+  /// Number of packets dropped from, or refused by, the queue
+  uint64_t m_dropped;
+  /// Drop notification callback
+  Callback<void, QueueEntry const &, std::string const &> m_handleDrop;
   /**
    * Notify that packet is dropped from queue by timeout
    * \param en the queue entry to drop
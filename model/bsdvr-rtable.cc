@@ -1,5 +1,6 @@
 #include "ns3/log.h"
 #include <algorithm>
+#include <set>
 #include "bsdvr-rtable.h"
 #include "ns3/simulator.h"
 
@@ -160,7 +161,7 @@ RoutingTable::DeleteAllRoutesFromInterface (Ipv4InterfaceAddress iface, std::map
     }
 }
 void
-RoutingTable::Print (std::map<Ipv4Address, RoutingTableEntry>* map, Ptr<OutputStreamWrapper> stream, Time::Unit unit /* = Time::S */) const
+RoutingTable::Print (std::map<Ipv4Address, RoutingTableEntry> const * map, Ptr<OutputStreamWrapper> stream, Time::Unit unit /* = Time::S */) const
 {
   std::ostream* os = stream->GetStream ();
   // Copy the current ostream state
@@ -186,5 +187,144 @@ RoutingTable::Print (std::map<Ipv4Address, RoutingTableEntry>* map, Ptr<OutputSt
 
 }
 
+/// Write an integer of the given width in network byte order
+static uint8_t *
+WriteN (uint8_t * p, uint64_t v, uint32_t width)
+{
+  for (uint32_t i = width; i > 0; i--)
+    {
+      *p++ = (v >> (8 * (i - 1))) & 0xff;
+    }
+  return p;
+}
+
+/// Write an address in dotted decimal form without going through Ipv4Address::Print
+static void
+WriteAddress (std::ostream & os, uint32_t a)
+{
+  os << (a >> 24) << '.' << ((a >> 16) & 0xff) << '.' << ((a >> 8) & 0xff) << '.' << (a & 0xff);
+}
+
+/// Write one dump row
+static void
+DumpRow (std::ostream & os, TableDumpFormat format, int64_t time, uint32_t nodeId, uint8_t table,
+         Ipv4Address neighbor, RoutingTableEntry const & rt)
+{
+  uint32_t dst = rt.GetDestination ().Get ();
+  uint32_t nextHop = rt.GetNextHop ().Get ();
+  uint8_t state = (rt.GetRouteState () == ACTIVE) ? 1 : 0;
+  if (format == DUMP_BINARY)
+    {
+      uint8_t row[RoutingTable::DUMP_ROW_SIZE];
+      uint8_t *p = WriteN (row, time, 8);
+      p = WriteN (p, nodeId, 4);
+      p = WriteN (p, table, 1);
+      p = WriteN (p, neighbor.Get (), 4);
+      p = WriteN (p, dst, 4);
+      p = WriteN (p, nextHop, 4);
+      p = WriteN (p, rt.GetHop (), 4);
+      WriteN (p, state, 1);
+      os.write (reinterpret_cast<char const *> (row), sizeof (row));
+      return;
+    }
+  os << time << ',' << nodeId << ',' << uint32_t (table) << ',';
+  WriteAddress (os, neighbor.Get ());
+  os << ',';
+  WriteAddress (os, dst);
+  os << ',';
+  WriteAddress (os, nextHop);
+  os << ',' << rt.GetHop () << ',' << uint32_t (state) << '\n';
+}
+
+void
+RoutingTable::Dump (std::ostream & os, TableDumpFormat format, int64_t time, uint32_t nodeId, bool includeDvt) const
+{
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = m_ForwardingTable.begin ();
+       i != m_ForwardingTable.end (); ++i)
+    {
+      DumpRow (os, format, time, nodeId, 0, Ipv4Address (), i->second);
+    }
+  if (!includeDvt)
+    {
+      return;
+    }
+  for (std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >::const_iterator n = m_DistanceVectorTable.begin ();
+       n != m_DistanceVectorTable.end (); ++n)
+    {
+      for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = n->second->begin (); i != n->second->end (); ++i)
+        {
+          DumpRow (os, format, time, nodeId, 1, n->first, i->second);
+        }
+    }
+}
+
+void
+RoutingTable::DumpHeader (std::ostream & os, TableDumpFormat format)
+{
+  if (format == DUMP_BINARY)
+    {
+      uint8_t header[8];
+      uint8_t *p = WriteN (header, 0x42535254, 4);
+      p = WriteN (p, 1, 2);
+      WriteN (p, DUMP_ROW_SIZE, 2);
+      os.write (reinterpret_cast<char const *> (header), sizeof (header));
+      return;
+    }
+  os << "time_ns,node,table,neighbor,dst,next_hop,hops,state\n";
+}
+
+/// Estimated per-node overhead of a std::map: parent, children and color
+static const uint64_t MAP_NODE_OVERHEAD = 4 * sizeof (void *);
+/// Estimated size of an FT or per-neighbor DVT map node
+static const uint64_t ENTRY_NODE_SIZE = MAP_NODE_OVERHEAD + sizeof (std::pair<const Ipv4Address, RoutingTableEntry>);
+
+uint64_t
+RoutingTable::GetForwardingTableMemoryUsage () const
+{
+  return m_ForwardingTable.size () * ENTRY_NODE_SIZE;
+}
+
+uint64_t
+RoutingTable::GetDistanceVectorTableMemoryUsage () const
+{
+  uint64_t bytes = m_DistanceVectorTable.size ()
+    * (MAP_NODE_OVERHEAD + sizeof (std::pair<const Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>*>)
+       + sizeof (std::map<Ipv4Address, RoutingTableEntry>));
+  for (std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >::const_iterator n = m_DistanceVectorTable.begin ();
+       n != m_DistanceVectorTable.end (); ++n)
+    {
+      bytes += n->second->size () * ENTRY_NODE_SIZE;
+    }
+  return bytes;
+}
+
+uint64_t
+RoutingTable::GetRouteMemoryUsage () const
+{
+  // FT entries are copies of DVT entries and share their route
+  std::set<Ipv4Route const *> routes;
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = m_ForwardingTable.begin ();
+       i != m_ForwardingTable.end (); ++i)
+    {
+      routes.insert (PeekPointer (i->second.GetRoute ()));
+    }
+  for (std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >::const_iterator n = m_DistanceVectorTable.begin ();
+       n != m_DistanceVectorTable.end (); ++n)
+    {
+      for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = n->second->begin (); i != n->second->end (); ++i)
+        {
+          routes.insert (PeekPointer (i->second.GetRoute ()));
+        }
+    }
+  routes.erase (0);
+  return routes.size () * sizeof (Ipv4Route);
+}
+
+uint64_t
+RoutingTable::GetMemoryUsage () const
+{
+  return GetForwardingTableMemoryUsage () + GetDistanceVectorTableMemoryUsage () + GetRouteMemoryUsage ();
+}
+
 }  // namespace bsdvr
 }  // namespace ns3
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define BSDVR_RTABLE_H
 
 #include <map>
+#include <ostream>
 #include <cassert>
 #include <stdint.h>
 #include "ns3/ipv4.h"
@@ -10,6 +11,7 @@
 #include "ns3/ipv4-route.h"
 #include "ns3/net-device.h"
 #include "ns3/output-stream-wrapper.h"
+#include "bsdvr-constants.h"
 
 namespace ns3 {
 namespace bsdvr {
@@ -24,6 +26,16 @@ enum RouteState
   ACTIVE = 1,        //!< ACTIVE
 };
 
+/**
+ * \ingroup bsdvr
+ * \brief Routing table dump formats
+ */
+enum TableDumpFormat
+{
+  DUMP_CSV = 0,      //!< one text line per row
+  DUMP_BINARY = 1,   //!< fixed-size rows in network byte order
+};
+
 /**
  * \ingroup bsdvr
  * \brief Routing table entry
@@ -213,15 +225,15 @@ public:
    * Get forwarding table
    * \returns the forwarding table
    */
-  std::map<Ipv4Address, RoutingTableEntry> GetForwardingTablePrint () const
+  std::map<Ipv4Address, RoutingTableEntry>* GetForwardingTable ()
   {
-    return m_ForwardingTable;
+    return &m_ForwardingTable;
   }
   /**
    * Get forwarding table
    * \returns the forwarding table
    */
-  std::map<Ipv4Address, RoutingTableEntry>* GetForwardingTable ()
+  std::map<Ipv4Address, RoutingTableEntry> const * GetForwardingTable () const
   {
     return &m_ForwardingTable;
   }
@@ -233,6 +245,14 @@ public:
   {
     return &m_DistanceVectorTable;
   }
+  /**
+   * Get distance vector table
+   * \returns the distance vector table
+   */
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* > const * GetDistanceVectorTable () const
+  {
+    return &m_DistanceVectorTable;
+  }
   /**
    * Add routing table entry if it doesn't yet exist in routing table
    * \param r routing table entry
@@ -287,7 +307,52 @@ public:
    * \param unit The time unit to use (default Time::S)
    * \param map Ipv4 address to entry map
    */
-  void Print (std::map<Ipv4Address, RoutingTableEntry>* map, Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const;
+  void Print (std::map<Ipv4Address, RoutingTableEntry> const * map, Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const;
+  /**
+   * Write the FT, and optionally the DVT, as rows of a column file
+   *
+   * Columns are time (ns), node, table (0 FT, 1 DVT), neighbor (0.0.0.0 in
+   * the FT), destination, next hop, hops and state. A binary row is 30 bytes:
+   * time (8), node (4), table (1), neighbor (4), destination (4), next hop (4),
+   * hops (4), state (1).
+   *
+   * \param os the output stream, opened in binary mode for DUMP_BINARY
+   * \param format the row format
+   * \param time the time column, in nanoseconds
+   * \param nodeId the node column
+   * \param includeDvt whether the DVT rows are written too
+   */
+  void Dump (std::ostream & os, TableDumpFormat format, int64_t time, uint32_t nodeId, bool includeDvt) const;
+  /**
+   * Write the column header of a dump file: a CSV header line, or for
+   * DUMP_BINARY the magic "BSRT", version (2) and row size (2)
+   * \param os the output stream
+   * \param format the row format
+   */
+  static void DumpHeader (std::ostream & os, TableDumpFormat format);
+  /// Size of a DUMP_BINARY row in bytes
+  static const uint32_t DUMP_ROW_SIZE = 30;
+  /**
+   * Estimate the bytes used by the FT map and its entries
+   * \returns the estimated size
+   */
+  uint64_t GetForwardingTableMemoryUsage () const;
+  /**
+   * Estimate the bytes used by the DVT maps and their entries
+   * \returns the estimated size
+   */
+  uint64_t GetDistanceVectorTableMemoryUsage () const;
+  /**
+   * Estimate the bytes used by the Ipv4Route objects of FT and DVT entries,
+   * each shared route counted once
+   * \returns the estimated size
+   */
+  uint64_t GetRouteMemoryUsage () const;
+  /**
+   * Estimate the bytes used by both tables and their routes
+   * \returns the estimated size
+   */
+  uint64_t GetMemoryUsage () const;
 
 private:
   /// The forwarding table (main routing table)
@@ -296,6 +361,92 @@ private:
   std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* > m_DistanceVectorTable;
 };
 
+/**
+ * \ingroup bsdvr
+ * \brief Hop threshold fixed at compile time
+ */
+template <uint32_t Threshold>
+struct StaticThreshold
+{
+  /**
+   * Get the hop threshold
+   * \returns the hop threshold
+   */
+  uint32_t Get () const
+  {
+    return Threshold;
+  }
+};
+
+/**
+ * \ingroup bsdvr
+ * \brief Hop threshold set at run time
+ */
+struct DynamicThreshold
+{
+  /**
+   * constructor
+   * \param threshold the hop threshold
+   */
+  explicit DynamicThreshold (uint32_t threshold)
+    : m_threshold (threshold)
+  {
+  }
+  /**
+   * Get the hop threshold
+   * \returns the hop threshold
+   */
+  uint32_t Get () const
+  {
+    return m_threshold;
+  }
+  uint32_t m_threshold;  ///< hop threshold
+};
+
+/// Threshold policy for the default hop threshold
+typedef StaticThreshold<bsdvr::constants::BSDVR_THRESHOLD> DefaultThreshold;
+
+/**
+ * \ingroup bsdvr
+ * \brief Binary state route comparison, parameterised by a hop threshold policy
+ *
+ * With StaticThreshold the threshold folds into the comparison, which keeps
+ * the route selection loop in ComputeForwardingTable free of loads and calls.
+ */
+template <class ThresholdPolicy>
+class RouteComparator
+{
+public:
+  /**
+   * constructor
+   * \param policy the hop threshold policy
+   */
+  explicit RouteComparator (ThresholdPolicy policy = ThresholdPolicy ())
+    : m_policy (policy)
+  {
+  }
+  /**
+   * Find if a route to a destination is better than an alternative route
+   * \param r1 routing entry for a given destination
+   * \param r2 alternative routing entry for the same destination
+   * \returns true in success
+   */
+  bool operator() (RoutingTableEntry const & r1, RoutingTableEntry const & r2) const
+  {
+    u_int32_t new_hopCount = r2.GetHop ();
+    u_int32_t curr_hopCount = r1.GetHop ();
+    if (r2.GetRouteState () == ACTIVE)
+      {
+        return (r1.GetRouteState () == ACTIVE) ? (curr_hopCount > new_hopCount)
+                                               : (new_hopCount < m_policy.Get ());
+      }
+    return (r1.GetRouteState () == ACTIVE) ? (curr_hopCount > m_policy.Get ())
+                                           : (curr_hopCount > new_hopCount);
+  }
+private:
+  ThresholdPolicy m_policy;  ///< hop threshold policy
+};
+
 }  // namespace bsdvr
 }  // namespace ns3
 
@@ -0,0 +1,226 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "bsdvr-stats.h"
+
+namespace ns3 {
+namespace bsdvr {
+
+Statistics::Statistics ()
+{
+  Reset ();
+}
+
+void
+Statistics::Reset ()
+{
+  m_updatesSent = 0;
+  m_updatesReceived = 0;
+  m_hellosSent = 0;
+  m_hellosReceived = 0;
+  m_triggeredBatches = 0;
+  m_ftComputations = 0;
+  m_destinationsEvaluated = 0;
+  m_ftChanges = 0;
+  m_queueEnqueues = 0;
+  m_queueDrops = 0;
+  m_queueDrains = 0;
+  m_pendingReplyEnqueues = 0;
+  m_pendingReplyExpirations = 0;
+  m_linkFailures = 0;
+}
+
+Statistics &
+Statistics::operator+= (Statistics const & o)
+{
+  m_updatesSent += o.m_updatesSent;
+  m_updatesReceived += o.m_updatesReceived;
+  m_hellosSent += o.m_hellosSent;
+  m_hellosReceived += o.m_hellosReceived;
+  m_triggeredBatches += o.m_triggeredBatches;
+  m_ftComputations += o.m_ftComputations;
+  m_destinationsEvaluated += o.m_destinationsEvaluated;
+  m_ftChanges += o.m_ftChanges;
+  m_queueEnqueues += o.m_queueEnqueues;
+  m_queueDrops += o.m_queueDrops;
+  m_queueDrains += o.m_queueDrains;
+  m_pendingReplyEnqueues += o.m_pendingReplyEnqueues;
+  m_pendingReplyExpirations += o.m_pendingReplyExpirations;
+  m_linkFailures += o.m_linkFailures;
+  return *this;
+}
+
+void
+Statistics::Print (std::ostream & os) const
+{
+  os << "UpdatesSent " << m_updatesSent << std::endl
+     << "UpdatesReceived " << m_updatesReceived << std::endl
+     << "HellosSent " << m_hellosSent << std::endl
+     << "HellosReceived " << m_hellosReceived << std::endl
+     << "TriggeredBatches " << m_triggeredBatches << std::endl
+     << "FtComputations " << m_ftComputations << std::endl
+     << "DestinationsEvaluated " << m_destinationsEvaluated << std::endl
+     << "FtChanges " << m_ftChanges << std::endl
+     << "QueueEnqueues " << m_queueEnqueues << std::endl
+     << "QueueDrops " << m_queueDrops << std::endl
+     << "QueueDrains " << m_queueDrains << std::endl
+     << "PendingReplyEnqueues " << m_pendingReplyEnqueues << std::endl
+     << "PendingReplyExpirations " << m_pendingReplyExpirations << std::endl
+     << "LinkFailures " << m_linkFailures << std::endl;
+}
+
+void
+Statistics::PrintCsvHeader (std::ostream & os)
+{
+  os << "updatesSent,updatesReceived,hellosSent,hellosReceived,triggeredBatches,"
+     << "ftComputations,destinationsEvaluated,ftChanges,queueEnqueues,queueDrops,"
+     << "queueDrains,pendingReplyEnqueues,pendingReplyExpirations,linkFailures";
+}
+
+void
+Statistics::PrintCsv (std::ostream & os) const
+{
+  os << m_updatesSent << "," << m_updatesReceived << ","
+     << m_hellosSent << "," << m_hellosReceived << ","
+     << m_triggeredBatches << "," << m_ftComputations << ","
+     << m_destinationsEvaluated << "," << m_ftChanges << ","
+     << m_queueEnqueues << "," << m_queueDrops << ","
+     << m_queueDrains << "," << m_pendingReplyEnqueues << ","
+     << m_pendingReplyExpirations << "," << m_linkFailures;
+}
+
+std::ostream &
+operator<< (std::ostream & os, Statistics const & s)
+{
+  s.Print (os);
+  return os;
+}
+
+MemoryUsage::MemoryUsage ()
+  : m_forwardingTable (0),
+    m_distanceVectorTable (0),
+    m_routes (0),
+    m_neighbors (0),
+    m_queue (0),
+    m_pendingReplyQueue (0)
+{
+}
+
+uint64_t
+MemoryUsage::GetTotal () const
+{
+  return m_forwardingTable + m_distanceVectorTable + m_routes
+         + m_neighbors + m_queue + m_pendingReplyQueue;
+}
+
+MemoryUsage &
+MemoryUsage::operator+= (MemoryUsage const & o)
+{
+  m_forwardingTable += o.m_forwardingTable;
+  m_distanceVectorTable += o.m_distanceVectorTable;
+  m_routes += o.m_routes;
+  m_neighbors += o.m_neighbors;
+  m_queue += o.m_queue;
+  m_pendingReplyQueue += o.m_pendingReplyQueue;
+  return *this;
+}
+
+void
+MemoryUsage::Print (std::ostream & os) const
+{
+  os << "ForwardingTable " << m_forwardingTable << std::endl
+     << "DistanceVectorTable " << m_distanceVectorTable << std::endl
+     << "Routes " << m_routes << std::endl
+     << "Neighbors " << m_neighbors << std::endl
+     << "Queue " << m_queue << std::endl
+     << "PendingReplyQueue " << m_pendingReplyQueue << std::endl
+     << "Total " << GetTotal () << std::endl;
+}
+
+void
+MemoryUsage::PrintCsvHeader (std::ostream & os)
+{
+  os << "forwardingTable,distanceVectorTable,routes,neighbors,queue,pendingReplyQueue,total";
+}
+
+void
+MemoryUsage::PrintCsv (std::ostream & os) const
+{
+  os << m_forwardingTable << "," << m_distanceVectorTable << ","
+     << m_routes << "," << m_neighbors << ","
+     << m_queue << "," << m_pendingReplyQueue << "," << GetTotal ();
+}
+
+std::ostream &
+operator<< (std::ostream & os, MemoryUsage const & m)
+{
+  m.Print (os);
+  return os;
+}
+
+DelayHistogram::DelayHistogram ()
+  : m_count (0),
+    m_totalUs (0),
+    m_maxUs (0)
+{
+  for (uint32_t b = 0; b < BUCKETS; b++)
+    {
+      m_buckets[b] = 0;
+    }
+}
+
+void
+DelayHistogram::Add (Time delay)
+{
+  uint64_t us = delay.IsStrictlyPositive () ? delay.GetMicroSeconds () : 0;
+  m_count++;
+  m_totalUs += us;
+  if (us > m_maxUs)
+    {
+      m_maxUs = us;
+    }
+  uint32_t b = 0;
+  while ((us >> (b + 1)) != 0 && b < BUCKETS - 1)
+    {
+      b++;
+    }
+  m_buckets[b]++;
+}
+
+DelayHistogram &
+DelayHistogram::operator+= (DelayHistogram const & o)
+{
+  m_count += o.m_count;
+  m_totalUs += o.m_totalUs;
+  if (o.m_maxUs > m_maxUs)
+    {
+      m_maxUs = o.m_maxUs;
+    }
+  for (uint32_t b = 0; b < BUCKETS; b++)
+    {
+      m_buckets[b] += o.m_buckets[b];
+    }
+  return *this;
+}
+
+Time
+DelayHistogram::GetMean () const
+{
+  return MicroSeconds (m_count ? m_totalUs / m_count : 0);
+}
+
+void
+DelayHistogram::Print (std::ostream & os) const
+{
+  os << "Count " << m_count << std::endl
+     << "MeanUs " << (m_count ? m_totalUs / m_count : 0) << std::endl
+     << "MaxUs " << m_maxUs << std::endl;
+  for (uint32_t b = 0; b < BUCKETS; b++)
+    {
+      if (m_buckets[b] != 0)
+        {
+          os << ">=" << (b == 0 ? 0 : uint64_t (1) << b) << "us " << m_buckets[b] << std::endl;
+        }
+    }
+}
+
+}  // namespace bsdvr
+}  // namespace ns3
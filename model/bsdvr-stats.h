@@ -0,0 +1,179 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef BSDVRSTATS_H
+#define BSDVRSTATS_H
+
+#include <stdint.h>
+#include <ostream>
+#include "ns3/nstime.h"
+
+namespace ns3 {
+namespace bsdvr {
+
+/**
+ * \ingroup bsdvr
+ * \brief Routing statistics counters of a BSDVR instance
+ */
+class Statistics
+{
+public:
+  /// constructor
+  Statistics ();
+  /// Reset all counters to zero
+  void Reset ();
+  /**
+   * Add the counters of another instance
+   * \param o the statistics to add
+   * \returns this object
+   */
+  Statistics & operator+= (Statistics const & o);
+  /**
+   * Print the counters, one "name value" pair per line
+   * \param os the output stream
+   */
+  void Print (std::ostream & os) const;
+  /**
+   * Print the counter names as a CSV header line
+   * \param os the output stream
+   */
+  static void PrintCsvHeader (std::ostream & os);
+  /**
+   * Print the counters as a CSV line
+   * \param os the output stream
+   */
+  void PrintCsv (std::ostream & os) const;
+
+  uint64_t m_updatesSent;             ///< UPDATE messages sent
+  uint64_t m_updatesReceived;         ///< UPDATE messages received
+  uint64_t m_hellosSent;              ///< HELLO messages sent
+  uint64_t m_hellosReceived;          ///< HELLO messages received
+  uint64_t m_triggeredBatches;        ///< batches of triggered UPDATEs sent
+  uint64_t m_ftComputations;          ///< ComputeForwardingTable invocations
+  uint64_t m_destinationsEvaluated;   ///< DVT entries evaluated by ComputeForwardingTable
+  uint64_t m_ftChanges;               ///< forwarding table changes reported by ComputeForwardingTable
+  uint64_t m_queueEnqueues;           ///< data packets deferred in the queue
+  uint64_t m_queueDrops;              ///< data packets dropped from, or refused by, the queue
+  uint64_t m_queueDrains;             ///< data packets sent from the queue
+  uint64_t m_pendingReplyEnqueues;    ///< pending reply entries queued
+  uint64_t m_pendingReplyExpirations; ///< pending reply entries whose timer expired
+  uint64_t m_linkFailures;            ///< neighbor link failures handled, outside the filtered 10.1.1.x range
+};
+
+/**
+  * \brief Stream output operator
+  * \param os output stream
+  * \param s the statistics
+  * \return updated stream
+  */
+std::ostream & operator<< (std::ostream & os, Statistics const & s);
+
+/**
+ * \ingroup bsdvr
+ * \brief Estimated heap footprint of a BSDVR instance, in bytes
+ *
+ * Estimates count element sizes plus a per-node overhead for std::map
+ * nodes; allocator headers and padding are not included.
+ */
+class MemoryUsage
+{
+public:
+  /// constructor
+  MemoryUsage ();
+  /**
+   * \returns the sum of all components
+   */
+  uint64_t GetTotal () const;
+  /**
+   * Add the components of another instance
+   * \param o the memory usage to add
+   * \returns this object
+   */
+  MemoryUsage & operator+= (MemoryUsage const & o);
+  /**
+   * Print the components, one "name bytes" pair per line
+   * \param os the output stream
+   */
+  void Print (std::ostream & os) const;
+  /**
+   * Print the component names as a CSV header line
+   * \param os the output stream
+   */
+  static void PrintCsvHeader (std::ostream & os);
+  /**
+   * Print the components as a CSV line
+   * \param os the output stream
+   */
+  void PrintCsv (std::ostream & os) const;
+
+  uint64_t m_forwardingTable;     ///< FT map nodes and entries
+  uint64_t m_distanceVectorTable; ///< DVT outer and per-neighbor maps and entries
+  uint64_t m_routes;              ///< Ipv4Route objects referenced by FT and DVT entries
+  uint64_t m_neighbors;           ///< neighbor vectors
+  uint64_t m_queue;               ///< deferred data packets and their queue entries
+  uint64_t m_pendingReplyQueue;   ///< pending reply entries
+};
+
+/**
+  * \brief Stream output operator
+  * \param os output stream
+  * \param m the memory usage
+  * \return updated stream
+  */
+std::ostream & operator<< (std::ostream & os, MemoryUsage const & m);
+
+/**
+ * \ingroup bsdvr
+ * \brief Log2 histogram of delays, in microseconds
+ */
+class DelayHistogram
+{
+public:
+  /// Number of buckets; bucket i > 0 counts delays in [2^i, 2^(i+1)) us
+  static const uint32_t BUCKETS = 32;
+  /// constructor
+  DelayHistogram ();
+  /**
+   * Account one delay
+   * \param delay the delay
+   */
+  void Add (Time delay);
+  /**
+   * Add the samples of another histogram
+   * \param o the histogram to add
+   * \returns this object
+   */
+  DelayHistogram & operator+= (DelayHistogram const & o);
+  /**
+   * \returns the number of samples
+   */
+  uint64_t GetCount () const
+  {
+    return m_count;
+  }
+  /**
+   * \returns the mean delay, zero without samples
+   */
+  Time GetMean () const;
+  /**
+   * \returns the largest delay
+   */
+  Time GetMax () const
+  {
+    return MicroSeconds (m_maxUs);
+  }
+  /**
+   * Print count, mean, max and the non-empty buckets
+   * \param os the output stream
+   */
+  void Print (std::ostream & os) const;
+
+private:
+  uint64_t m_count;              ///< number of samples
+  uint64_t m_totalUs;            ///< sum of the delays
+  uint64_t m_maxUs;              ///< largest delay
+  uint64_t m_buckets[BUCKETS];   ///< log2 histogram
+};
+
+}  // namespace bsdvr
+}  // namespace ns3
+
+#endif /* BSDVRSTATS_H */
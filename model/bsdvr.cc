@@ -4,8 +4,11 @@
   if (m_ipv4) { std::clog << "[node " << m_ipv4->GetObject<Node> ()->GetId () << "] "; }
 
 #include "bsdvr.h"
+#include "bsdvr-profiler.h"
+#include "bsdvr-diag.h"
 #include "ns3/log.h"
 #include "ns3/boolean.h"
+#include "ns3/enum.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/trace-source-accessor.h"
@@ -114,7 +117,8 @@ NS_OBJECT_ENSURE_REGISTERED (DeferredRouteOutputTag);
 
 //-----------------------------------------------------------------------------
 RoutingProtocol::RoutingProtocol ()
-  : m_enableHello (false),
+  : m_engine (m_routingTable),
+    m_enableHello (false),
     m_helloInterval (Seconds (1)),
     m_nb (m_helloInterval),
     m_maxQueueLen (64),
@@ -122,11 +126,27 @@ RoutingProtocol::RoutingProtocol ()
     m_maxPRQueueLen (50),
     m_maxPRQueueTime (Seconds (1)),
     m_prqueue (m_maxPRQueueLen, m_maxPRQueueTime),
+    m_enableHelloPiggyback (false),
+    m_maxHelloRecords (32),
+    m_splitHorizon (NO_SPLIT_HORIZON),
+    m_threshold (bsdvr::constants::BSDVR_THRESHOLD),
+    m_routeLogCapacity (0),
+    m_enableSnapshot (false),
+    m_snapshotFragmentSize (1400),
+    m_snapshotTimeout (MilliSeconds (200)),
+    m_snapshotMaxRetries (3),
+    m_snapshotId (0),
+    m_enableReliableUpdate (false),
+    m_updateRetransmitTimeout (MilliSeconds (100)),
+    m_updateMaxRetransmissions (3),
+    m_updateAckDelay (MilliSeconds (20)),
     m_htimer (Timer::CANCEL_ON_DESTROY),
     m_lastBcastTime (Seconds (0))
 {
   m_nb.SetCallback (MakeCallback (&RoutingProtocol::SendUpdateOnLinkFailure, this));
   m_prqueue.SetCallback (MakeCallback (&RoutingProtocol::SendUpdateOnPendingReplyEntryTimeout, this));
+  m_queue.SetDropCallback (MakeCallback (&RoutingProtocol::NotifyQueueDrop, this));
+  m_engine.SetDiagnosticCallback (MakeCallback (&RoutingProtocol::ReportDiagnostic, this));
 }
 
 TypeId
@@ -166,11 +186,91 @@ RoutingProtocol::GetTypeId (void)
                    MakeBooleanAccessor (&RoutingProtocol::SetBroadcastEnable,
                                         &RoutingProtocol::GetBroadcastEnable),
                    MakeBooleanChecker ())
+    .AddAttribute ("EnableHelloPiggyback", "Indicates whether pending forwarding table changes are carried by HELLO messages.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_enableHelloPiggyback),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxHelloRecords", "Maximum number of route records piggybacked on a single HELLO message.",
+                   UintegerValue (32),
+                   MakeUintegerAccessor (&RoutingProtocol::m_maxHelloRecords),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("SplitHorizon", "Split horizon mode applied to UPDATE messages sent to the next hop of a route.",
+                   EnumValue (NO_SPLIT_HORIZON),
+                   MakeEnumAccessor (&RoutingProtocol::m_splitHorizon),
+                   MakeEnumChecker (NO_SPLIT_HORIZON, "None",
+                                    SPLIT_HORIZON, "SplitHorizon",
+                                    POISONED_REVERSE, "PoisonedReverse"))
+    .AddAttribute ("HopThreshold", "Hop count beyond which a route is treated as unreachable.",
+                   UintegerValue (bsdvr::constants::BSDVR_THRESHOLD),
+                   MakeUintegerAccessor (&RoutingProtocol::SetHopThreshold,
+                                         &RoutingProtocol::GetHopThreshold),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("EnableSnapshot", "Indicates whether a new neighbor receives the forwarding table as a fragmented snapshot.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_enableSnapshot),
+                   MakeBooleanChecker ())
+    .AddAttribute ("SnapshotFragmentSize", "Maximum size of a snapshot fragment, in bytes.",
+                   UintegerValue (1400),
+                   MakeUintegerAccessor (&RoutingProtocol::m_snapshotFragmentSize),
+                   MakeUintegerChecker<uint32_t> (SnapshotHeader::FIXED_SIZE + SnapshotHeader::RECORD_SIZE + 1))
+    .AddAttribute ("SnapshotTimeout", "Time to wait for a snapshot acknowledgment before retransmitting.",
+                   TimeValue (MilliSeconds (200)),
+                   MakeTimeAccessor (&RoutingProtocol::m_snapshotTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("SnapshotMaxRetries", "Maximum number of snapshot retransmission rounds.",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&RoutingProtocol::m_snapshotMaxRetries),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RouteLogCapacity", "Number of records of the binary route change log, 0 disables it.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RoutingProtocol::m_routeLogCapacity),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RouteLogFile", "File the route change log is appended to when full, truncated by the first write of the run, empty to keep an in-memory ring.",
+                   StringValue (""),
+                   MakeStringAccessor (&RoutingProtocol::m_routeLogFile),
+                   MakeStringChecker ())
+    .AddAttribute ("EnableReliableUpdate", "Indicates whether UPDATE messages are sequenced, acknowledged and retransmitted.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_enableReliableUpdate),
+                   MakeBooleanChecker ())
+    .AddAttribute ("UpdateRetransmitTimeout", "Time to wait for an UPDATE acknowledgment before retransmitting.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&RoutingProtocol::m_updateRetransmitTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("UpdateMaxRetransmissions", "Maximum number of retransmissions of a single UPDATE.",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&RoutingProtocol::m_updateMaxRetransmissions),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("UpdateAckDelay", "Time an UPDATE acknowledgment is held back to cover more UPDATEs or ride on a HELLO.",
+                   TimeValue (MilliSeconds (20)),
+                   MakeTimeAccessor (&RoutingProtocol::m_updateAckDelay),
+                   MakeTimeChecker ())
     .AddAttribute ("UniformRv",
                    "Access to the underlying UniformRandomVariable",
                    StringValue ("ns3::UniformRandomVariable"),
                    MakePointerAccessor (&RoutingProtocol::m_uniformRandomVariable),
                    MakePointerChecker<UniformRandomVariable> ())
+    .AddTraceSource ("Tx", "A control message is transmitted.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_txTrace),
+                     "ns3::bsdvr::RoutingProtocol::ControlTracedCallback")
+    .AddTraceSource ("Rx", "A control message is received.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_rxTrace),
+                     "ns3::bsdvr::RoutingProtocol::ControlTracedCallback")
+    .AddTraceSource ("RouteChange", "A forwarding table entry changed.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_routeChangeTrace),
+                     "ns3::bsdvr::RoutingProtocol::RouteChangeTracedCallback")
+    .AddTraceSource ("Diagnostic", "A control-plane diagnostic, only fired up to the compiled-in BSDVR_DIAG_LEVEL.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_diagTrace),
+                     "ns3::bsdvr::RoutingProtocol::DiagnosticTracedCallback")
+    .AddTraceSource ("QueueEnqueue", "A data packet entered the deferred queue.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_queueEnqueueTrace),
+                     "ns3::bsdvr::RoutingProtocol::QueueEnqueueTracedCallback")
+    .AddTraceSource ("QueueDrain", "A data packet was sent from the deferred queue.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_queueDrainTrace),
+                     "ns3::bsdvr::RoutingProtocol::QueueDrainTracedCallback")
+    .AddTraceSource ("QueueDrop", "A data packet was dropped from, or refused by, the deferred queue.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_queueDropTrace),
+                     "ns3::bsdvr::RoutingProtocol::QueueDropTracedCallback")
     ;
   return tid;
 }
@@ -199,6 +299,7 @@ RoutingProtocol::~RoutingProtocol ()
 void
 RoutingProtocol::DoDispose ()
 {
+  m_routeLog.Flush ();
   m_ipv4 = 0;
   for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::iterator iter = 
        m_socketAddresses.begin (); iter != m_socketAddresses.end (); iter++)
@@ -212,6 +313,25 @@ RoutingProtocol::DoDispose ()
       iter->first->Close ();
     }
   m_socketSubnetBroadcastAddresses.clear ();
+  for (std::map<Ipv4Address, SnapshotTransfer>::iterator iter = m_snapshotTx.begin ();
+       iter != m_snapshotTx.end (); ++iter)
+    {
+      iter->second.m_timer.Cancel ();
+    }
+  m_snapshotTx.clear ();
+  m_snapshotRx.clear ();
+  for (std::map<Ipv4Address, UpdateTxState>::iterator iter = m_updateTx.begin ();
+       iter != m_updateTx.end (); ++iter)
+    {
+      iter->second.m_timer.Cancel ();
+    }
+  m_updateTx.clear ();
+  for (std::map<Ipv4Address, UpdateRxState>::iterator iter = m_updateRx.begin ();
+       iter != m_updateRx.end (); ++iter)
+    {
+      iter->second.m_ackTimer.Cancel ();
+    }
+  m_updateRx.clear ();
   Ipv4RoutingProtocol::DoDispose ();
 }
 
@@ -222,11 +342,17 @@ RoutingProtocol::PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit
                         << "; Time: " << Now ().As (unit)
                         << ", Local time: " << m_ipv4->GetObject<Node> ()->GetLocalTime ().As (unit)
                         << ", BSDVR Routing table" << std::endl;
-  std::map<Ipv4Address, RoutingTableEntry> ft = m_routingTable.GetForwardingTablePrint ();                 
-  m_routingTable.Print (&ft, stream, unit);
+  m_routingTable.Print (m_routingTable.GetForwardingTable (), stream, unit);
   *stream->GetStream () << std::endl;
 }
 
+void
+RoutingProtocol::DumpRoutingTable (std::ostream & os, TableDumpFormat format, bool includeDvt) const
+{
+  m_routingTable.Dump (os, format, Simulator::Now ().GetNanoSeconds (),
+                       m_ipv4->GetObject<Node> ()->GetId (), includeDvt);
+}
+
 int64_t 
 RoutingProtocol::AssignStreams (int64_t stream)
 {
@@ -235,6 +361,29 @@ RoutingProtocol::AssignStreams (int64_t stream)
   return 1;
 }
 
+Statistics
+RoutingProtocol::GetStatistics () const
+{
+  Statistics stats = m_stats;
+  stats += m_engine.GetStatistics ();
+  stats.m_queueDrops = m_queue.GetDropCount ();
+  stats.m_pendingReplyExpirations = m_prqueue.GetExpiredCount ();
+  return stats;
+}
+
+MemoryUsage
+RoutingProtocol::GetMemoryUsage () const
+{
+  MemoryUsage usage;
+  usage.m_forwardingTable = m_routingTable.GetForwardingTableMemoryUsage ();
+  usage.m_distanceVectorTable = m_routingTable.GetDistanceVectorTableMemoryUsage ();
+  usage.m_routes = m_routingTable.GetRouteMemoryUsage ();
+  usage.m_neighbors = m_nb.GetMemoryUsage ();
+  usage.m_queue = m_queue.GetMemoryUsage ();
+  usage.m_pendingReplyQueue = m_prqueue.GetMemoryUsage ();
+  return usage;
+}
+
 void
 RoutingProtocol::DoInitialize (void)
 {
@@ -247,6 +396,10 @@ RoutingProtocol::DoInitialize (void)
       NS_LOG_DEBUG ("Starting at time " << startTime << "ms");
       m_htimer.Schedule (MilliSeconds (startTime));
     }
+  if (m_routeLogCapacity > 0)
+    {
+      m_routeLog.Setup (m_ipv4->GetObject<Node> ()->GetId (), m_routeLogCapacity, m_routeLogFile);
+    }
   Ipv4RoutingProtocol::DoInitialize ();
 }
 
@@ -365,6 +518,11 @@ RoutingProtocol::DeferredRouteOutput (Ptr<const Packet> p, const Ipv4Header & he
   bool result = m_queue.Enqueue (newEntry);
   if (result)
     {
+      m_stats.m_queueEnqueues++;
+      if (!m_queueEnqueueTrace.IsEmpty ())
+        {
+          m_queueEnqueueTrace (p, header.GetDestination ());
+        }
       NS_LOG_LOGIC ("Add packet " << p->GetUid () << " to queue. Protocol " << (uint16_t) header.GetProtocol ());
     }
 }
@@ -587,6 +745,7 @@ RoutingProtocol::NotifyInterfaceUp (uint32_t i)
   if (m_mainAddress == Ipv4Address ())
     {
       m_mainAddress = iface.GetLocal ();
+      m_engine.SetMainAddress (m_mainAddress);
     }
   NS_ASSERT (m_mainAddress != Ipv4Address ());
 
@@ -652,6 +811,7 @@ RoutingProtocol::NotifyInterfaceDown (uint32_t i)
       NS_LOG_LOGIC ("No bsdvr interfaces");
       m_htimer.Cancel ();
       m_nb.Clear ();
+      m_engine.ClearNeighbors ();
       m_routingTable.Clear (); // clears forwarding table
       return;
     }
@@ -774,6 +934,7 @@ RoutingProtocol::NotifyRemoveAddress (uint32_t i, Ipv4InterfaceAddress address)
           NS_LOG_LOGIC ("No bsdvr interfaces");
           m_htimer.Cancel ();
           m_nb.Clear ();
+          m_engine.ClearNeighbors ();
           m_routingTable.Clear ();
           return;
         }
@@ -859,54 +1020,79 @@ RoutingProtocol::ProcessHello (HelloHeader const & hlHeader, Ipv4Address receive
   NS_LOG_FUNCTION (this << "from " << origin);
   if (m_enableHello)
     {
+      // Known to the engine first: a link closed by this Update still sees it
+      m_engine.AddNeighbor (origin);
       m_nb.Update (origin, Time (m_helloInterval));
     }
-  /*
-   *  Whenever a node receives a Hello message from a neighbor, the node
-   * SHOULD make sure that it has an active route to the neighbor, and
-   * create one if necessary in dvt.
-   */
-  RoutingTableEntry toNeighbor;
-  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >* dvt = m_routingTable.GetDistanceVectorTable ();
-  /// NOTE: use of find () instead of [] handles index errors better, change at end
-  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >::iterator dvt_iter;
-  for (dvt_iter = dvt->begin (); dvt_iter != dvt->end(); ++dvt_iter)
+  int32_t interface = m_ipv4->GetInterfaceForAddress (receiver);
+  RoutingTableEntry link (/*device=*/ m_ipv4->GetNetDevice (interface), /*dst=*/ origin,
+                          /*iface=*/ m_ipv4->GetAddress (interface, 0),
+                          /*hops=*/ 1, /*next hop=*/ origin, /*changedEntries*/ false);
+  EngineOutput out;
+  m_engine.SetRecordRouteChanges (IsRouteChangeObserved ());
+  if (m_engine.LinkUp (link, out))
     {
-      if (dvt_iter->first == origin)
+      RecordRouteChanges (out, CAUSE_HELLO);
+      ///NOTE: assuming this is the point a new connection is setup between two nodes to 
+      ///      perform the initial exchange of distance vectors. (SYN + SYN-ACK)
+      //====================== FIXME ======================
+      if (m_enableSnapshot)
         {
-          break;
+          SendSnapshotToNeighbor (origin, link.GetInterface ());
         }
+      else
+        {
+          SendTriggeredUpdateToNeighbor (origin);
+        }
+      // SendTriggeredUpdateChangesToNeighbors (changes, nex);
     }
-  std::map<Ipv4Address, RoutingTableEntry>* dv;
-  if (dvt_iter == dvt->end ())
+  if (hlHeader.GetRecordCount () > 0)
     {
-      dvt->insert (std::make_pair (origin, new std::map<Ipv4Address, RoutingTableEntry> ()));
+      ProcessRouteRecords (hlHeader.GetRecords (), receiver, origin, CAUSE_HELLO);
     }
-  dv = (*dvt)[origin]; // neighbor node's dv
-  if (!m_routingTable.LookupRoute (origin, toNeighbor, dv))
+  std::vector<AckBlock> const & acks = hlHeader.GetAcks ();
+  for (std::vector<AckBlock>::const_iterator b = acks.begin (); b != acks.end (); ++b)
     {
-      std::list<Ipv4Address> nex;
-      std::list<Ipv4Address> changes;
-      Ptr<NetDevice> dev = m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (receiver));
-      RoutingTableEntry newEntry (/*device=*/ dev, /*dst=*/ origin, 
-                                  /*iface=*/ m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (receiver), 0),
-                                  /*hops=*/ 1, /*next hop=*/ origin, /*changedEntries*/ false);
-      m_routingTable.AddRoute (newEntry, dv);
-      changes = ComputeForwardingTable ();
-      ///NOTE: assuming this is the point a new connection is setup between two nodes to 
-      ///      perform the initial exchange of distance vectors. (SYN + SYN-ACK)
-      //====================== FIXME ======================
-      SendTriggeredUpdateToNeighbor (origin);
-      // SendTriggeredUpdateChangesToNeighbors (changes, nex);
+      if (IsMyOwnAddress (b->m_neighbor))
+        {
+          ProcessUpdateAck (origin, *b);
+        }
     }
-  else
+}
+void
+RoutingProtocol::ProcessRouteRecords (std::vector<RouteRecord> const & records, Ipv4Address my, Ipv4Address src,
+                                      RouteChangeCause cause)
+{
+  NS_LOG_FUNCTION (this << " src " << src << " records " << records.size ());
+  Ptr<NetDevice> dev = m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (my));
+  Ipv4InterfaceAddress iface = m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (my), 0);
+  std::list<UpdateHeader> inactive;
+  m_engine.SetRecordRouteChanges (IsRouteChangeObserved ());
+  for (std::vector<RouteRecord>::const_iterator r = records.begin (); r != records.end (); ++r)
     {
-      toNeighbor.SetOutputDevice (m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (receiver)));
-      toNeighbor.SetInterface (m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (receiver), 0));
-      toNeighbor.SetHop (1);
-      toNeighbor.SetNextHop (origin);
-      m_routingTable.Update(toNeighbor, dv);
+      if (IsMyOwnAddress (r->m_dst))
+        {
+          continue;
+        }
+      RoutingTableEntry rt (/*device=*/ dev, /*dst=*/ r->m_dst, /*iface=*/ iface,
+                            /*hops=*/ r->m_hopCount + 1, /*next hop=*/ src, /*changedEntries*/ false);
+      rt.SetRouteState ((r->m_binaryState == 1) ? ACTIVE : INACTIVE);
+      m_engine.UpdateDistanceVectorTable (src, rt);
+      if (r->m_binaryState == 0 && r->m_dst != src)
+        {
+          inactive.push_back (UpdateHeader (/*origin*/src, /*dst*/r->m_dst, /*hops*/r->m_hopCount, /*state*/r->m_binaryState));
+        }
     }
+  EngineOutput out;
+  m_engine.ComputeForwardingTable (out);
+  for (std::list<UpdateHeader>::iterator u = inactive.begin (); u != inactive.end (); ++u)
+    {
+      m_engine.RetransmitToNeighbor (u->GetOrigin (), u->GetDst (), u->GetHopCount (), out);
+    }
+  RecordRouteChanges (out, cause);
+  ScheduleTriggeredUpdateChanges (out.m_changes, out.m_excluded);
+  SendEngineReplies (out);
+  SendQueuedPackets ();
 }
 //-----------------------------------------------------------------------------
 
@@ -947,6 +1133,11 @@ RoutingProtocol::RecvBsdv (Ptr<Socket> socket)
       NS_LOG_DEBUG ("BSDVR message " << packet->GetUid () << " with unknown type received: " << tHeader.Get () << ". Drop");
       return; // drop
     }
+  if (!m_rxTrace.IsEmpty () && tHeader.Get () != BSDVRTYPE_HELLO && tHeader.Get () != BSDVRTYPE_UPDATE)
+    {
+      // HELLO and UPDATE are traced with their contents once parsed
+      m_rxTrace (tHeader.Get (), sender, Ipv4Address (), 0, 0, packetSize);
+    }
   switch (tHeader.Get ())
     {
       case BSDVRTYPE_HELLO:
@@ -959,6 +1150,21 @@ RoutingProtocol::RecvBsdv (Ptr<Socket> socket)
           RecvUpdate (packet, receiver, sender);
           break;
         }
+      case BSDVRTYPE_SNAPSHOT:
+        {
+          RecvSnapshot (packet, receiver, sender);
+          break;
+        }
+      case BSDVRTYPE_SNAPSHOT_ACK:
+        {
+          RecvSnapshotAck (packet, receiver, sender);
+          break;
+        }
+      case BSDVRTYPE_UPDATE_ACK:
+        {
+          RecvUpdateAck (packet, receiver, sender);
+          break;
+        }
     }
 }
 void 
@@ -966,7 +1172,13 @@ RoutingProtocol::RecvHello (Ptr<Packet> p, Ipv4Address my, Ipv4Address src)
 {
   NS_LOG_FUNCTION (this << " src " << src);
   HelloHeader hlHeader;
+  uint32_t bytes = p->GetSize () + TypeHeader ().GetSerializedSize ();
   p->RemoveHeader (hlHeader);
+  m_stats.m_hellosReceived++;
+  if (!m_rxTrace.IsEmpty ())
+    {
+      m_rxTrace (BSDVRTYPE_HELLO, src, hlHeader.GetDst (), 0, 0, bytes);
+    }
   NS_LOG_LOGIC ("HELLO destination " << my << " HELLO origin " << hlHeader.GetOrigin ());
   // Confirming HELLO message
   if ((hlHeader.GetDst () == hlHeader.GetOrigin ()))
@@ -978,13 +1190,29 @@ RoutingProtocol::RecvHello (Ptr<Packet> p, Ipv4Address my, Ipv4Address src)
 void 
 RoutingProtocol::RecvUpdate (Ptr<Packet> p, Ipv4Address my, Ipv4Address src)
 {
+  BSDVR_PROFILE_SCOPE (RECV_UPDATE);
   NS_LOG_FUNCTION (this << " src " << src);
   UpdateHeader uptHeader;
-  std::list<Ipv4Address> nex;
+  uint32_t bytes = p->GetSize () + TypeHeader ().GetSerializedSize ();
   p->RemoveHeader (uptHeader);
+  m_stats.m_updatesReceived++;
+  if (!m_rxTrace.IsEmpty ())
+    {
+      m_rxTrace (BSDVRTYPE_UPDATE, src, uptHeader.GetDst (), uptHeader.GetHopCount (), uptHeader.GetBinaryState (), bytes);
+    }
   Ipv4Address dst = uptHeader.GetDst ();
   NS_LOG_LOGIC ("UPDATE destination " << dst << " UPDATE origin " << uptHeader.GetOrigin ());
-  uint8_t hop = uptHeader.GetHopCount () + 1;
+  if (uptHeader.GetSeqNo () != 0 && !AcceptUpdateSeqNo (src, my, uptHeader))
+    {
+      NS_LOG_LOGIC ("Duplicate UPDATE " << uptHeader.GetSeqNo () << " from " << src);
+      return;
+    }
+  uint32_t hop = uptHeader.GetHopCount () + 1;
+  if (uptHeader.GetBinaryState () == UPDATE_STATE_POISONED)
+    {
+      // A poisoned route goes through this node: keep it at least one hop beyond the threshold
+      hop = std::max<uint32_t> (hop, m_threshold + 1);
+    }
   /*
    * If the route table entry to the destination is created or updated :
    * - the route is added/updated in the distance vector table <= UpdateDistanceVectorTable ()
@@ -993,6 +1221,9 @@ RoutingProtocol::RecvUpdate (Ptr<Packet> p, Ipv4Address my, Ipv4Address src)
    * 
    * If UPDATE message is INACTIVE and not on primary path:
    * - initiate pending reply timer <= PendingReplyEnqueue ()
+   *
+   * A poisoned UPDATE is stored as INACTIVE but never starts a pending reply,
+   * as it only tells that the sender's route goes through this node.
    */
   uint32_t state = uptHeader.GetBinaryState ();
   RouteState rs = (state == 1) ? ACTIVE : INACTIVE;
@@ -1001,30 +1232,160 @@ RoutingProtocol::RecvUpdate (Ptr<Packet> p, Ipv4Address my, Ipv4Address src)
                         /*iface=*/ m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (my), 0),
                         /*hops=*/ hop, /*next hop=*/ src, /*changedEntries*/ false);
   rt.SetRouteState (rs);
-  UpdateDistanceVectorTable (src, rt);
-  std::list<Ipv4Address> changes = ComputeForwardingTable ();
+  // An ACTIVE UPDATE for a destination we hold INACTIVE answers our own INACTIVE advertisement
+  RouteChangeCause cause = CAUSE_UPDATE;
+  std::map<Ipv4Address, RoutingTableEntry>::const_iterator held = m_routingTable.GetForwardingTable ()->find (dst);
+  if (rs == ACTIVE && held != m_routingTable.GetForwardingTable ()->end () && held->second.GetRouteState () == INACTIVE)
+    {
+      cause = CAUSE_PENDING_REPLY;
+    }
+  EngineOutput out;
+  m_engine.SetRecordRouteChanges (IsRouteChangeObserved ());
+  m_engine.RecvUpdate (rt, uptHeader.GetOrigin (), uptHeader.GetHopCount (), state, out);
+  RecordRouteChanges (out, cause);
   /// NOTE: Add Broadcast changes function here
-  SendTriggeredUpdateChangesToNeighbors (changes, nex);
+  ScheduleTriggeredUpdateChanges (out.m_changes, out.m_excluded);
   /// NOTE: Add Re-Transmit current entry function here
-  if (state == 0 && dst != uptHeader.GetOrigin ())
+  SendEngineReplies (out);
+  /// NOTE: Send buffered packets
+  SendQueuedPackets ();
+}
+void
+RoutingProtocol::RecvSnapshot (Ptr<Packet> p, Ipv4Address my, Ipv4Address src)
+{
+  NS_LOG_FUNCTION (this << " src " << src);
+  SnapshotHeader snHeader;
+  p->RemoveHeader (snHeader);
+  uint16_t id = snHeader.GetId ();
+  uint16_t index = snHeader.GetFragmentIndex ();
+  uint16_t count = snHeader.GetFragmentCount ();
+  NS_LOG_LOGIC ("SNAPSHOT " << id << " fragment " << index << "/" << count << " from " << src);
+  if (count == 0 || index >= count)
+    {
+      NS_LOG_DEBUG ("Malformed SNAPSHOT fragment from " << src << ". Drop");
+      return;
+    }
+  std::map<Ipv4Address, SnapshotReception>::iterator r = m_snapshotRx.find (src);
+  if (r != m_snapshotRx.end () && r->second.m_id != id && (int16_t)(id - r->second.m_id) < 0)
     {
-      RetransmitToNeighbor (uptHeader);
+      NS_LOG_DEBUG ("Stale SNAPSHOT " << id << " from " << src << ". Drop");
+      return;
     }
-  /// NOTE: Send buffered packets
-  // std::map<Ipv4Address, RoutingTableEntry>::iterator ft_entry;
-  std::map<Ipv4Address, RoutingTableEntry>* ft = m_routingTable.GetForwardingTable ();
-  // for (std::list<Ipv4Address>::const_iterator i = changes.begin (); i != changes.end (); ++i)
-  //   {
-  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = ft->begin (); i != ft->end (); ++i)
+  SnapshotReception & rx = m_snapshotRx[src];
+  if (r == m_snapshotRx.end () || rx.m_id != id || rx.m_received.size () != count)
     {
-      // ft_entry = ft->find(*i);
-      // if (ft_entry != ft->end())
-        // {
-      if (m_queue.Find (i->first))
+      rx.m_id = id;
+      rx.m_received.assign (count, false);
+      rx.m_next = 0;
+      rx.m_lastSeen = false;
+    }
+  // Records go through the regular DVT update path as soon as they arrive.
+  // Acknowledgments are only sent when the last fragment arrives, when a
+  // fragment reveals a new gap and when a retransmission completes the
+  // snapshot, so that duplicates do not trigger further retransmissions.
+  bool ack = (index == count - 1);
+  if (!rx.m_received[index])
+    {
+      rx.m_received[index] = true;
+      ProcessRouteRecords (snHeader.GetRecords (), my, src, CAUSE_SNAPSHOT);
+      ack = ack || index > rx.m_next
+        || (rx.m_lastSeen && std::find (rx.m_received.begin (), rx.m_received.end (), false) == rx.m_received.end ());
+    }
+  rx.m_next = std::max<uint16_t> (rx.m_next, index + 1);
+  if (index == count - 1)
+    {
+      rx.m_lastSeen = true;
+    }
+  if (ack)
+    {
+      SendSnapshotAck (src, my, rx);
+    }
+}
+void
+RoutingProtocol::RecvSnapshotAck (Ptr<Packet> p, Ipv4Address my, Ipv4Address src)
+{
+  NS_LOG_FUNCTION (this << " src " << src);
+  SnapshotAckHeader ackHeader;
+  p->RemoveHeader (ackHeader);
+  std::map<Ipv4Address, SnapshotTransfer>::iterator t = m_snapshotTx.find (src);
+  if (t == m_snapshotTx.end () || t->second.m_id != ackHeader.GetId ())
+    {
+      NS_LOG_LOGIC ("SNAPSHOT_ACK " << ackHeader.GetId () << " from " << src << " matches no transfer");
+      return;
+    }
+  SnapshotTransfer & tx = t->second;
+  std::vector<bool> acked (tx.m_fragments.size (), true);
+  std::vector<uint16_t> const & missing = ackHeader.GetMissing ();
+  for (std::vector<uint16_t>::const_iterator m = missing.begin (); m != missing.end (); ++m)
+    {
+      if (*m < acked.size ())
         {
-          SendPacketFromQueue (i->first, i->second.GetRoute (), i->second.GetRouteState ());
+          acked[*m] = false;
         }
-        // }
+    }
+  tx.m_acked = acked;
+  if (std::find (tx.m_acked.begin (), tx.m_acked.end (), false) == tx.m_acked.end ())
+    {
+      NS_LOG_LOGIC ("SNAPSHOT " << tx.m_id << " to " << src << " complete");
+      tx.m_timer.Cancel ();
+      m_snapshotTx.erase (t);
+      return;
+    }
+  // Selective retransmission of the fragments reported missing; the
+  // retransmission timer keeps running for the ones sent too recently
+  RetransmitSnapshotFragments (src, tx);
+}
+void
+RoutingProtocol::RecvUpdateAck (Ptr<Packet> p, Ipv4Address my, Ipv4Address src)
+{
+  NS_LOG_FUNCTION (this << " src " << src);
+  UpdateAckHeader ackHeader;
+  p->RemoveHeader (ackHeader);
+  ProcessUpdateAck (src, ackHeader.GetAck ());
+}
+bool
+RoutingProtocol::AcceptUpdateSeqNo (Ipv4Address src, Ipv4Address my, UpdateHeader const & upt)
+{
+  uint32_t seqNo = upt.GetSeqNo ();
+  UpdateRxState & rx = m_updateRx[src];
+  rx.m_my = my;
+  // The sender no longer waits for anything older than its oldest unacknowledged UPDATE
+  if (upt.GetOldestUnacked () > rx.m_cumAck + 1)
+    {
+      rx.m_cumAck = upt.GetOldestUnacked () - 1;
+      rx.m_sack.erase (rx.m_sack.begin (), rx.m_sack.upper_bound (rx.m_cumAck));
+    }
+  bool fresh = seqNo > rx.m_cumAck && rx.m_sack.insert (seqNo).second;
+  while (!rx.m_sack.empty () && *rx.m_sack.begin () == rx.m_cumAck + 1)
+    {
+      rx.m_cumAck++;
+      rx.m_sack.erase (rx.m_sack.begin ());
+    }
+  // Duplicates are acknowledged again, as the previous acknowledgment may have been lost
+  if (!rx.m_ackTimer.IsRunning ())
+    {
+      rx.m_ackTimer = Simulator::Schedule (m_updateAckDelay, &RoutingProtocol::SendUpdateAck, this, src);
+    }
+  return fresh;
+}
+void
+RoutingProtocol::ProcessUpdateAck (Ipv4Address ne, AckBlock const & ack)
+{
+  NS_LOG_FUNCTION (this << ne << ack.m_cumAck << ack.m_sack.size ());
+  std::map<Ipv4Address, UpdateTxState>::iterator t = m_updateTx.find (ne);
+  if (t == m_updateTx.end ())
+    {
+      return;
+    }
+  UpdateTxState & tx = t->second;
+  tx.m_unacked.erase (tx.m_unacked.begin (), tx.m_unacked.upper_bound (ack.m_cumAck));
+  for (std::vector<uint32_t>::const_iterator s = ack.m_sack.begin (); s != ack.m_sack.end (); ++s)
+    {
+      tx.m_unacked.erase (*s);
+    }
+  if (tx.m_unacked.empty ())
+    {
+      tx.m_timer.Cancel ();
     }
 }
 
@@ -1039,6 +1400,8 @@ RoutingProtocol::SendHello ()
   NS_LOG_FUNCTION (this);
   /// FIXME: Calling Purge () here temporarily
   m_nb.Purge ();
+  std::map<Ipv4Address, RoutingTableEntry>* ft = m_routingTable.GetForwardingTable ();
+  std::map<Ipv4Address, RoutingTableEntry>::iterator ft_entry;
   /* Broadcast a Hello message with TTL = 1 */
   for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin ();
        j != m_socketAddresses.end (); ++j)
@@ -1046,6 +1409,36 @@ RoutingProtocol::SendHello ()
       Ptr<Socket> socket = j->first;
       Ipv4InterfaceAddress iface = j->second;
       HelloHeader hlHeader (iface.GetLocal (), iface.GetLocal ());
+      // Acknowledgments still held back for neighbors on this interface ride on the HELLO
+      for (std::map<Ipv4Address, UpdateRxState>::iterator r = m_updateRx.begin (); r != m_updateRx.end (); ++r)
+        {
+          if (r->second.m_ackTimer.IsRunning () && r->second.m_my == iface.GetLocal ())
+            {
+              hlHeader.AddAck (MakeAckBlock (r->first, r->second));
+              r->second.m_ackTimer.Cancel ();
+            }
+        }
+      // Piggyback pending changes reachable through this interface, in their current FT state.
+      // HELLO is a broadcast, so split horizon does not apply to these records.
+      std::list<Ipv4Address>::iterator c = m_helloPendingChanges.begin ();
+      while (c != m_helloPendingChanges.end () && hlHeader.GetRecordCount () < m_maxHelloRecords)
+        {
+          ft_entry = ft->find (*c);
+          if (ft_entry == ft->end ())
+            {
+              c = m_helloPendingChanges.erase (c);
+            }
+          else if (ft_entry->second.GetInterface () == iface)
+            {
+              uint32_t state = (ft_entry->second.GetRouteState () == ACTIVE) ? 1 : 0;
+              hlHeader.AddRecord (RouteRecord (/*dst*/ft_entry->first, /*hops*/ft_entry->second.GetHop (), /*state*/state));
+              c = m_helloPendingChanges.erase (c);
+            }
+          else
+            {
+              ++c;
+            }
+        }
       Ptr<Packet> packet = Create<Packet> ();
       SocketIpTtlTag tag;
       tag.SetTtl (1);
@@ -1065,12 +1458,34 @@ RoutingProtocol::SendHello ()
           destination = iface.GetBroadcast ();
         }
       Time jitter = Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10)));
+      m_stats.m_hellosSent++;
       Simulator::Schedule (jitter, &RoutingProtocol::SendTo, this, socket, packet, destination);
     }
+  // Changes that did not fit into this HELLO have waited long enough
+  if (!m_helloPendingChanges.empty ())
+    {
+      std::list<Ipv4Address> nex;
+      SendTriggeredUpdateChangesToNeighbors (m_helloPendingChanges, nex);
+      m_helloPendingChanges.clear ();
+    }
+}
+void
+RoutingProtocol::SendQueuedPackets ()
+{
+  NS_LOG_FUNCTION (this);
+  std::map<Ipv4Address, RoutingTableEntry>* ft = m_routingTable.GetForwardingTable ();
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = ft->begin (); i != ft->end (); ++i)
+    {
+      if (m_queue.Find (i->first))
+        {
+          SendPacketFromQueue (i->first, i->second.GetRoute (), i->second.GetRouteState ());
+        }
+    }
 }
 void 
 RoutingProtocol::SendPacketFromQueue (Ipv4Address dst, Ptr<Ipv4Route> route, RouteState state)
 {
+  BSDVR_PROFILE_SCOPE (SEND_PACKET_FROM_QUEUE);
   NS_LOG_FUNCTION (this);
   QueueEntry queueEntry;
   u_int32_t sval = (state == ACTIVE) ? 2 : 1; 
@@ -1083,26 +1498,68 @@ RoutingProtocol::SendPacketFromQueue (Ipv4Address dst, Ptr<Ipv4Route> route, Rou
           && tag.GetInterface () != m_ipv4->GetInterfaceForDevice (route->GetOutputDevice ()))
         {
           NS_LOG_DEBUG ("Output device doesn't match. Dropped.");
+          m_queue.DropEntry (queueEntry, "Output device mismatch");
           return;
         }
       UnicastForwardCallback ucb = queueEntry.GetUnicastForwardCallback ();
       Ipv4Header header = queueEntry.GetIpv4Header ();
       header.SetSource (route->GetSource ());
       header.SetTtl (header.GetTtl () + 1); // compensate extra TTL decrement by fake loopback routing
+      m_stats.m_queueDrains++;
+      Time delay = Simulator::Now () - queueEntry.GetEnqueueTime ();
+      m_queueDelay.Add (delay);
+      if (!m_queueDrainTrace.IsEmpty ())
+        {
+          m_queueDrainTrace (p, dst, delay, queueEntry.GetStatus ().Get ());
+        }
       ucb (route, p, header);
     }
 }
 void 
-RoutingProtocol::SendUpdate (/*ft entry=*/ RoutingTableEntry const & rt, /*neighbor*/Ipv4Address const & ne)
+RoutingProtocol::SendUpdate (/*ft entry=*/ RoutingTableEntry const & rt, /*neighbor*/Ipv4Address const & ne, bool poisoned, uint32_t seqNo)
 {
-  NS_LOG_FUNCTION (this << rt.GetDestination ());
+  NS_LOG_FUNCTION (this << rt.GetDestination () << poisoned << seqNo);
   ///NOTE: set packet header value over here
   u_int32_t hops = rt.GetHop ();
   Ipv4Address dst = rt.GetDestination ();
   Ipv4Address origin = rt.GetInterface ().GetLocal ();
   uint32_t state = (rt.GetRouteState () == ACTIVE) ? 1 : 0;
+  if (poisoned)
+    {
+      hops = m_threshold;
+      state = UPDATE_STATE_POISONED;
+    }
 
   UpdateHeader uptHeader (/*origin*/origin, /*dst*/dst, /*hops*/hops, /*state*/state);
+  if (m_enableReliableUpdate)
+    {
+      UpdateTxState & tx = m_updateTx[ne];
+      if (seqNo == 0)
+        {
+          // A newer UPDATE for the same destination supersedes the unacknowledged ones
+          std::map<uint32_t, UnackedUpdate>::iterator u = tx.m_unacked.begin ();
+          while (u != tx.m_unacked.end ())
+            {
+              if (u->second.m_dst == dst)
+                {
+                  tx.m_unacked.erase (u++);
+                }
+              else
+                {
+                  ++u;
+                }
+            }
+          seqNo = tx.m_nextSeq++;
+          tx.m_unacked[seqNo].m_dst = dst;
+          tx.m_unacked[seqNo].m_retries = 0;
+        }
+      tx.m_unacked[seqNo].m_sent = Simulator::Now ();
+      uptHeader.SetSeqNo (seqNo, tx.m_unacked.begin ()->first);
+      if (!tx.m_timer.IsRunning ())
+        {
+          tx.m_timer = Simulator::Schedule (m_updateRetransmitTimeout, &RoutingProtocol::UpdateRetransmitTimerExpire, this, ne);
+        }
+    }
   
   Ptr<Packet> packet =  Create<Packet> ();
   SocketIpTtlTag tag;
@@ -1113,516 +1570,507 @@ RoutingProtocol::SendUpdate (/*ft entry=*/ RoutingTableEntry const & rt, /*neigh
   packet->AddHeader (tHeader);
   Ptr<Socket> socket = FindSocketWithInterfaceAddress (rt.GetInterface ());
   NS_ASSERT (socket);
+  if (!m_txTrace.IsEmpty ())
+    {
+      m_txTrace (BSDVRTYPE_UPDATE, ne, dst, hops, state, packet->GetSize ());
+    }
+  m_stats.m_updatesSent++;
   socket->SendTo (packet, 0, InetSocketAddress (ne, BSDVR_PORT));
 }
 void 
-RoutingProtocol::SendUpdateOnLinkFailure (Ipv4Address ne)
+RoutingProtocol::SendUpdateToNeighbor (RoutingTableEntry const & rt, Ipv4Address const & ne)
 {
-  /// FIXME: make filter upper bound dynamic for variable number of nodes in the network
-  if ((Ipv4Address ("10.1.1.0") < ne) && (ne) < Ipv4Address ("10.1.1.51"))
+  RouteRecord r;
+  if (MakeAdvertisement (rt, ne, r))
     {
-      return;
+      SendUpdate (rt, ne, /*poisoned*/ r.m_binaryState == UPDATE_STATE_POISONED);
     }
+}
+bool
+RoutingProtocol::MakeAdvertisement (RoutingTableEntry const & rt, Ipv4Address const & ne, RouteRecord & r) const
+{
+  r.m_dst = rt.GetDestination ();
+  r.m_hopCount = rt.GetHop ();
+  r.m_binaryState = (rt.GetRouteState () == ACTIVE) ? UPDATE_STATE_ACTIVE : UPDATE_STATE_INACTIVE;
+  if (m_splitHorizon == NO_SPLIT_HORIZON || rt.GetNextHop () != ne)
+    {
+      return true;
+    }
+  if (m_splitHorizon == POISONED_REVERSE)
+    {
+      r.m_hopCount = m_threshold;
+      r.m_binaryState = UPDATE_STATE_POISONED;
+      return true;
+    }
+  NS_LOG_LOGIC ("Split horizon: not advertising " << rt.GetDestination () << " to its next hop " << ne);
+  return false;
+}
+void
+RoutingProtocol::SendSnapshotToNeighbor (Ipv4Address ne, Ipv4InterfaceAddress iface)
+{
   NS_LOG_FUNCTION (this << ne);
-  std::list<Ipv4Address> nex;
-  std::list<Ipv4Address> changes;
-  std::map<Ipv4Address, RoutingTableEntry>::iterator n_dvt_entry;
-  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>*>::iterator n_dvt;
-  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* > *dvt = m_routingTable.GetDistanceVectorTable ();
-  for (n_dvt = dvt->begin (); n_dvt != dvt->end (); ++n_dvt)
-    {
-      if (n_dvt->first == ne)
+  std::map<Ipv4Address, SnapshotTransfer>::iterator old = m_snapshotTx.find (ne);
+  if (old != m_snapshotTx.end ())
+    {
+      old->second.m_timer.Cancel ();
+      m_snapshotTx.erase (old);
+    }
+  // The type header takes one byte in front of the snapshot header
+  uint32_t perFragment = 1;
+  if (m_snapshotFragmentSize > SnapshotHeader::FIXED_SIZE + 1 + SnapshotHeader::RECORD_SIZE)
+    {
+      perFragment = (m_snapshotFragmentSize - SnapshotHeader::FIXED_SIZE - 1) / SnapshotHeader::RECORD_SIZE;
+    }
+  // Fragments only fix which destinations they carry; records are filled in
+  // from the forwarding table every time a fragment is (re)transmitted.
+  std::vector<std::vector<Ipv4Address> > fragments;
+  std::vector<Ipv4Address> fragment;
+  std::map<Ipv4Address, RoutingTableEntry>* ft = m_routingTable.GetForwardingTable ();
+  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = ft->begin ();
+       i != ft->end (); ++i)
+    {
+      if (i->second.GetDestination () == Ipv4Address ())
+      {
+        continue;
+      }
+      /// FIXME: revisit if this filter is still required and is working as intended
+      if (i->first == m_mainAddress || i->first == ne || i->first == Ipv4Address ("127.0.0.1"))
         {
-          break;
+          continue;
+        }
+      if (fragment.size () == perFragment)
+        {
+          fragments.push_back (fragment);
+          fragment.clear ();
         }
+      fragment.push_back (i->first);
     }
-  if (n_dvt != dvt->end ())
+  if (!fragment.empty ())
     {
-      n_dvt_entry = (*dvt)[ne]->find(ne);
-      if (n_dvt_entry != (*dvt)[ne]->end ())
+      fragments.push_back (fragment);
+    }
+  if (fragments.empty ())
+    {
+      return;
+    }
+  NS_ASSERT (fragments.size () <= std::numeric_limits<uint16_t>::max ());
+  SnapshotTransfer & tx = m_snapshotTx[ne];
+  tx.m_id = ++m_snapshotId;
+  tx.m_iface = iface;
+  tx.m_fragments = fragments;
+  tx.m_acked.assign (fragments.size (), false);
+  tx.m_sent.assign (fragments.size (), Simulator::Now ());
+  tx.m_retries = 0;
+  NS_LOG_LOGIC ("SNAPSHOT " << tx.m_id << " to " << ne << " in " << fragments.size () << " fragments");
+  for (uint16_t k = 0; k < fragments.size (); ++k)
+    {
+      SendSnapshotFragment (ne, k);
+    }
+  tx.m_timer = Simulator::Schedule (m_snapshotTimeout, &RoutingProtocol::SnapshotTimerExpire, this, ne);
+}
+void
+RoutingProtocol::SendSnapshotFragment (Ipv4Address ne, uint16_t index)
+{
+  std::map<Ipv4Address, SnapshotTransfer>::iterator t = m_snapshotTx.find (ne);
+  NS_ASSERT (t != m_snapshotTx.end () && index < t->second.m_fragments.size ());
+  SnapshotTransfer & tx = t->second;
+  tx.m_sent[index] = Simulator::Now ();
+  SnapshotHeader snHeader (/*origin*/tx.m_iface.GetLocal (), /*id*/tx.m_id, /*index*/index, /*count*/tx.m_fragments.size ());
+  std::map<Ipv4Address, RoutingTableEntry>::iterator ft_entry;
+  std::map<Ipv4Address, RoutingTableEntry>* ft = m_routingTable.GetForwardingTable ();
+  std::vector<Ipv4Address> const & fragment = tx.m_fragments[index];
+  for (std::vector<Ipv4Address>::const_iterator d = fragment.begin (); d != fragment.end (); ++d)
+    {
+      ft_entry = ft->find (*d);
+      RouteRecord r;
+      if (ft_entry != ft->end () && MakeAdvertisement (ft_entry->second, ne, r))
         {
-          nex.push_back (ne);
-          RoutingTableEntry rt = n_dvt_entry->second;
-          rt.SetRouteState (INACTIVE);
-          UpdateDistanceVectorTable (ne, rt);
-          changes = ComputeForwardingTable ();
-          SendTriggeredUpdateChangesToNeighbors (changes, nex);
+          snHeader.AddRecord (r);
         }
     }
+  Ptr<Packet> packet = Create<Packet> ();
+  SocketIpTtlTag tag;
+  tag.SetTtl (1);
+  packet->AddPacketTag (tag);
+  packet->AddHeader (snHeader);
+  TypeHeader tHeader (BSDVRTYPE_SNAPSHOT);
+  packet->AddHeader (tHeader);
+  Ptr<Socket> socket = FindSocketWithInterfaceAddress (tx.m_iface);
+  if (!socket)
+    {
+      NS_LOG_DEBUG ("No socket for interface " << tx.m_iface.GetLocal () << ", SNAPSHOT fragment not sent");
+      return;
+    }
+  if (!m_txTrace.IsEmpty ())
+    {
+      m_txTrace (BSDVRTYPE_SNAPSHOT, ne, Ipv4Address (), 0, 0, packet->GetSize ());
+    }
+  socket->SendTo (packet, 0, InetSocketAddress (ne, BSDVR_PORT));
 }
-void 
-RoutingProtocol::SendUpdateOnPendingReplyEntryTimeout (PendingReplyEntry en)
+void
+RoutingProtocol::SendSnapshotAck (Ipv4Address ne, Ipv4Address my, SnapshotReception const & rx)
 {
-  Ipv4Address ne = en.GetNeighbor ();
-  Ipv4Address dst = en.GetDestination ();
-  std::vector<Neighbors::Neighbor> neighbors = m_nb.GetNeighbors ();
-  std::map<Ipv4Address, RoutingTableEntry>* ft = m_routingTable.GetForwardingTable ();
-  // Iterators
-  std::vector<Neighbors::Neighbor>::iterator ne_find;
-  std::map<Ipv4Address, RoutingTableEntry>::iterator dst_find;
-  /// FIXME: make filter upper bound dynamic for variable number of nodes in the network
-  if ((Ipv4Address ("10.1.1.0") < ne) && (ne) < Ipv4Address ("10.1.1.51"))
+  SnapshotAckHeader ackHeader (/*origin*/my, /*id*/rx.m_id);
+  for (uint16_t k = 0; k < rx.m_received.size (); ++k)
+    {
+      if (!rx.m_received[k])
+        {
+          ackHeader.AddMissing (k);
+        }
+    }
+  Ptr<Packet> packet = Create<Packet> ();
+  SocketIpTtlTag tag;
+  tag.SetTtl (1);
+  packet->AddPacketTag (tag);
+  packet->AddHeader (ackHeader);
+  TypeHeader tHeader (BSDVRTYPE_SNAPSHOT_ACK);
+  packet->AddHeader (tHeader);
+  Ptr<Socket> socket = FindSocketWithInterfaceAddress (m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (my), 0));
+  NS_ASSERT (socket);
+  if (!m_txTrace.IsEmpty ())
+    {
+      m_txTrace (BSDVRTYPE_SNAPSHOT_ACK, ne, Ipv4Address (), 0, 0, packet->GetSize ());
+    }
+  socket->SendTo (packet, 0, InetSocketAddress (ne, BSDVR_PORT));
+}
+void
+RoutingProtocol::SnapshotTimerExpire (Ipv4Address ne)
+{
+  NS_LOG_FUNCTION (this << ne);
+  std::map<Ipv4Address, SnapshotTransfer>::iterator t = m_snapshotTx.find (ne);
+  if (t == m_snapshotTx.end ())
     {
       return;
     }
-  NS_LOG_FUNCTION (this << "Sending pending reply to " << ne << " for destination " << dst);
-  for (ne_find = neighbors.begin (); ne_find != neighbors.end (); ++ne_find)
+  SnapshotTransfer & tx = t->second;
+  bool due = false;
+  for (uint16_t k = 0; k < tx.m_acked.size (); ++k)
     {
-      if (ne_find->m_neighborAddress == ne)
+      due = due || (!tx.m_acked[k] && tx.m_sent[k] + m_snapshotTimeout <= Simulator::Now ());
+    }
+  // The fragments an acknowledgment had retransmitted meanwhile are not due yet
+  if (due)
+    {
+      if (tx.m_retries >= m_snapshotMaxRetries)
         {
-          break;
+          // Routes in the lost fragments still reach the neighbor through later UPDATEs
+          NS_LOG_DEBUG ("SNAPSHOT " << tx.m_id << " to " << ne << " abandoned after " << tx.m_retries << " retries");
+          m_snapshotTx.erase (t);
+          return;
         }
+      tx.m_retries++;
+      RetransmitSnapshotFragments (ne, tx);
     }
-  dst_find = ft->find (dst);
-  // Checking if neighbor still active and dst entry available in ft
-  if (dst_find != ft->end () && ne_find != neighbors.end ())
+  Time next = Time::Max ();
+  for (uint16_t k = 0; k < tx.m_acked.size (); ++k)
     {
-      if (dst_find->second.GetRouteState () == ACTIVE && dst_find->second.GetNextHop () != ne)
+      if (!tx.m_acked[k])
         {
-          // sending pending reply to neighbor
-          std::cout << "Sending Update to " << ne << "after expiry of pending reply timer" << std::endl;
-          SendUpdate (dst_find->second, ne);
+          next = std::min (next, tx.m_sent[k] + m_snapshotTimeout);
         }
     }
+  tx.m_timer = Simulator::Schedule (next - Simulator::Now (), &RoutingProtocol::SnapshotTimerExpire, this, ne);
 }
-void 
-RoutingProtocol::SendTriggeredUpdateToNeighbor (Ipv4Address ne)
+void
+RoutingProtocol::RetransmitSnapshotFragments (Ipv4Address ne, SnapshotTransfer const & tx)
 {
-  std::map<Ipv4Address, RoutingTableEntry>* ft = m_routingTable.GetForwardingTable ();
-  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = ft->begin ();
-       i != ft->end (); ++i)
+  for (uint16_t k = 0; k < tx.m_acked.size (); ++k)
     {
-      if (i->second.GetDestination () == Ipv4Address ())
-      {
-        continue;
-      }
-      /// FIXME: revisit if this filter is still required and is working as intended
-      if (i->first != m_mainAddress && i->first != ne && i->first != Ipv4Address ("127.0.0.1"))
+      // At most one retransmission of a fragment per SnapshotTimeout
+      if (!tx.m_acked[k] && tx.m_sent[k] + m_snapshotTimeout <= Simulator::Now ())
         {
-          SendUpdate (i->second, ne);
+          SendSnapshotFragment (ne, k);
         }
     }
 }
-void 
-RoutingProtocol::SendTriggeredUpdateChangesToNeighbors (std::list<Ipv4Address> changes, std::list<Ipv4Address> nex)
+AckBlock
+RoutingProtocol::MakeAckBlock (Ipv4Address ne, UpdateRxState const & rx) const
 {
-  NS_LOG_FUNCTION (this << nex.size () << changes.size ());
-  std::list<Ipv4Address>::iterator n;
+  AckBlock ack (/*neighbor*/ne, /*cumulative ack*/rx.m_cumAck);
+  ack.m_sack.assign (rx.m_sack.begin (), rx.m_sack.end ());
+  return ack;
+}
+void
+RoutingProtocol::SendUpdateAck (Ipv4Address ne)
+{
+  std::map<Ipv4Address, UpdateRxState>::iterator r = m_updateRx.find (ne);
+  if (r == m_updateRx.end ())
+    {
+      return;
+    }
+  UpdateRxState & rx = r->second;
+  rx.m_ackTimer.Cancel ();
+  NS_LOG_FUNCTION (this << ne << rx.m_cumAck << rx.m_sack.size ());
+  UpdateAckHeader ackHeader (/*origin*/rx.m_my, /*ack*/MakeAckBlock (ne, rx));
+  Ptr<Packet> packet = Create<Packet> ();
+  SocketIpTtlTag tag;
+  tag.SetTtl (1);
+  packet->AddPacketTag (tag);
+  packet->AddHeader (ackHeader);
+  TypeHeader tHeader (BSDVRTYPE_UPDATE_ACK);
+  packet->AddHeader (tHeader);
+  Ptr<Socket> socket = FindSocketWithInterfaceAddress (m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (rx.m_my), 0));
+  if (!socket)
+    {
+      NS_LOG_DEBUG ("No socket for interface " << rx.m_my << ", UPDATE_ACK not sent");
+      return;
+    }
+  if (!m_txTrace.IsEmpty ())
+    {
+      m_txTrace (BSDVRTYPE_UPDATE_ACK, ne, Ipv4Address (), 0, 0, packet->GetSize ());
+    }
+  socket->SendTo (packet, 0, InetSocketAddress (ne, BSDVR_PORT));
+}
+void
+RoutingProtocol::UpdateRetransmitTimerExpire (Ipv4Address ne)
+{
+  NS_LOG_FUNCTION (this << ne);
+  std::map<Ipv4Address, UpdateTxState>::iterator t = m_updateTx.find (ne);
+  if (t == m_updateTx.end ())
+    {
+      return;
+    }
+  UpdateTxState & tx = t->second;
   std::map<Ipv4Address, RoutingTableEntry>::iterator ft_entry;
-  std::vector<Neighbors::Neighbor> neighbors = m_nb.GetNeighbors ();
   std::map<Ipv4Address, RoutingTableEntry>* ft = m_routingTable.GetForwardingTable ();
-  for (std::vector<Neighbors::Neighbor>::const_iterator i = neighbors.begin ();
-       i != neighbors.end (); ++i)
+  std::map<uint32_t, UnackedUpdate>::iterator u = tx.m_unacked.begin ();
+  while (u != tx.m_unacked.end ())
     {
-      Ipv4Address ne = i->m_neighborAddress;
-      /// FIXME: Improve search in neighbor vector
-      for (n = nex.begin (); n != nex.end (); ++n)
+      if (u->second.m_sent + m_updateRetransmitTimeout > Simulator::Now ())
         {
-          if (*n == ne)
-            {
-              break;
-            }
+          ++u;
+          continue;
         }
-      if (n == nex.end ())
+      if (u->second.m_retries >= m_updateMaxRetransmissions)
         {
-          for (std::list<Ipv4Address>::const_iterator j = changes.begin ();
-               j != changes.end (); ++j)
-            {
-              ft_entry = ft->find(*j);
-              if (ft_entry != ft->end ())
-                {
-                  if (ft_entry->first != ne)
-                  {
-                    SendUpdate (ft_entry->second, ne);
-                  }
-                }
-            }
+          NS_LOG_DEBUG ("UPDATE " << u->first << " for " << u->second.m_dst << " to " << ne << " abandoned");
+          tx.m_unacked.erase (u++);
+          continue;
+        }
+      // Only the unacknowledged record is retransmitted, in its current forwarding table state
+      RouteRecord r;
+      ft_entry = ft->find (u->second.m_dst);
+      if (ft_entry == ft->end () || !MakeAdvertisement (ft_entry->second, ne, r))
+        {
+          tx.m_unacked.erase (u++);
+          continue;
+        }
+      u->second.m_retries++;
+      uint32_t seqNo = u->first;
+      ++u;
+      SendUpdate (ft_entry->second, ne, /*poisoned*/ r.m_binaryState == UPDATE_STATE_POISONED, seqNo);
+    }
+  tx.m_timer.Cancel ();
+  if (!tx.m_unacked.empty ())
+    {
+      Time next = Time::Max ();
+      for (u = tx.m_unacked.begin (); u != tx.m_unacked.end (); ++u)
+        {
+          next = std::min (next, u->second.m_sent + m_updateRetransmitTimeout);
         }
+      tx.m_timer = Simulator::Schedule (next - Simulator::Now (), &RoutingProtocol::UpdateRetransmitTimerExpire, this, ne);
     }
 }
 void 
-RoutingProtocol::SendTo (Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address destination)
+RoutingProtocol::SendUpdateOnLinkFailure (Ipv4Address ne)
 {
-  socket->SendTo (packet, 0, InetSocketAddress (destination, BSDVR_PORT)); 
+  /// FIXME: make filter upper bound dynamic for variable number of nodes in the network
+  if ((Ipv4Address ("10.1.1.0") < ne) && (ne) < Ipv4Address ("10.1.1.51"))
+    {
+      m_engine.RemoveNeighbor (ne);
+      return;
+    }
+  m_stats.m_linkFailures++;
+  NS_LOG_FUNCTION (this << ne);
+  std::map<Ipv4Address, SnapshotTransfer>::iterator tx = m_snapshotTx.find (ne);
+  if (tx != m_snapshotTx.end ())
+    {
+      tx->second.m_timer.Cancel ();
+      m_snapshotTx.erase (tx);
+    }
+  m_snapshotRx.erase (ne);
+  // Sequence numbers keep increasing across link failures, only outstanding state is dropped
+  std::map<Ipv4Address, UpdateTxState>::iterator utx = m_updateTx.find (ne);
+  if (utx != m_updateTx.end ())
+    {
+      utx->second.m_timer.Cancel ();
+      utx->second.m_unacked.clear ();
+    }
+  std::map<Ipv4Address, UpdateRxState>::iterator urx = m_updateRx.find (ne);
+  if (urx != m_updateRx.end ())
+    {
+      urx->second.m_ackTimer.Cancel ();
+      m_updateRx.erase (urx);
+    }
+  EngineOutput out;
+  m_engine.SetRecordRouteChanges (IsRouteChangeObserved ());
+  m_engine.LinkDown (ne, out);
+  RecordRouteChanges (out, CAUSE_LINK_FAILURE);
+  SendTriggeredUpdateChangesToNeighbors (out.m_changes, out.m_excluded);
 }
-
-//-----------------------------------------------------------------------------
-
-/*
- BSDVR Control Plane Functions
- */
-
-bool 
-RoutingProtocol::isBetterRoute (RoutingTableEntry & r1, RoutingTableEntry & r2)
+void 
+RoutingProtocol::SendUpdateOnPendingReplyEntryTimeout (PendingReplyEntry en)
 {
-  u_int32_t new_hopCount = r2.GetHop ();
-  u_int32_t curr_hopCount = r1.GetHop ();
-  RouteState new_state = r2.GetRouteState ();
-  RouteState curr_state  = r1.GetRouteState ();
-
-  switch (new_state)
-    {
-    case ACTIVE:
-      {
-        if (curr_state == ACTIVE)
-          {
-            return (curr_hopCount <= new_hopCount) ? false : true; 
-          }
-        else if (curr_state == INACTIVE)
-          {
-            return (new_hopCount < bsdvr::constants::BSDVR_THRESHOLD) ? true : false;
-          }
-        break;
-      }
-    case INACTIVE:
-      {
-        if (curr_state == ACTIVE)
-          {
-            return (curr_hopCount <= bsdvr::constants::BSDVR_THRESHOLD) ? false : true; 
-          }
-        else if (curr_state == INACTIVE)
-          {
-            return (curr_hopCount <= new_hopCount) ? false : true;
-          }
-        break;
-      }  
-    }
-   
-  return false;
+  EngineOutput out;
+  m_engine.PendingReplyTimeout (en.GetNeighbor (), en.GetDestination (), out);
+  SendEngineReplies (out);
 }
-
 void 
-RoutingProtocol::RemoveFakeRoutes (Ipv4Address nxtHp, RoutingTableEntry & rt)
+RoutingProtocol::SendTriggeredUpdateToNeighbor (Ipv4Address ne)
 {
-  Ipv4Address curr_dst;
-  Ipv4Address curr_nxtHp;
-  RouteState curr_state;
-  std::list<Ipv4Address> fake_dsts;
-  Ipv4Address dst = rt.GetDestination ();
-  std::vector<Neighbors::Neighbor>::iterator n;
-  /// FIXME: Make sure the getter returns a pointer to actual rtable to allow insert and removal of entries
-  std::vector<Neighbors::Neighbor> m_neighbors =  m_nb.GetNeighbors();
-  std::map<Ipv4Address, RoutingTableEntry> *ft = m_routingTable.GetForwardingTable ();
-  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator i = ft->begin (); i != ft->end (); i++)
-    {
-      curr_dst = i->first;
-      curr_nxtHp = i->second.GetNextHop ();
-      curr_state = i->second.GetRouteState ();
-      if (curr_state == ACTIVE && rt.GetRouteState () == INACTIVE)
-        {
-          if (nxtHp == curr_nxtHp && dst == curr_dst)
-            {
-              fake_dsts.push_back (curr_dst);
-            }
-          /// TODO: Confirm if neighbor check works right
-          for (n = m_neighbors.begin (); n != m_neighbors.end (); ++n)
-            {
-              if (n->m_neighborAddress == nxtHp)
-                {
-                  break;
-                }
-            }
-          if (nxtHp == dst && n != m_neighbors.end ())
-            {
-            if (curr_nxtHp == nxtHp && dst != curr_dst)
-              {
-                fake_dsts.push_back (curr_dst);
-              }
-            }
-        }
+  m_stats.m_triggeredBatches++;
+  std::vector<EngineMessage> messages;
+  m_engine.GetFullUpdate (ne, messages);
+  SendEngineMessages (messages, false);
+}
+void 
+RoutingProtocol::SendTriggeredUpdateChangesToNeighbors (std::list<Ipv4Address> changes, std::list<Ipv4Address> nex)
+{
+  BSDVR_PROFILE_SCOPE (SEND_TRIGGERED_UPDATE_CHANGES);
+  NS_LOG_FUNCTION (this << nex.size () << changes.size ());
+  if (!changes.empty ())
+    {
+      m_stats.m_triggeredBatches++;
     }
-    /// FIXME: Make sure the getter returns a pointer to actual rtable to allow insert and removal of entries
-    std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* > *dvt = m_routingTable.GetDistanceVectorTable ();
-    for (std::vector<Neighbors::Neighbor>::iterator i = m_neighbors.begin ();
-       i != m_neighbors.end (); ++i)
-       {
-         std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >::iterator n_dvt = dvt->find (i->m_neighborAddress);
-         if (n_dvt != dvt->end ())
-           {
-             std::map<Ipv4Address, RoutingTableEntry>* n_dvt_entries = (*dvt)[i->m_neighborAddress];
-             /*for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator o = n_dvt_entries->begin (); o != n_dvt_entries->end (); ++o)
-               {
-                 std::cout<<"Neighbor: " << i->m_neighborAddress << " Destination: " << o->first << std::endl;
-               }
-              */
-             std::list<Ipv4Address> erase_ips;
-             for (std::map<Ipv4Address, RoutingTableEntry>::iterator j = n_dvt_entries->begin (); j != n_dvt_entries->end (); ++j)
-                {
-                    for (std::list<Ipv4Address>::iterator k = fake_dsts.begin (); k != fake_dsts.end (); ++k)
-                       {
-                         if (*k == j->first)
-                           {
-                             curr_nxtHp = (*ft)[j->first].GetNextHop ();
-                             if (i->m_neighborAddress != curr_nxtHp)
-                               { 
-                                 //(*dvt)[i->m_neighborAddress]->erase(*k);
-                                 erase_ips.push_back (*k);
-                               }
-                           }
-                       }
-                }
-              if (!erase_ips.empty ())
-                {
-                  for (std::list<Ipv4Address>::iterator r = erase_ips.begin (); r != erase_ips.end (); ++r)
-                    {
-                      (*dvt)[i->m_neighborAddress]->erase(*r);
-                    }
-                  erase_ips.clear ();
-                  /*std::map<Ipv4Address, RoutingTableEntry>* n_dvt_entries = (*dvt)[i->m_neighborAddress];
-                  for (std::map<Ipv4Address, RoutingTableEntry>::const_iterator o = n_dvt_entries->begin (); o != n_dvt_entries->end (); ++o)
-                    {
-                      std::cout<<"Neighbor: " << i->m_neighborAddress << " Destination: " << o->first << std::endl;
-                    }
-                  */
-                }
-           }
-       }
+  std::vector<EngineMessage> messages;
+  m_engine.GetTriggeredUpdates (changes, nex, messages);
+  SendEngineMessages (messages, false);
 }
-
 void 
-RoutingProtocol::UpdateDistanceVectorTable (Ipv4Address nxtHp, RoutingTableEntry & rt)
+RoutingProtocol::ScheduleTriggeredUpdateChanges (std::list<Ipv4Address> changes, std::list<Ipv4Address> nex)
 {
-  Ipv4Address curr_dst;
-  Ipv4Address curr_nxtHp;
-  Ipv4Address dst = rt.GetDestination ();
-  // Tables
-  std::vector<Neighbors::Neighbor> m_neighbors =  m_nb.GetNeighbors();
-  std::map<Ipv4Address, RoutingTableEntry> *ft = m_routingTable.GetForwardingTable ();
-  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* > *dvt = m_routingTable.GetDistanceVectorTable ();
-  // Iterators
-  std::vector<Neighbors::Neighbor>::iterator n;
-  std::map<Ipv4Address, RoutingTableEntry>::iterator ft_entry;
-  std::map<Ipv4Address, RoutingTableEntry>::iterator n_dvt_entry;
-  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >::iterator n_dvt;
-
-
-  ft_entry = ft->find (dst);
-  if (ft_entry != ft->end ())
+  NS_LOG_FUNCTION (this << nex.size () << changes.size ());
+  if (!m_enableHello || !m_enableHelloPiggyback || m_maxHelloRecords == 0)
     {
-      try
-      {
-        RemoveFakeRoutes (nxtHp, rt);
-      }
-      catch(const std::exception& e)
-      {
-        std::cerr << e.what() << '\n';
-      }
-      
+      SendTriggeredUpdateChangesToNeighbors (changes, nex);
+      return;
     }
-  /// FIXME: Improve search in neighbor vector
-  for (n = m_neighbors.begin (); n != m_neighbors.end (); ++n)
+  // Loss of a route is announced right away to keep the pending reply logic
+  // effective; improvements and new ACTIVE routes wait for the next HELLO.
+  std::list<Ipv4Address> urgent;
+  std::map<Ipv4Address, RoutingTableEntry>::iterator ft_entry;
+  std::map<Ipv4Address, RoutingTableEntry>* ft = m_routingTable.GetForwardingTable ();
+  for (std::list<Ipv4Address>::const_iterator i = changes.begin (); i != changes.end (); ++i)
     {
-      if (n->m_neighborAddress == nxtHp)
+      ft_entry = ft->find (*i);
+      if (ft_entry == ft->end ())
         {
-          break;
+          continue;
+        }
+      if (ft_entry->second.GetRouteState () == INACTIVE)
+        {
+          m_helloPendingChanges.remove (*i);
+          urgent.push_back (*i);
+        }
+      else if (std::find (m_helloPendingChanges.begin (), m_helloPendingChanges.end (), *i) == m_helloPendingChanges.end ())
+        {
+          m_helloPendingChanges.push_back (*i);
         }
     }
-  n_dvt = (*dvt).find (nxtHp);
-  if (n != m_neighbors.end () && n_dvt != (*dvt).end ())
+  if (!urgent.empty ())
     {
-      /// NOTE: Assuming all neighbor hopCounts to be 1 so entries won't change will link quality
-      // Do nothing
+      SendTriggeredUpdateChangesToNeighbors (urgent, nex);
     }
-  else
+}
+void 
+RoutingProtocol::SendTo (Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address destination)
+{
+  if (!m_txTrace.IsEmpty ())
     {
-      /// NOTE: As link quality is assumed constant, no total-cost calc. performed and
-      //check against THRESHOLD value to skip total-cost calc.
-      if (n_dvt == dvt->end ())
+      Ptr<Packet> copy = packet->Copy ();
+      TypeHeader tHeader;
+      copy->RemoveHeader (tHeader);
+      Ipv4Address dst;
+      if (tHeader.Get () == BSDVRTYPE_HELLO)
         {
-          dvt->insert (std::make_pair (nxtHp, new std::map<Ipv4Address, RoutingTableEntry> ()));
+          HelloHeader hlHeader;
+          copy->RemoveHeader (hlHeader);
+          dst = hlHeader.GetDst ();
         }
-      std::map<Ipv4Address, RoutingTableEntry>* n_dvt_entries = (*dvt)[nxtHp];
-      n_dvt_entry = (*dvt)[nxtHp]->find (dst);
-      if (n_dvt_entry != (*dvt)[nxtHp]->end ())
+      m_txTrace (tHeader.Get (), destination, dst, 0, 0, packet->GetSize ());
+    }
+  socket->SendTo (packet, 0, InetSocketAddress (destination, BSDVR_PORT)); 
+}
+
+//-----------------------------------------------------------------------------
+
+/*
+ BSDVR Engine Outputs
+ */
+
+void
+RoutingProtocol::RecordRouteChanges (EngineOutput const & out, RouteChangeCause cause)
+{
+  for (std::vector<EngineRouteChange>::const_iterator c = out.m_routeChanges.begin ();
+       c != out.m_routeChanges.end (); ++c)
+    {
+      RecordRouteChange (c->m_oldNextHop, c->m_route, cause);
+    }
+}
+
+void
+RoutingProtocol::SendEngineMessages (std::vector<EngineMessage> const & messages, bool reply)
+{
+  std::map<Ipv4Address, RoutingTableEntry>* ft = m_routingTable.GetForwardingTable ();
+  for (std::vector<EngineMessage>::const_iterator m = messages.begin (); m != messages.end (); ++m)
+    {
+      std::map<Ipv4Address, RoutingTableEntry>::const_iterator rt = ft->find (m->m_destination);
+      NS_ASSERT (rt != ft->end ());
+      if (reply)
         {
-          (*n_dvt_entries)[dst] = rt;
+          SendUpdate (rt->second, m->m_neighbor);
         }
-      else 
+      else
         {
-          (*n_dvt_entries).insert (std::make_pair (dst,rt));
+          SendUpdateToNeighbor (rt->second, m->m_neighbor);
         }
     }
 }
 
 void
-RoutingProtocol::RefreshForwardingTable (Ipv4Address dst, Ipv4Address nxtHp)
+RoutingProtocol::SendEngineReplies (EngineOutput const & out)
 {
-  Ipv4Address curr_nxtHp;
-  // Tables
-  std::map<Ipv4Address, RoutingTableEntry> *ft = m_routingTable.GetForwardingTable ();
-  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* > *dvt = m_routingTable.GetDistanceVectorTable ();
-  // Iterators
-  std::map<Ipv4Address, RoutingTableEntry>::iterator ft_entry;
-  std::map<Ipv4Address, RoutingTableEntry>::iterator n_dvt_entry;
-  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >::iterator n_dvt;
-
-  n_dvt = (*dvt).find (nxtHp);
-  if (n_dvt != dvt->end ())
+  SendEngineMessages (out.m_replies, true);
+  for (std::vector<EnginePendingReply>::const_iterator r = out.m_pendingReplies.begin ();
+       r != out.m_pendingReplies.end (); ++r)
     {
-      std::map<Ipv4Address, RoutingTableEntry>* n_dvt_entries = (*dvt)[nxtHp];
-      n_dvt_entry = n_dvt_entries->find (dst);
-      if (n_dvt_entry != n_dvt_entries->end ())
+      PendingReplyEntry en (/*neighbor*/ r->m_neighbor, /*destination*/ r->m_destination);
+      if (m_prqueue.Enqueue (en))
         {
-          (*ft)[dst] = n_dvt_entry->second;
+          m_stats.m_pendingReplyEnqueues++;
         }
     }
-  else
-    {
-      (*ft)[dst].SetRouteState (INACTIVE);
-    }
 }
 
-std::list<Ipv4Address> 
-RoutingProtocol::ComputeForwardingTable ()
+void
+RoutingProtocol::ReportDiagnostic (DiagLevel level, DiagEvent event, Ipv4Address peer, Ipv4Address dst)
 {
-  Ipv4Address curr_nxtHp;
-  RoutingTableEntry old_entry;
-  RoutingTableEntry new_entry;
-  RoutingTableEntry curr_entry;
-  std::list<Ipv4Address> changes;
-  // Tables
-  std::vector<Neighbors::Neighbor> m_neighbors =  m_nb.GetNeighbors();
-  std::map<Ipv4Address, RoutingTableEntry> *ft = m_routingTable.GetForwardingTable ();
-  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* > *dvt = m_routingTable.GetDistanceVectorTable ();
-  // Iterators
-  std::list<Ipv4Address>::iterator c;
-  std::map<Ipv4Address, RoutingTableEntry>::iterator ft_entry;
-  std::map<Ipv4Address, RoutingTableEntry>::iterator n_dvt_entry;
-  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>* >::iterator n_dvt_entries_find;
-  for (std::vector<Neighbors::Neighbor>::iterator i = m_neighbors.begin ();
-       i != m_neighbors.end (); ++i)
-      {
-        for (n_dvt_entries_find = dvt->begin (); n_dvt_entries_find != dvt->end (); ++n_dvt_entries_find)
-          {
-            if (n_dvt_entries_find->first == i->m_neighborAddress)
-              {
-                break;
-              }
-          }
-        if (n_dvt_entries_find != dvt->end ())
-          {
-            std::map<Ipv4Address, RoutingTableEntry>* n_dvt_entries = (*dvt)[i->m_neighborAddress];
-            for (n_dvt_entry = n_dvt_entries->begin (); n_dvt_entry != n_dvt_entries->end (); n_dvt_entry++)
-            {
-              ft_entry = ft->find (n_dvt_entry->first);
-              if (ft_entry != ft->end ())
-                {
-                  try
-                  {
-                    curr_nxtHp = (*ft)[n_dvt_entry->first].GetNextHop ();
-                    old_entry = (*ft)[n_dvt_entry->first];
-                    RefreshForwardingTable (n_dvt_entry->first, curr_nxtHp);
-                    new_entry = (*(*dvt)[i->m_neighborAddress])[n_dvt_entry->first];
-                    curr_entry = (*ft)[n_dvt_entry->first];
-                    if (isBetterRoute (new_entry, curr_entry))
-                      {
-                        (*ft)[n_dvt_entry->first] = new_entry;
-                        c = std::find(changes.begin (), changes.end (), n_dvt_entry->first);
-                        if (c != changes.end ())
-                          {
-                            changes.push_back (n_dvt_entry->first);
-                          }
-                      }
-                    else if ((curr_entry.GetHop () != old_entry.GetHop ()) || (curr_entry.GetRouteState () != old_entry.GetRouteState ()))
-                      {
-                        c = std::find(changes.begin (), changes.end (), n_dvt_entry->first);
-                        if (c != changes.end ())
-                          {
-                            changes.push_back (n_dvt_entry->first);
-                          }
-                      }
-                  }
-                  catch(const std::exception& e)
-                  {
-                    std::cerr << e.what() << '\n';
-                  }
-                  
-                }
-              else
-                {
-                  new_entry = (*(*dvt)[i->m_neighborAddress])[n_dvt_entry->first];
-                  (*ft)[n_dvt_entry->first] = new_entry;
-                  changes.push_back (n_dvt_entry->first);
-                }
-            }
-          }
-      }
-  changes.remove (m_mainAddress);
-  return changes;
+  if (!m_diagTrace.IsEmpty ())
+    {
+      m_diagTrace (level, event, peer, dst);
+    }
 }
 
-void 
-RoutingProtocol::RetransmitToNeighbor (UpdateHeader & upt)
+void
+RoutingProtocol::NotifyQueueDrop (QueueEntry const & entry, std::string const & reason)
 {
-  Ipv4Address nxtHp;
-  Ipv4Address dst = upt.GetDst ();
-  Ipv4Address ne = upt.GetOrigin ();
-  NS_LOG_FUNCTION (this << ne);
-  std::vector<Neighbors::Neighbor> neighbors = m_nb.GetNeighbors ();
-  std::map<Ipv4Address, RoutingTableEntry>* ft = m_routingTable.GetForwardingTable ();
-  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>*>* dvt = m_routingTable.GetDistanceVectorTable ();
-  // Iterators
-  std::vector<Neighbors::Neighbor>::iterator ne_find;
-  std::map<Ipv4Address, RoutingTableEntry>::iterator dst_find;
-  std::map<Ipv4Address, RoutingTableEntry>::iterator dv_entry;
-  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntry>*>::iterator n_dvt_find;
-  // Retransmission params
-  u_int32_t c1, c2, c3, c5, l2;
-  /// FIXME: make filter upper bound dynamic for variable number of nodes in the network
-  if ((Ipv4Address ("10.1.1.0") < ne) && (ne) < Ipv4Address ("10.1.1.51"))
-    {
-      return;
-    }
-  for (ne_find = neighbors.begin (); ne_find != neighbors.end (); ++ne_find)
+  if (!m_queueDropTrace.IsEmpty ())
     {
-      if (ne_find->m_neighborAddress == ne)
-        {
-          break;
-        }
+      m_queueDropTrace (entry.GetPacket (), entry.GetIpv4Header ().GetDestination (),
+                        Simulator::Now () - entry.GetEnqueueTime (), reason);
     }
-  dst_find = ft->find (dst);
-  // Checking if neighbor still active and dst entry available in ft
-  if (dst_find != ft->end () && ne_find != neighbors.end ())
-    {
-      // cost for reaching ne from current nxtHp for dst in ft
-      c5 = 0;
-      nxtHp = dst_find->second.GetNextHop ();
-      if (dst_find->second.GetRouteState () == ACTIVE && nxtHp != ne)
-        {
-          n_dvt_find = dvt->find(nxtHp);
-          if (n_dvt_find != dvt->end ())
-            {
-              dv_entry = (*dvt)[nxtHp]->find (ne);
-              if (dv_entry != (*dvt)[nxtHp]->end ())
-                {
-                  c5 = (*(*dvt)[nxtHp])[ne].GetHop ();
-                }
-            }
-          // cost for reaching dst at ne
-          c2 = upt.GetHopCount ();
-          // cost for reaching dst at ne 
-          l2 = 1;
-          // cost for reaching current nxtHp for dst 
-          c1 = dst_find->second.GetHop ();
-          // cost for reaching dst at nxtHp
-          c3 = c1 - l2;
-          if ((c3 == 0) || (c5 == c2+c3))
-            {
-              // send immediate reply
-              std::cout<< "Send pending reply immediately to " << ne << std::endl;
-              SendUpdate(dst_find->second, ne);
-            }
-          else
-            {
-              // populate pending reply entry in queue
-              std::cout<< "Adding pending reply entry to queue for" << ne << std::endl;
-              PendingReplyEntry en (/*neighbor*/ ne, /*destination*/ dst);
-              m_prqueue.Enqueue (en);
-            } 
+}
 
-        }
+void
+RoutingProtocol::RecordRouteChange (Ipv4Address oldNextHop, RoutingTableEntry const & newEntry, RouteChangeCause cause)
+{
+  m_routeChangeTrace (newEntry.GetDestination (), oldNextHop, newEntry.GetNextHop (),
+                      newEntry.GetHop (), newEntry.GetRouteState ());
+  if (m_routeLog.IsEnabled ())
+    {
+      m_routeLog.Record (Simulator::Now ().GetNanoSeconds (), newEntry.GetDestination (), oldNextHop,
+                         newEntry.GetNextHop (), newEntry.GetHop (), newEntry.GetRouteState (), cause);
     }
-  
 }
 
 }  // namespace bsdvr
@@ -4,15 +4,22 @@
 
 #include "bsdvr-constants.h"
 #include "bsdvr-rtable.h"
+#include "bsdvr-engine.h"
 #include "bsdvr-rqueue.h"
 #include "bsdvr-packet.h"
 #include "bsdvr-neighbor.h"
+#include "bsdvr-stats.h"
+#include "bsdvr-route-log.h"
+#include "bsdvr-diag.h"
 #include "ns3/node.h"
+#include "ns3/event-id.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/traced-callback.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-interface.h"
 #include "ns3/ipv4-l3-protocol.h"
+#include <set>
 
 namespace ns3 {
 
@@ -20,6 +27,16 @@ class WifiMacQueueItem;
 enum WifiMacDropReason : uint8_t; // opaque enum declaration
 
 namespace bsdvr {
+/**
+ * \ingroup bsdvr
+ * \brief Split horizon modes applied to UPDATE messages sent to the next hop of a route
+ */
+enum SplitHorizonMode
+{
+  NO_SPLIT_HORIZON = 0,   //!< Send every change to every neighbor
+  SPLIT_HORIZON = 1,      //!< Do not advertise a route to its own next hop
+  POISONED_REVERSE = 2,   //!< Advertise a route to its own next hop as unreachable
+};
 /**
  * \ingroup bsdvr
  *
@@ -35,6 +52,68 @@ public:
   static TypeId GetTypeId (void);
   static const u_int32_t BSDVR_PORT;
 
+  /**
+   * TracedCallback signature for transmitted and received control messages.
+   *
+   * \param [in] type the message type (MessageType)
+   * \param [in] peer the neighbor, or broadcast, address
+   * \param [in] dst the advertised destination, if any
+   * \param [in] hop the advertised hop count, if any
+   * \param [in] state the advertised binary state, if any
+   * \param [in] bytes the message size, type header included
+   */
+  typedef void (* ControlTracedCallback)
+    (uint8_t type, Ipv4Address peer, Ipv4Address dst, uint32_t hop, uint32_t state, uint32_t bytes);
+
+  /**
+   * TracedCallback signature for forwarding table changes.
+   *
+   * \param [in] dst the destination whose route changed
+   * \param [in] oldNextHop the previous next hop, 0.0.0.0 for a new destination
+   * \param [in] newNextHop the installed next hop
+   * \param [in] hop the installed hop count
+   * \param [in] state the installed binary state
+   */
+  typedef void (* RouteChangeTracedCallback)
+    (Ipv4Address dst, Ipv4Address oldNextHop, Ipv4Address newNextHop, uint32_t hop, uint32_t state);
+
+  /**
+   * TracedCallback signature for control-plane diagnostics.
+   *
+   * \param [in] level the DiagLevel
+   * \param [in] event the DiagEvent
+   * \param [in] peer the neighbor involved
+   * \param [in] dst the destination involved
+   */
+  typedef void (* DiagnosticTracedCallback)
+    (uint8_t level, uint8_t event, Ipv4Address peer, Ipv4Address dst);
+
+  /**
+   * TracedCallback signature for packets entering the deferred queue.
+   *
+   * \param [in] packet the data packet
+   * \param [in] dst the packet destination
+   */
+  typedef void (* QueueEnqueueTracedCallback)(Ptr<const Packet> packet, Ipv4Address dst);
+  /**
+   * TracedCallback signature for packets sent from the deferred queue.
+   *
+   * \param [in] packet the data packet
+   * \param [in] dst the packet destination
+   * \param [in] delay the time spent in the queue
+   * \param [in] status the ForwardingStatus of the entry at drain
+   */
+  typedef void (* QueueDrainTracedCallback)(Ptr<const Packet> packet, Ipv4Address dst, Time delay, uint8_t status);
+  /**
+   * TracedCallback signature for packets dropped from, or refused by, the deferred queue.
+   *
+   * \param [in] packet the data packet
+   * \param [in] dst the packet destination
+   * \param [in] delay the time spent in the queue
+   * \param [in] reason the drop reason
+   */
+  typedef void (* QueueDropTracedCallback)(Ptr<const Packet> packet, Ipv4Address dst, Time delay, std::string const & reason);
+
   /// constructor
   RoutingProtocol ();
   virtual ~RoutingProtocol ();
@@ -50,6 +129,13 @@ public:
   virtual void NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address);
   virtual void SetIpv4 (Ptr<Ipv4> ipv4);
   virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const;
+  /**
+   * Stream the routing tables as column rows, see RoutingTable::Dump
+   * \param os the output stream
+   * \param format the row format
+   * \param includeDvt whether the DVT rows are written too
+   */
+  void DumpRoutingTable (std::ostream & os, TableDumpFormat format, bool includeDvt) const;
   
   // Handle protocol parameters
   /**
@@ -123,6 +209,23 @@ public:
   {
     return m_enableBroadcast;
   }
+  /**
+   * Set the hop threshold
+   * \param threshold the hop threshold
+   */
+  void SetHopThreshold (uint32_t threshold)
+  {
+    m_threshold = threshold;
+    m_engine.SetThreshold (threshold);
+  }
+  /**
+   * Get the hop threshold
+   * \returns the hop threshold
+   */
+  uint32_t GetHopThreshold () const
+  {
+    return m_threshold;
+  }
 
   /**
    * Assign a fixed random variable stream number to the random variables
@@ -133,15 +236,64 @@ public:
    * \return the number of stream indices assigned by this model
    */
   int64_t AssignStreams (int64_t stream);
+  /**
+   * Get the routing statistics counters of this instance
+   * \returns the statistics
+   */
+  Statistics GetStatistics () const;
+  /**
+   * Estimate the heap footprint of the routing tables, neighbors and queues
+   * \returns the memory usage
+   */
+  MemoryUsage GetMemoryUsage () const;
+  /**
+   * \returns the number of data packets in the deferred queue
+   */
+  uint32_t GetQueueSize () const
+  {
+    return m_queue.GetSize ();
+  }
+  /**
+   * \returns the number of pending reply entries
+   */
+  uint32_t GetPendingReplyQueueSize () const
+  {
+    return m_prqueue.GetSize ();
+  }
+  /**
+   * Get the histogram of the time data packets spent in the deferred queue
+   * before being sent
+   * \returns the histogram
+   */
+  DelayHistogram const & GetQueueDelayHistogram () const
+  {
+    return m_queueDelay;
+  }
+  /**
+   * Get the route change log of this instance
+   * \returns the route change log
+   */
+  RouteChangeLog const & GetRouteChangeLog () const
+  {
+    return m_routeLog;
+  }
+  /**
+   * Get the routing tables of this instance
+   * \returns the routing tables
+   */
+  RoutingTable const & GetRoutingTable () const
+  {
+    return m_routingTable;
+  }
   /// NOTE: Remove these dummy functions
   bool isBetterRoute2 (RoutingTableEntry & r1, RoutingTableEntry & r2)
   {
-    return isBetterRoute (r1,r2);
+    return m_engine.IsBetterRoute (r1,r2);
   }
 
   void RefreshForwardingTable2 (Ipv4Address dst, Ipv4Address nxtHp)
   {
-    RefreshForwardingTable (dst, nxtHp);
+    m_engine.RefreshForwardingTable (dst, nxtHp);
   }
 
 protected:
@@ -169,6 +321,8 @@ private:
   Ptr<NetDevice> m_lo;
   /// Routing table
   RoutingTable m_routingTable;
+  /// Control plane working on m_routingTable
+  Engine m_engine;
   /// Indicates whether a hello messages enable
   bool m_enableHello;
    /// Indicates whether a a broadcast data packets forwarding enable
@@ -193,6 +347,115 @@ private:
    * neighbor entries in order to avoid count-to-infinty loops setup by upstream node failures
    */
   BsdvrPendingReplyQueue m_prqueue;  
+  /// Indicates whether pending forwarding table changes are piggybacked on HELLO messages
+  bool m_enableHelloPiggyback;
+  /// The maximum number of route records carried by a single HELLO message
+  uint32_t m_maxHelloRecords;
+  /// Destinations whose changed forwarding table entries wait for the next HELLO
+  std::list<Ipv4Address> m_helloPendingChanges;
+  /// Split horizon mode applied to UPDATE messages
+  SplitHorizonMode m_splitHorizon;
+  /// Hop count beyond which a route is treated as unreachable
+  uint32_t m_threshold;
+  /// Trace of transmitted control messages
+  TracedCallback<uint8_t, Ipv4Address, Ipv4Address, uint32_t, uint32_t, uint32_t> m_txTrace;
+  /// Trace of received control messages
+  TracedCallback<uint8_t, Ipv4Address, Ipv4Address, uint32_t, uint32_t, uint32_t> m_rxTrace;
+  /// Trace of forwarding table changes
+  TracedCallback<Ipv4Address, Ipv4Address, Ipv4Address, uint32_t, uint32_t> m_routeChangeTrace;
+  /// Trace of control-plane diagnostics
+  TracedCallback<uint8_t, uint8_t, Ipv4Address, Ipv4Address> m_diagTrace;
+  /// Trace of packets entering the deferred queue
+  TracedCallback<Ptr<const Packet>, Ipv4Address> m_queueEnqueueTrace;
+  /// Trace of packets sent from the deferred queue
+  TracedCallback<Ptr<const Packet>, Ipv4Address, Time, uint8_t> m_queueDrainTrace;
+  /// Trace of packets dropped from, or refused by, the deferred queue
+  TracedCallback<Ptr<const Packet>, Ipv4Address, Time, std::string const &> m_queueDropTrace;
+  /// Time data packets spent in the deferred queue before being sent
+  DelayHistogram m_queueDelay;
+  /// Routing statistics counters, queue drop and expiry counts excluded
+  Statistics m_stats;
+  /// Number of records of the route change log, 0 disables it
+  uint32_t m_routeLogCapacity;
+  /// File the route change log is flushed to, empty to keep an in-memory ring
+  std::string m_routeLogFile;
+  /// Binary log of forwarding table changes
+  RouteChangeLog m_routeLog;
+  /// Indicates whether a new neighbor receives the forwarding table as a fragmented snapshot
+  bool m_enableSnapshot;
+  /// Maximum size of a snapshot fragment on the wire, in bytes
+  uint32_t m_snapshotFragmentSize;
+  /// Time to wait for a snapshot acknowledgment before retransmitting unacknowledged fragments
+  Time m_snapshotTimeout;
+  /// Maximum number of snapshot retransmission rounds before the transfer is abandoned
+  uint32_t m_snapshotMaxRetries;
+  /// Id of the last snapshot sent
+  uint16_t m_snapshotId;
+  /// Outgoing snapshot transfer to a neighbor
+  struct SnapshotTransfer
+  {
+    uint16_t m_id;                                       ///< snapshot id
+    Ipv4InterfaceAddress m_iface;                        ///< interface the neighbor is reachable on
+    std::vector<std::vector<Ipv4Address> > m_fragments;  ///< destinations carried by each fragment
+    std::vector<bool> m_acked;                           ///< fragments acknowledged by the neighbor
+    std::vector<Time> m_sent;                            ///< last (re)transmission time of each fragment
+    uint32_t m_retries;                                  ///< retransmission rounds so far
+    EventId m_timer;                                     ///< retransmission timer
+  };
+  /// Outgoing snapshot transfers, map neighbor -> transfer
+  std::map<Ipv4Address, SnapshotTransfer> m_snapshotTx;
+  /// Incoming snapshot transfer from a neighbor
+  struct SnapshotReception
+  {
+    uint16_t m_id;                 ///< snapshot id
+    std::vector<bool> m_received;  ///< fragments received so far
+    uint16_t m_next;               ///< one past the highest fragment index received
+    bool m_lastSeen;               ///< the last fragment was received at least once
+  };
+  /// Incoming snapshot transfers, map neighbor -> reception
+  std::map<Ipv4Address, SnapshotReception> m_snapshotRx;
+  /// Indicates whether UPDATE messages are sequenced, acknowledged and retransmitted
+  bool m_enableReliableUpdate;
+  /// Time to wait for an UPDATE acknowledgment before retransmitting
+  Time m_updateRetransmitTimeout;
+  /// Maximum number of retransmissions of a single UPDATE
+  uint32_t m_updateMaxRetransmissions;
+  /// Time an acknowledgment is held back to cover more UPDATEs or ride on a HELLO
+  Time m_updateAckDelay;
+  /// Sequenced UPDATE not yet acknowledged by a neighbor
+  struct UnackedUpdate
+  {
+    Ipv4Address m_dst;   ///< destination advertised by the UPDATE
+    Time m_sent;         ///< last (re)transmission time
+    uint32_t m_retries;  ///< retransmissions so far
+  };
+  /// Sequenced UPDATEs sent to a neighbor
+  struct UpdateTxState
+  {
+    /// constructor
+    UpdateTxState () : m_nextSeq (1)
+    {
+    }
+    uint32_t m_nextSeq;                           ///< next sequence number
+    std::map<uint32_t, UnackedUpdate> m_unacked;  ///< unacknowledged UPDATEs, map seq -> UPDATE
+    EventId m_timer;                              ///< retransmission timer
+  };
+  /// Sequenced UPDATEs sent, map neighbor -> state
+  std::map<Ipv4Address, UpdateTxState> m_updateTx;
+  /// Sequenced UPDATEs received from a neighbor
+  struct UpdateRxState
+  {
+    /// constructor
+    UpdateRxState () : m_cumAck (0)
+    {
+    }
+    uint32_t m_cumAck;          ///< every sequence number up to this one was received
+    std::set<uint32_t> m_sack;  ///< sequence numbers received beyond m_cumAck
+    Ipv4Address m_my;           ///< interface address the UPDATEs arrive on
+    EventId m_ackTimer;         ///< delayed acknowledgment timer
+  };
+  /// Sequenced UPDATEs received, map neighbor -> state
+  std::map<Ipv4Address, UpdateRxState> m_updateRx;
 
 private:
   /// Start protocol operation
@@ -241,6 +504,16 @@ private:
    * \param receiverIfaceAddr receiver interface IP address
    */
   void ProcessHello (HelloHeader const & helloHeader, Ipv4Address receiverIfaceAddr);
+  /**
+   * Feed route records received from a neighbor through the DVT update path
+   *
+   * \param records the route records
+   * \param my receiver interface IP address
+   * \param src sender address
+   * \param cause the cause recorded for resulting route changes
+   */
+  void ProcessRouteRecords (std::vector<RouteRecord> const & records, Ipv4Address my, Ipv4Address src,
+                            RouteChangeCause cause);
   /**
    * Create loopback route for given header
    *
@@ -271,6 +544,41 @@ private:
    * \param src sender address
    */
   void RecvHello (Ptr<Packet> p, Ipv4Address my, Ipv4Address src);
+  /**
+   * Receive Snapshot fragment
+   * \param p packet
+   * \param my destination address
+   * \param src sender address
+   */
+  void RecvSnapshot (Ptr<Packet> p, Ipv4Address my, Ipv4Address src);
+  /**
+   * Receive Snapshot acknowledgment
+   * \param p packet
+   * \param my destination address
+   * \param src sender address
+   */
+  void RecvSnapshotAck (Ptr<Packet> p, Ipv4Address my, Ipv4Address src);
+  /**
+   * Receive Update acknowledgment
+   * \param p packet
+   * \param my destination address
+   * \param src sender address
+   */
+  void RecvUpdateAck (Ptr<Packet> p, Ipv4Address my, Ipv4Address src);
+  /**
+   * Record the sequence number of an UPDATE and schedule its acknowledgment
+   * \param src sender address
+   * \param my receiver interface IP address
+   * \param upt the sequenced UPDATE
+   * \returns false if the UPDATE is a duplicate
+   */
+  bool AcceptUpdateSeqNo (Ipv4Address src, Ipv4Address my, UpdateHeader const & upt);
+  /**
+   * Retire the UPDATEs acknowledged by a neighbor
+   * \param ne the neighbor
+   * \param ack the acknowledgment block
+   */
+  void ProcessUpdateAck (Ipv4Address ne, AckBlock const & ack);
   //\}
 
   ///\name Send
@@ -280,13 +588,68 @@ private:
    * \param route route to use
    */
   void SendPacketFromQueue (Ipv4Address dst, Ptr<Ipv4Route> route, RouteState state);    
+  /// Forward queued packets for every destination present in the forwarding table
+  void SendQueuedPackets ();
   /// Send hello
   void SendHello ();
   /** Send Update
-   * \param updtHeader route update header
-   * \param toOrigin routing table entry to originator
-   */
-  void SendUpdate (RoutingTableEntry const & rt, Ipv4Address const & dst);
+   * \param rt forwarding table entry to advertise
+   * \param ne the neighbor to send to
+   * \param poisoned advertise the entry as unreachable (poisoned reverse)
+   * \param seqNo sequence number of a retransmitted UPDATE, 0 for a new one
+   */
+  void SendUpdate (RoutingTableEntry const & rt, Ipv4Address const & ne, bool poisoned = false, uint32_t seqNo = 0);
+  /** Send Update to a neighbor subject to the split horizon mode
+   * \param rt forwarding table entry to advertise
+   * \param ne the neighbor to send to
+   */
+  void SendUpdateToNeighbor (RoutingTableEntry const & rt, Ipv4Address const & ne);
+  /** Build the route record advertised to a neighbor subject to the split horizon mode
+   * \param rt forwarding table entry to advertise
+   * \param ne the neighbor to advertise to
+   * \param r the resulting route record
+   * \returns false if the entry must not be advertised to the neighbor
+   */
+  bool MakeAdvertisement (RoutingTableEntry const & rt, Ipv4Address const & ne, RouteRecord & r) const;
+  /** Send the forwarding table to a new neighbor as a fragmented snapshot
+   * \param ne the neighbor to send to
+   * \param iface the interface the neighbor is reachable on
+   */
+  void SendSnapshotToNeighbor (Ipv4Address ne, Ipv4InterfaceAddress iface);
+  /** Send one snapshot fragment, built from the current forwarding table state
+   * \param ne the neighbor to send to
+   * \param index the fragment index
+   */
+  void SendSnapshotFragment (Ipv4Address ne, uint16_t index);
+  /** Acknowledge a snapshot, listing the fragments still missing
+   * \param ne the neighbor to send to
+   * \param my receiver interface IP address
+   * \param rx the snapshot reception state
+   */
+  void SendSnapshotAck (Ipv4Address ne, Ipv4Address my, SnapshotReception const & rx);
+  /** Retransmit the fragments reported missing that were not sent within the last SnapshotTimeout
+   * \param ne the neighbor
+   * \param tx the transfer
+   */
+  void RetransmitSnapshotFragments (Ipv4Address ne, SnapshotTransfer const & tx);
+  /** Retransmit unacknowledged snapshot fragments, or abandon the transfer
+   * \param ne the neighbor
+   */
+  void SnapshotTimerExpire (Ipv4Address ne);
+  /** Build the acknowledgment of the UPDATEs received from a neighbor
+   * \param ne the neighbor
+   * \param rx the reception state
+   * \returns the acknowledgment block
+   */
+  AckBlock MakeAckBlock (Ipv4Address ne, UpdateRxState const & rx) const;
+  /** Send the pending acknowledgment of the UPDATEs received from a neighbor
+   * \param ne the neighbor
+   */
+  void SendUpdateAck (Ipv4Address ne);
+  /** Retransmit UPDATEs to a neighbor that were not acknowledged in time
+   * \param ne the neighbor
+   */
+  void UpdateRetransmitTimerExpire (Ipv4Address ne);
   /** Send Update(s) to other acive neighbor(s) when link fails with a neighbor
    * \param neighbor the neighbor node
    */
@@ -303,6 +666,13 @@ private:
    * \param nex list of neighbors to exclude from broadcast
    */
   void SendTriggeredUpdateChangesToNeighbors (std::list<Ipv4Address> changes, std::list<Ipv4Address> nex);
+  /**
+   * Send changes in Forwarding Table right away, or hold the ones that can wait
+   * to be piggybacked on the next HELLO message
+   * \param changes list of destinations in forwarding table that have their routes updated
+   * \param nex list of neighbors to exclude from immediate broadcast
+   */
+  void ScheduleTriggeredUpdateChanges (std::list<Ipv4Address> changes, std::list<Ipv4Address> nex);
   /// @}
   
   /**
@@ -318,43 +688,51 @@ private:
   /// Schedule next send of hello message
   void HelloTimerExpire ();
   /**
-   * Find if a route to a destination is better than an alternative route
-   * \param rt1 routing entry for a given destination
-   * \param rt2 alternative routing entry for the same destination
-   * \return true in success
+   * Fire the RouteChange trace and append to the route change log for each
+   * forwarding table change of an engine event
+   * \param out the outputs of the event
+   * \param cause the cause of the changes
    */
-
-  /// BSDVR Control Plane Functions
-
-  bool isBetterRoute (RoutingTableEntry & r1, RoutingTableEntry & r2);
+  void RecordRouteChanges (EngineOutput const & out, RouteChangeCause cause);
   /**
-   * Remove alternative routes from DVT to avoid fake routes - [doesnot remove direct neighbor routes]
-   * \param nxtHp nexthop's address
-   * \param rt  new entry with destination address dst
+   * Send the UPDATEs listed by the engine
+   * \param messages the UPDATEs
+   * \param reply true to send them as pending replies, ignoring split horizon
    */
-  void RemoveFakeRoutes (Ipv4Address nxtHp, RoutingTableEntry & rt); 
+  void SendEngineMessages (std::vector<EngineMessage> const & messages, bool reply);
   /**
-   * Update existing routes in DVT or add new routes
-   * \param nxtHp nexthop's address
-   * \param rt  new entry with destination address dst
+   * Send the immediate replies and queue the pending replies of an engine event
+   * \param out the outputs of the event
    */
-  void UpdateDistanceVectorTable (Ipv4Address nxtHp, RoutingTableEntry & rt); 
+  void SendEngineReplies (EngineOutput const & out);
   /**
-   * Update changes in existing routes from updated DVT
-   * \param dst destination address
-   * \param nxtHp nexthop's address
+   * \returns true if route changes are traced or logged
+   */
+  bool IsRouteChangeObserved () const
+  {
+    return m_routeLog.IsEnabled () || !m_routeChangeTrace.IsEmpty ();
+  }
+  /**
+   * Fire the Diagnostic trace, called through the BSDVR_DIAG_* macros
+   * \param level the severity
+   * \param event the event
+   * \param peer the neighbor involved
+   * \param dst the destination involved
    */
-  void RefreshForwardingTable (Ipv4Address dst, Ipv4Address nxtHp);
-   /**
-   * Replace existing routes with by alternative routes from updated DVT if any
-   * \returns a list of newly installed routes in FT to broadcast to neighbors
+  void ReportDiagnostic (DiagLevel level, DiagEvent event, Ipv4Address peer, Ipv4Address dst);
+  /**
+   * Deferred queue drop callback, fires the QueueDrop trace
+   * \param entry the dropped entry
+   * \param reason the drop reason
    */
-  std::list<Ipv4Address> ComputeForwardingTable ();
+  void NotifyQueueDrop (QueueEntry const & entry, std::string const & reason);
   /**
-   * Add entries to pending reply queue on receiveing inactive Update from neighbor
-   * \param upt header of inactive Update message received from neighbor
-   */ 
-  void RetransmitToNeighbor (UpdateHeader & upt);
+   * Fire the RouteChange trace and append to the route change log
+   * \param oldNextHop the previous next hop
+   * \param newEntry the installed entry
+   * \param cause the cause of the change
+   */
+  void RecordRouteChange (Ipv4Address oldNextHop, RoutingTableEntry const & newEntry, RouteChangeCause cause);
 
   /// Provides uniform random variables.
   Ptr<UniformRandomVariable> m_uniformRandomVariable;
@@ -0,0 +1,258 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Performance regression gate: counts, unlike wall time, are deterministic,
+ * so a fixed workload is compared with stored budgets and the test fails
+ * when a count grows beyond TOLERANCE_PERCENT. When a change lowers a count
+ * on purpose, lower its budget in the same commit so the gain is kept.
+ *
+ * Heap allocations are not counted here, which would take replacing the
+ * global operator new of every test in the library; bsdvr-rtable-bench
+ * reports them per routing table operation. The RoutingTable budgets use
+ * the size estimates of RoutingTable instead: the FT and DVT sizes counted
+ * in map entries and the Ipv4Route objects counted in routes, so that they
+ * do not depend on the ns-3 type sizes.
+ */
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ns3/bsdvr.h"
+#include "ns3/bsdvr-engine-network.h"
+#include "ns3/test.h"
+#include "bsdvr-test-scenarios.h"
+
+using namespace ns3;
+
+namespace {
+
+/// Growth over a budget, in percent, before a count fails the test
+const uint64_t TOLERANCE_PERCENT = 10;
+
+/// Events after which the engine scenario is reported as not converging
+const uint64_t MAX_EVENTS = 10000000;
+
+/// Bytes RoutingTable::GetMemoryUsage counts for one FT or DVT map entry
+const uint64_t ENTRY_BYTES = 4 * sizeof (void *) + sizeof (std::pair<const Ipv4Address, bsdvr::RoutingTableEntry>);
+
+}  // unnamed namespace
+
+/**
+ * \ingroup bsdvr
+ * \brief Base of the budget test cases: compares counts with their budgets
+ */
+class BsdvrBudgetTestCase : public TestCase
+{
+public:
+  /**
+   * constructor
+   * \param name the test case name
+   */
+  BsdvrBudgetTestCase (std::string name);
+
+protected:
+  /**
+   * Fail if a count exceeds its budget by more than TOLERANCE_PERCENT
+   * \param what the name of the count
+   * \param count the measured count
+   * \param budget the stored budget
+   */
+  void CheckBudget (std::string const & what, uint64_t count, uint64_t budget);
+};
+
+BsdvrBudgetTestCase::BsdvrBudgetTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+BsdvrBudgetTestCase::CheckBudget (std::string const & what, uint64_t count, uint64_t budget)
+{
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (count, budget + budget * TOLERANCE_PERCENT / 100,
+                               what << " is " << count << ", over its budget of " << budget
+                                    << " + " << TOLERANCE_PERCENT << "%");
+}
+
+/**
+ * \ingroup bsdvr
+ * \brief Budgets of the control plane on a BsdvrEngineNetwork
+ *
+ * The grid churn of BuildGridChurn on a 10x10 grid: 45 links that were
+ * never up come up one at a time.
+ */
+class BsdvrEngineBudgetTestCase : public BsdvrBudgetTestCase
+{
+public:
+  BsdvrEngineBudgetTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BsdvrEngineBudgetTestCase::BsdvrEngineBudgetTestCase ()
+  : BsdvrBudgetTestCase ("Control plane budgets on a 10x10 grid with link churn")
+{
+}
+
+void
+BsdvrEngineBudgetTestCase::DoRun (void)
+{
+  const uint32_t width = 10;
+  BsdvrEngineNetwork n (width * width, bsdvr::constants::BSDVR_THRESHOLD);
+  BuildGridChurn (n, width);
+  n.Start ();
+  bool quiet = n.Run (MAX_EVENTS);
+  std::vector<std::pair<uint32_t, uint32_t> > links = GetGridChurnLinks (width);
+  for (uint32_t i = 0; i < links.size () && quiet; i++)
+    {
+      n.RestoreLink (links[i].first, links[i].second);
+      quiet = n.Run (MAX_EVENTS);
+    }
+  NS_TEST_ASSERT_MSG_EQ (quiet, true, "No convergence after " << MAX_EVENTS << " events");
+
+  bsdvr::Statistics stats = n.GetStatistics ();
+  CheckBudget ("events", n.GetEvents (), 811);
+  CheckBudget ("UPDATEs", n.GetMessages (), 361);
+  CheckBudget ("FT computations", stats.m_ftComputations, 649);
+  CheckBudget ("destinations evaluated", stats.m_destinationsEvaluated, 1420);
+}
+
+/**
+ * \ingroup bsdvr
+ * \brief Budgets of the RoutingTable operations
+ *
+ * 2000 routes over 8 next hops are added to the FT and the DVT, looked up,
+ * updated, switched INACTIVE and deleted, in a fixed scattered order. After
+ * each phase the entry counts must be exact, and the distinct routes and the
+ * estimated size of the tables are held to budgets.
+ */
+class BsdvrRoutingTableBudgetTestCase : public BsdvrBudgetTestCase
+{
+public:
+  BsdvrRoutingTableBudgetTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Check the entry counts of the tables and their budgets
+   * \param phase the phase just completed
+   * \param table the routing tables
+   * \param ftEntries the expected number of FT entries
+   * \param dvtEntries the expected number of DVT entries, all neighbors together
+   * \param routes the budget of distinct Ipv4Route objects
+   * \param size the budget of the estimated size of the FT and DVT maps, in map entries
+   */
+  void CheckTable (std::string const & phase, bsdvr::RoutingTable & table, uint64_t ftEntries,
+                   uint64_t dvtEntries, uint64_t routes, uint64_t size);
+};
+
+BsdvrRoutingTableBudgetTestCase::BsdvrRoutingTableBudgetTestCase ()
+  : BsdvrBudgetTestCase ("RoutingTable operation budgets on 2000 routes")
+{
+}
+
+void
+BsdvrRoutingTableBudgetTestCase::CheckTable (std::string const & phase, bsdvr::RoutingTable & table,
+                                             uint64_t ftEntries, uint64_t dvtEntries, uint64_t routes, uint64_t size)
+{
+  std::map<Ipv4Address, std::map<Ipv4Address, bsdvr::RoutingTableEntry>* > *dvt = table.GetDistanceVectorTable ();
+  uint64_t entries = 0;
+  for (std::map<Ipv4Address, std::map<Ipv4Address, bsdvr::RoutingTableEntry>* >::const_iterator i = dvt->begin ();
+       i != dvt->end (); ++i)
+    {
+      entries += i->second->size ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (table.GetForwardingTable ()->size (), ftEntries, "FT entries after " << phase);
+  NS_TEST_EXPECT_MSG_EQ (entries, dvtEntries, "DVT entries after " << phase);
+  CheckBudget ("routes after " + phase, table.GetRouteMemoryUsage () / sizeof (Ipv4Route), routes);
+  CheckBudget ("table size in entries after " + phase,
+               (table.GetForwardingTableMemoryUsage () + table.GetDistanceVectorTableMemoryUsage ()) / ENTRY_BYTES, size);
+}
+
+void
+BsdvrRoutingTableBudgetTestCase::DoRun (void)
+{
+  const uint32_t entries = 2000;
+  const uint32_t neighbors = 8;
+  Ipv4InterfaceAddress iface (Ipv4Address ("10.254.0.1"), Ipv4Mask ("255.255.0.0"));
+  std::vector<bsdvr::RoutingTableEntry> routes;
+  std::vector<uint32_t> order;
+  for (uint32_t i = 0; i < entries; i++)
+    {
+      routes.push_back (bsdvr::RoutingTableEntry (/*device=*/ 0, /*dst=*/ Ipv4Address (0x0a000001 + i), iface,
+                                                  /*hops=*/ 1 + i % 16,
+                                                  /*next hop=*/ Ipv4Address (0x0aff0001 + i % neighbors),
+                                                  /*changedEntries=*/ false));
+      // 7919 is prime to 2000: a fixed permutation scattering the accesses
+      order.push_back ((i * 7919) % entries);
+    }
+  bsdvr::RoutingTable table;
+  std::map<Ipv4Address, bsdvr::RoutingTableEntry> *ft = table.GetForwardingTable ();
+  std::map<Ipv4Address, std::map<Ipv4Address, bsdvr::RoutingTableEntry>* > *dvt = table.GetDistanceVectorTable ();
+
+  for (uint32_t i = 0; i < entries; i++)
+    {
+      table.AddRoute (routes[order[i]], ft);
+      Ipv4Address ne = routes[order[i]].GetNextHop ();
+      if (dvt->find (ne) == dvt->end ())
+        {
+          dvt->insert (std::make_pair (ne, new std::map<Ipv4Address, bsdvr::RoutingTableEntry> ()));
+        }
+      table.AddRoute (routes[order[i]], (*dvt)[ne]);
+    }
+  CheckTable ("AddRoute", table, entries, entries, 2000, 4010);
+
+  bsdvr::RoutingTableEntry rt;
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < entries; i++)
+    {
+      found += table.LookupRoute (routes[order[i]].GetDestination (), rt, ft);
+      found += table.LookupRoute (routes[order[i]].GetDestination (), rt, (*dvt)[routes[order[i]].GetNextHop ()]);
+    }
+  NS_TEST_EXPECT_MSG_EQ (found, 2 * entries, "LookupRoute missed present routes");
+  CheckTable ("LookupRoute", table, entries, entries, 2000, 4010);
+
+  uint32_t inactive = 0;
+  for (uint32_t i = 0; i < entries; i++)
+    {
+      table.Update (routes[order[i]], ft);
+      table.SetEntryState (routes[order[i]].GetDestination (), bsdvr::INACTIVE, *ft);
+    }
+  for (std::map<Ipv4Address, bsdvr::RoutingTableEntry>::const_iterator i = ft->begin (); i != ft->end (); ++i)
+    {
+      inactive += (i->second.GetRouteState () == bsdvr::INACTIVE);
+    }
+  NS_TEST_EXPECT_MSG_EQ (inactive, entries, "SetEntryState left ACTIVE routes");
+  CheckTable ("Update and SetEntryState", table, entries, entries, 2000, 4010);
+
+  for (uint32_t i = 0; i < entries; i++)
+    {
+      table.DeleteRoute (routes[order[i]].GetDestination (), *ft);
+    }
+  CheckTable ("DeleteRoute", table, 0, entries, 2000, 2010);
+  for (std::map<Ipv4Address, std::map<Ipv4Address, bsdvr::RoutingTableEntry>* >::iterator i = dvt->begin ();
+       i != dvt->end (); ++i)
+    {
+      delete i->second;
+    }
+  dvt->clear ();
+}
+
+/**
+ * \ingroup bsdvr
+ * \brief Performance regression gate of the BSDVR control plane
+ */
+class BsdvrPerfTestSuite : public TestSuite
+{
+public:
+  BsdvrPerfTestSuite ();
+};
+
+BsdvrPerfTestSuite::BsdvrPerfTestSuite ()
+  : TestSuite ("bsdvr-perf", UNIT)
+{
+  AddTestCase (new BsdvrEngineBudgetTestCase, TestCase::EXTENSIVE);
+  AddTestCase (new BsdvrRoutingTableBudgetTestCase, TestCase::EXTENSIVE);
+}
+
+static BsdvrPerfTestSuite sbsdvrPerfTestSuite;
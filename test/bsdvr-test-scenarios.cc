@@ -0,0 +1,65 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "bsdvr-test-scenarios.h"
+
+namespace ns3 {
+
+void
+BuildLine (BsdvrEngineNetwork & n)
+{
+  for (uint32_t i = 0; i + 1 < n.GetSize (); i++)
+    {
+      n.AddLink (i, i + 1);
+    }
+}
+
+void
+BuildRing (BsdvrEngineNetwork & n)
+{
+  BuildLine (n);
+  n.AddLink (n.GetSize () - 1, 0);
+}
+
+void
+BuildGrid (BsdvrEngineNetwork & n, uint32_t width)
+{
+  for (uint32_t i = 0; i < n.GetSize (); i++)
+    {
+      if ((i + 1) % width != 0 && i + 1 < n.GetSize ())
+        {
+          n.AddLink (i, i + 1);
+        }
+      if (i + width < n.GetSize ())
+        {
+          n.AddLink (i, i + width);
+        }
+    }
+}
+
+void
+BuildGridChurn (BsdvrEngineNetwork & n, uint32_t width)
+{
+  BuildGrid (n, width);
+  for (uint32_t i = 0; i + width < n.GetSize (); i++)
+    {
+      if (i % width != 0)
+        {
+          n.FailLink (i, i + width);
+        }
+    }
+}
+
+std::vector<std::pair<uint32_t, uint32_t> >
+GetGridChurnLinks (uint32_t width)
+{
+  std::vector<std::pair<uint32_t, uint32_t> > links;
+  for (uint32_t c = 1; c < width; c++)
+    {
+      for (uint32_t r = 0; r + 1 < width; r += 2)
+        {
+          links.push_back (std::make_pair (r * width + c, (r + 1) * width + c));
+        }
+    }
+  return links;
+}
+
+}
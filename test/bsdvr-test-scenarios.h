@@ -0,0 +1,54 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef BSDVR_TEST_SCENARIOS_H
+#define BSDVR_TEST_SCENARIOS_H
+
+#include <utility>
+#include <vector>
+#include "ns3/bsdvr-engine-network.h"
+
+/*
+ * Topologies and churn shared by the golden and the budget test suites, so
+ * that both exercise the same control plane workload.
+ */
+
+namespace ns3 {
+
+/**
+ * Line of nodes 0 - 1 - ... - size-1
+ * \param n the network
+ */
+void BuildLine (BsdvrEngineNetwork & n);
+
+/**
+ * Ring of nodes 0 - 1 - ... - size-1 - 0
+ * \param n the network
+ */
+void BuildRing (BsdvrEngineNetwork & n);
+
+/**
+ * Square grid, filled row by row
+ * \param n the network
+ * \param width the number of nodes per row
+ */
+void BuildGrid (BsdvrEngineNetwork & n, uint32_t width);
+
+/**
+ * Grid churn: a square grid whose vertical links are down but in the first
+ * column. A link failure leaves the forwarding tables as they are, so the
+ * churn brings up links that were never up instead, which changes the
+ * tables at every step.
+ * \param n the network, of width * width nodes, not started
+ * \param width the number of nodes per row
+ */
+void BuildGridChurn (BsdvrEngineNetwork & n, uint32_t width);
+
+/**
+ * \param width the number of nodes per row of the BuildGridChurn grid
+ * \returns the links to restore, in order: one vertical link every other
+ *          row, column by column
+ */
+std::vector<std::pair<uint32_t, uint32_t> > GetGridChurnLinks (uint32_t width);
+
+}
+
+#endif /* BSDVR_TEST_SCENARIOS_H */
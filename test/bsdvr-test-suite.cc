@@ -1,55 +1,792 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
-// Include a header file from your module to test.
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "ns3/bsdvr.h"
-
-// An essential include is test.h
+#include "ns3/bsdvr-engine-network.h"
+#include "ns3/bsdvr-helper.h"
+#include "ns3/bsdvr-packet.h"
+#include "ns3/packet.h"
 #include "ns3/test.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "bsdvr-test-scenarios.h"
 
-// Do not put your test classes in namespace ns3.  You may find it useful
-// to use the using directive to access the ns3 namespace directly
 using namespace ns3;
 
-// This is an example TestCase.
-class BsdvrTestCase1 : public TestCase
+namespace {
+
+/// Events after which a scenario is reported as not converging
+const uint64_t MAX_EVENTS = 1000000;
+
+/**
+ * Run a network to quiescence and print its tables and counters
+ * \param n the network
+ * \param os the output stream
+ */
+void
+RunAndPrint (BsdvrEngineNetwork & n, std::ostream & os)
+{
+  if (!n.Run (MAX_EVENTS))
+    {
+      os << "no convergence\n";
+    }
+  n.Print (os);
+}
+
+/**
+ * Run a network to quiescence and print its counters and FT checksum only
+ * \param n the network
+ * \param os the output stream
+ */
+void
+RunAndSummarize (BsdvrEngineNetwork & n, std::ostream & os)
+{
+  if (!n.Run (MAX_EVENTS))
+    {
+      os << "no convergence\n";
+    }
+  os << "checksum " << std::hex << n.GetChecksum () << std::dec << " events " << n.GetEvents ()
+     << " messages " << n.GetMessages () << " ft_changes " << n.GetStatistics ().m_ftChanges << "\n";
+}
+
+/**
+ * Positions of a line of nodes
+ * \param size the number of nodes
+ * \param spacing the distance between neighbors, in meters
+ * \returns the positions
+ */
+std::vector<Vector>
+LinePositions (uint32_t size, double spacing)
+{
+  std::vector<Vector> positions;
+  for (uint32_t i = 0; i < size; i++)
+    {
+      positions.push_back (Vector (i * spacing, 0, 0));
+    }
+  return positions;
+}
+
+/**
+ * Positions of a ring of nodes
+ * \param size the number of nodes
+ * \param radius the ring radius, in meters
+ * \returns the positions
+ */
+std::vector<Vector>
+RingPositions (uint32_t size, double radius)
+{
+  std::vector<Vector> positions;
+  for (uint32_t i = 0; i < size; i++)
+    {
+      double angle = 2 * M_PI * i / size;
+      positions.push_back (Vector (radius * std::cos (angle), radius * std::sin (angle), 0));
+    }
+  return positions;
+}
+
+/// \param os the output stream
+void
+Line (std::ostream & os)
+{
+  BsdvrEngineNetwork n (4, bsdvr::constants::BSDVR_THRESHOLD);
+  BuildLine (n);
+  n.Start ();
+  RunAndPrint (n, os);
+}
+
+/// \param os the output stream
+void
+Ring (std::ostream & os)
+{
+  BsdvrEngineNetwork n (5, bsdvr::constants::BSDVR_THRESHOLD);
+  BuildRing (n);
+  n.Start ();
+  RunAndPrint (n, os);
+}
+
+/// Diamond 0 - {1, 2} - 3, then 1 - 3 fails and comes back
+/// \param os the output stream
+void
+Diamond (std::ostream & os)
+{
+  BsdvrEngineNetwork n (4, bsdvr::constants::BSDVR_THRESHOLD);
+  n.AddLink (0, 1);
+  n.AddLink (0, 2);
+  n.AddLink (1, 3);
+  n.AddLink (2, 3);
+  n.Start ();
+  RunAndPrint (n, os);
+  n.FailLink (1, 3);
+  RunAndPrint (n, os);
+  n.RestoreLink (1, 3);
+  RunAndPrint (n, os);
+}
+
+/// Two components 0 - 1 - 2 and 3 - 4
+/// \param os the output stream
+void
+Partitioned (std::ostream & os)
+{
+  BsdvrEngineNetwork n (5, bsdvr::constants::BSDVR_THRESHOLD);
+  n.AddLink (0, 1);
+  n.AddLink (1, 2);
+  n.AddLink (3, 4);
+  n.Start ();
+  RunAndPrint (n, os);
+}
+
+/// Line of 4 split in two by a failure of 1 - 2
+/// \param os the output stream
+void
+Split (std::ostream & os)
+{
+  BsdvrEngineNetwork n (4, bsdvr::constants::BSDVR_THRESHOLD);
+  BuildLine (n);
+  n.Start ();
+  n.Run (MAX_EVENTS);
+  n.FailLink (1, 2);
+  RunAndPrint (n, os);
+}
+
+/// Line and ring of 40 nodes, hop threshold 8
+/// \param os the output stream
+void
+LongLineAndRing (std::ostream & os)
+{
+  BsdvrEngineNetwork line (40, 8);
+  BuildLine (line);
+  line.Start ();
+  RunAndSummarize (line, os);
+  BsdvrEngineNetwork ring (40, 8);
+  BuildRing (ring);
+  ring.Start ();
+  RunAndSummarize (ring, os);
+}
+
+/// 8x8 grid churn of BuildGridChurn
+/// \param os the output stream
+void
+GridChurn (std::ostream & os)
+{
+  uint32_t width = 8;
+  BsdvrEngineNetwork n (width * width, bsdvr::constants::BSDVR_THRESHOLD);
+  BuildGridChurn (n, width);
+  n.Start ();
+  RunAndSummarize (n, os);
+  std::vector<std::pair<uint32_t, uint32_t> > links = GetGridChurnLinks (width);
+  for (uint32_t i = 0; i < links.size (); i++)
+    {
+      n.RestoreLink (links[i].first, links[i].second);
+      RunAndSummarize (n, os);
+    }
+}
+
+/// 8x8 grid in which every fifth node joins after the others converged,
+/// like BuildGridChurn bringing up nodes that were never up
+/// \param os the output stream
+void
+NodeChurn (std::ostream & os)
+{
+  BsdvrEngineNetwork n (64, bsdvr::constants::BSDVR_THRESHOLD);
+  BuildGrid (n, 8);
+  for (uint32_t i = 0; i < n.GetSize (); i += 5)
+    {
+      n.FailNode (i);
+    }
+  n.Start ();
+  RunAndSummarize (n, os);
+  for (uint32_t i = 0; i < n.GetSize (); i += 5)
+    {
+      n.RestoreNode (i);
+      RunAndSummarize (n, os);
+    }
+}
+
+/*
+ * Golden outputs. They pin the behavior of the control plane: a change to
+ * the engine that alters any table entry or message count shows up as a
+ * difference here. Regenerate them only for an intended behavior change.
+ */
+
+/// Golden output of Line
+const char * const LINE_GOLDEN =
+  "0 ft 1 1 1 A\n"
+  "0 dvt 1 1 1 1 A\n"
+  "1 ft 0 0 1 A\n"
+  "1 ft 2 2 1 A\n"
+  "1 dvt 0 0 0 1 A\n"
+  "1 dvt 2 2 2 1 A\n"
+  "2 ft 1 1 1 A\n"
+  "2 ft 3 3 1 A\n"
+  "2 dvt 1 1 1 1 A\n"
+  "2 dvt 3 3 3 1 A\n"
+  "3 ft 2 2 1 A\n"
+  "3 dvt 2 2 2 1 A\n"
+  "events 8 messages 2 pending_replies 0\n";
+
+/// Golden output of Ring
+const char * const RING_GOLDEN =
+  "0 ft 1 1 1 A\n"
+  "0 ft 4 4 1 A\n"
+  "0 dvt 1 1 1 1 A\n"
+  "0 dvt 4 4 4 1 A\n"
+  "1 ft 0 0 1 A\n"
+  "1 ft 2 2 1 A\n"
+  "1 dvt 0 0 0 1 A\n"
+  "1 dvt 2 2 2 1 A\n"
+  "2 ft 1 1 1 A\n"
+  "2 ft 3 3 1 A\n"
+  "2 dvt 1 1 1 1 A\n"
+  "2 dvt 3 3 3 1 A\n"
+  "3 ft 0 4 2 A\n"
+  "3 ft 2 2 1 A\n"
+  "3 ft 4 4 1 A\n"
+  "3 dvt 2 2 2 1 A\n"
+  "3 dvt 4 0 4 2 A\n"
+  "3 dvt 4 4 4 1 A\n"
+  "4 ft 0 0 1 A\n"
+  "4 ft 3 3 1 A\n"
+  "4 dvt 0 0 0 1 A\n"
+  "4 dvt 3 3 3 1 A\n"
+  "events 16 messages 6 pending_replies 0\n";
+
+/// Golden output of Diamond
+const char * const DIAMOND_GOLDEN =
+  "0 ft 1 1 1 A\n"
+  "0 ft 2 2 1 A\n"
+  "0 dvt 1 1 1 1 A\n"
+  "0 dvt 2 2 2 1 A\n"
+  "1 ft 0 0 1 A\n"
+  "1 ft 3 3 1 A\n"
+  "1 dvt 0 0 0 1 A\n"
+  "1 dvt 3 3 3 1 A\n"
+  "2 ft 0 0 1 A\n"
+  "2 ft 1 3 2 A\n"
+  "2 ft 3 3 1 A\n"
+  "2 dvt 0 0 0 1 A\n"
+  "2 dvt 3 1 3 2 A\n"
+  "2 dvt 3 3 3 1 A\n"
+  "3 ft 1 1 1 A\n"
+  "3 ft 2 2 1 A\n"
+  "3 dvt 1 1 1 1 A\n"
+  "3 dvt 2 2 2 1 A\n"
+  "events 13 messages 5 pending_replies 0\n"
+  "0 ft 1 1 1 A\n"
+  "0 ft 2 2 1 A\n"
+  "0 dvt 1 1 1 1 A\n"
+  "0 dvt 2 2 2 1 A\n"
+  "1 ft 0 0 1 A\n"
+  "1 ft 3 3 1 A\n"
+  "1 dvt 0 0 0 1 A\n"
+  "1 dvt 3 3 3 1 A\n"
+  "2 ft 0 0 1 A\n"
+  "2 ft 1 3 2 A\n"
+  "2 ft 3 3 1 A\n"
+  "2 dvt 0 0 0 1 A\n"
+  "2 dvt 3 1 3 2 A\n"
+  "2 dvt 3 3 3 1 A\n"
+  "3 ft 1 1 1 A\n"
+  "3 ft 2 2 1 A\n"
+  "3 dvt 1 1 1 1 A\n"
+  "3 dvt 2 2 2 1 A\n"
+  "events 15 messages 5 pending_replies 0\n"
+  "0 ft 1 1 1 A\n"
+  "0 ft 2 2 1 A\n"
+  "0 dvt 1 1 1 1 A\n"
+  "0 dvt 2 2 2 1 A\n"
+  "1 ft 0 0 1 A\n"
+  "1 ft 3 3 1 A\n"
+  "1 dvt 0 0 0 1 A\n"
+  "1 dvt 3 3 3 1 A\n"
+  "2 ft 0 0 1 A\n"
+  "2 ft 1 3 2 A\n"
+  "2 ft 3 3 1 A\n"
+  "2 dvt 0 0 0 1 A\n"
+  "2 dvt 3 1 3 2 A\n"
+  "2 dvt 3 3 3 1 A\n"
+  "3 ft 1 1 1 A\n"
+  "3 ft 2 2 1 A\n"
+  "3 dvt 1 1 1 1 A\n"
+  "3 dvt 2 2 2 1 A\n"
+  "events 17 messages 5 pending_replies 0\n";
+
+/// Golden output of Partitioned
+const char * const PARTITIONED_GOLDEN =
+  "0 ft 1 1 1 A\n"
+  "0 dvt 1 1 1 1 A\n"
+  "1 ft 0 0 1 A\n"
+  "1 ft 2 2 1 A\n"
+  "1 dvt 0 0 0 1 A\n"
+  "1 dvt 2 2 2 1 A\n"
+  "2 ft 1 1 1 A\n"
+  "2 dvt 1 1 1 1 A\n"
+  "3 ft 4 4 1 A\n"
+  "3 dvt 4 4 4 1 A\n"
+  "4 ft 3 3 1 A\n"
+  "4 dvt 3 3 3 1 A\n"
+  "events 7 messages 1 pending_replies 0\n";
+
+/// Golden output of Split
+const char * const SPLIT_GOLDEN =
+  "0 ft 1 1 1 A\n"
+  "0 dvt 1 1 1 1 A\n"
+  "1 ft 0 0 1 A\n"
+  "1 ft 2 2 1 A\n"
+  "1 dvt 0 0 0 1 A\n"
+  "1 dvt 2 2 2 1 A\n"
+  "2 ft 1 1 1 A\n"
+  "2 ft 3 3 1 A\n"
+  "2 dvt 1 1 1 1 A\n"
+  "2 dvt 3 3 3 1 A\n"
+  "3 ft 2 2 1 A\n"
+  "3 dvt 2 2 2 1 A\n"
+  "events 10 messages 2 pending_replies 0\n";
+
+/// Golden output of LongLineAndRing
+const char * const LONG_LINE_AND_RING_GOLDEN =
+  "checksum 48a81fdb50639f97 events 116 messages 38 ft_changes 78\n"
+  "checksum 8998c2c2c8a54601 events 121 messages 41 ft_changes 81\n";
+
+/// Golden output of GridChurn
+const char * const GRID_CHURN_GOLDEN =
+  "checksum b9473df007f7b67d events 292 messages 68 ft_changes 126\n"
+  "checksum 4f8c339b19be2eb events 300 messages 74 ft_changes 130\n"
+  "checksum a7f5f93c981761d events 308 messages 80 ft_changes 134\n"
+  "checksum fab17049ff35475b events 316 messages 86 ft_changes 138\n"
+  "checksum 1970dd6bf586c21d events 324 messages 92 ft_changes 142\n"
+  "checksum 10ef94c7e2202dab events 332 messages 98 ft_changes 146\n"
+  "checksum 217bdbfb1ee576c5 events 340 messages 104 ft_changes 150\n"
+  "checksum 834b51ae0cf4afa3 events 348 messages 110 ft_changes 154\n"
+  "checksum ba4924d5f18a3055 events 356 messages 116 ft_changes 158\n"
+  "checksum bd920e3da5372fdf events 364 messages 122 ft_changes 162\n"
+  "checksum 5ed35f1a2d324b6d events 372 messages 128 ft_changes 166\n"
+  "checksum a97ca4763ba62f07 events 380 messages 134 ft_changes 170\n"
+  "checksum 2dd388104d12acfd events 388 messages 140 ft_changes 174\n"
+  "checksum 7df672b5bff4b7cf events 396 messages 146 ft_changes 178\n"
+  "checksum cdedb0c586762cfd events 404 messages 152 ft_changes 182\n"
+  "checksum 812d425422c2d6af events 412 messages 158 ft_changes 186\n"
+  "checksum bad9e6134833f7dd events 420 messages 164 ft_changes 190\n"
+  "checksum 9501f6e1a8a0340b events 428 messages 170 ft_changes 194\n"
+  "checksum 3fdb1ffbf82a716d events 436 messages 176 ft_changes 198\n"
+  "checksum 40241c350a83e3ab events 444 messages 182 ft_changes 202\n"
+  "checksum 981720f5a8012fdd events 452 messages 188 ft_changes 206\n"
+  "checksum c905212995d616b events 460 messages 194 ft_changes 210\n"
+  "checksum 33f25ee51c182d15 events 468 messages 200 ft_changes 214\n"
+  "checksum 7938298ac4fcf7b3 events 476 messages 206 ft_changes 218\n"
+  "checksum 6d4a532977f1c4f5 events 484 messages 212 ft_changes 222\n"
+  "checksum 6fc9e94166e851bf events 489 messages 215 ft_changes 225\n"
+  "checksum 735d5da276ffc8e9 events 494 messages 218 ft_changes 228\n"
+  "checksum be1336b04227a6db events 499 messages 221 ft_changes 231\n"
+  "checksum 8a2ad21f2a01c7f5 events 504 messages 224 ft_changes 234\n";
+
+/// Golden output of NodeChurn
+const char * const NODE_CHURN_GOLDEN =
+  "checksum bc876864957ce9db events 378 messages 154 ft_changes 154\n"
+  "checksum 7700e7b9e48e3439 events 388 messages 160 ft_changes 158\n"
+  "checksum f845f22adf0dec19 events 407 messages 173 ft_changes 166\n"
+  "checksum a0abeaf9865a99ee events 439 messages 197 ft_changes 179\n"
+  "checksum 22a0c0d21e934b92 events 457 messages 209 ft_changes 188\n"
+  "checksum 6f4329ef3cd30639 events 490 messages 234 ft_changes 201\n"
+  "checksum 2c8f76690fff3898 events 522 messages 258 ft_changes 214\n"
+  "checksum 4c6ef21ee16a7e93 events 553 messages 281 ft_changes 227\n"
+  "checksum c907ffe14f60c8d6 events 586 messages 306 ft_changes 240\n"
+  "checksum dacae2f0421b4d4c events 606 messages 320 ft_changes 248\n"
+  "checksum a8eb1f5ffbdccea1 events 639 messages 345 ft_changes 261\n"
+  "checksum 8a0c03e5b2fe26e events 671 messages 369 ft_changes 274\n"
+  "checksum 7830e97f41573c1a events 689 messages 381 ft_changes 283\n"
+  "checksum 6e3495860d6240d0 events 709 messages 395 ft_changes 292\n";
+
+}  // unnamed namespace
+
+/**
+ * \ingroup bsdvr
+ * \brief Runs a scenario on a BsdvrEngineNetwork and compares its output with a golden
+ */
+class BsdvrGoldenTestCase : public TestCase
 {
 public:
-  BsdvrTestCase1 ();
-  virtual ~BsdvrTestCase1 ();
+  /**
+   * constructor
+   * \param name the scenario name
+   * \param scenario the scenario, printing its outcome to a stream
+   * \param golden the expected output
+   */
+  BsdvrGoldenTestCase (std::string name, void (*scenario)(std::ostream &), std::string golden);
 
 private:
   virtual void DoRun (void);
+
+  void (*m_scenario)(std::ostream &);  ///< the scenario
+  std::string m_golden;                ///< the expected output
 };
 
-// Add some help text to this case to describe what it is intended to test
-BsdvrTestCase1::BsdvrTestCase1 ()
-  : TestCase ("Bsdvr test case (does nothing)")
+BsdvrGoldenTestCase::BsdvrGoldenTestCase (std::string name, void (*scenario)(std::ostream &), std::string golden)
+  : TestCase ("Golden control plane trace: " + name),
+    m_scenario (scenario),
+    m_golden (golden)
 {
 }
 
-// This destructor does nothing but we include it as a reminder that
-// the test case should clean up after itself
-BsdvrTestCase1::~BsdvrTestCase1 ()
+void
+BsdvrGoldenTestCase::DoRun (void)
+{
+  std::ostringstream os;
+  m_scenario (os);
+  // Compare line by line, so that a failure names the first differing entry
+  std::istringstream actual (os.str ());
+  std::istringstream expected (m_golden);
+  std::string a;
+  std::string e;
+  uint32_t line = 1;
+  while (true)
+    {
+      bool moreActual = static_cast<bool> (std::getline (actual, a));
+      bool moreExpected = static_cast<bool> (std::getline (expected, e));
+      if (!moreActual && !moreExpected)
+        {
+          break;
+        }
+      NS_TEST_ASSERT_MSG_EQ (a, e, "Output differs from the golden at line " << line);
+      line++;
+    }
+}
+
+/**
+ * \ingroup bsdvr
+ * \brief HELLO serialization with and without piggybacked records
+ */
+class BsdvrHelloHeaderTestCase : public TestCase
+{
+public:
+  BsdvrHelloHeaderTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BsdvrHelloHeaderTestCase::BsdvrHelloHeaderTestCase ()
+  : TestCase ("HelloHeader keeps its 8 bytes without records")
+{
+}
+
+void
+BsdvrHelloHeaderTestCase::DoRun (void)
+{
+  bsdvr::HelloHeader plain (Ipv4Address ("10.0.0.1"), Ipv4Address ("10.0.0.1"));
+  NS_TEST_EXPECT_MSG_EQ (plain.GetSerializedSize (), 8, "A HELLO without records grew");
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (plain);
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 8, "A HELLO without records grew");
+  bsdvr::HelloHeader h;
+  p->RemoveHeader (h);
+  NS_TEST_EXPECT_MSG_EQ (h == plain, true, "Plain HELLO round trip");
+
+  bsdvr::HelloHeader piggyback (Ipv4Address ("10.0.0.1"), Ipv4Address ("10.0.0.1"));
+  piggyback.AddRecord (bsdvr::RouteRecord (Ipv4Address ("10.0.0.7"), 3, bsdvr::UPDATE_STATE_ACTIVE));
+  NS_TEST_EXPECT_MSG_EQ (piggyback.GetSerializedSize (), 24, "HELLO with one record");
+  p = Create<Packet> ();
+  p->AddHeader (piggyback);
+  p->RemoveHeader (h);
+  NS_TEST_EXPECT_MSG_EQ (h == piggyback, true, "Piggybacked HELLO round trip");
+}
+
+/**
+ * \ingroup bsdvr
+ * \brief BsdvrEngineNetwork queues link events only when a link changes state
+ *
+ * Failing a link that is down, or restoring one that is up, must not queue
+ * anything: a second link failure or HELLO would reach the engines as churn
+ * that never happened. Node failures hide the state of their links the same
+ * way.
+ */
+class BsdvrEngineNetworkLinkStateTestCase : public TestCase
+{
+public:
+  BsdvrEngineNetworkLinkStateTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Run the network and check whether it processed events
+   * \param n the network
+   * \param expected whether events are expected
+   * \param what the operation that was applied
+   */
+  void CheckRun (BsdvrEngineNetwork & n, bool expected, std::string const & what);
+};
+
+BsdvrEngineNetworkLinkStateTestCase::BsdvrEngineNetworkLinkStateTestCase ()
+  : TestCase ("BsdvrEngineNetwork queues link events only on a state change")
+{
+}
+
+void
+BsdvrEngineNetworkLinkStateTestCase::CheckRun (BsdvrEngineNetwork & n, bool expected, std::string const & what)
+{
+  uint64_t events = n.GetEvents ();
+  NS_TEST_ASSERT_MSG_EQ (n.Run (MAX_EVENTS), true, "No convergence after " << what);
+  NS_TEST_EXPECT_MSG_EQ (n.GetEvents () > events, expected, what);
+}
+
+void
+BsdvrEngineNetworkLinkStateTestCase::DoRun (void)
+{
+  BsdvrEngineNetwork n (4, bsdvr::constants::BSDVR_THRESHOLD);
+  BuildRing (n);
+  n.Start ();
+  CheckRun (n, true, "Start");
+
+  n.FailLink (0, 1);
+  NS_TEST_EXPECT_MSG_EQ (n.IsUp (0, 1), false, "FailLink left the link up");
+  CheckRun (n, true, "FailLink of an up link");
+  n.FailLink (0, 1);
+  CheckRun (n, false, "FailLink of a down link");
+  n.FailLink (1, 0);
+  CheckRun (n, false, "FailLink of a down link, ends swapped");
+  n.RestoreLink (0, 1);
+  NS_TEST_EXPECT_MSG_EQ (n.IsUp (0, 1), true, "RestoreLink left the link down");
+  CheckRun (n, true, "RestoreLink of a down link");
+  uint64_t checksum = n.GetChecksum ();
+  n.RestoreLink (0, 1);
+  CheckRun (n, false, "RestoreLink of an up link");
+  n.RestoreLink (2, 3);
+  CheckRun (n, false, "RestoreLink of a link that never failed");
+  NS_TEST_EXPECT_MSG_EQ (n.GetChecksum (), checksum, "Restoring up links changed the tables");
+
+  n.FailNode (2);
+  NS_TEST_EXPECT_MSG_EQ (n.IsNodeUp (2), false, "FailNode left the node up");
+  CheckRun (n, true, "FailNode of an up node");
+  n.FailNode (2);
+  CheckRun (n, false, "FailNode of a down node");
+  n.FailLink (2, 3);
+  CheckRun (n, false, "FailLink of a link of a down node");
+  n.RestoreLink (1, 2);
+  NS_TEST_EXPECT_MSG_EQ (n.IsUp (1, 2), false, "RestoreLink brought up a link of a down node");
+  CheckRun (n, false, "RestoreLink of a link of a down node");
+  n.RestoreNode (2);
+  NS_TEST_EXPECT_MSG_EQ (n.IsUp (1, 2), true, "RestoreNode left a link down");
+  NS_TEST_EXPECT_MSG_EQ (n.IsUp (2, 3), false, "RestoreNode brought up a failed link");
+  CheckRun (n, true, "RestoreNode of a down node");
+  n.RestoreNode (2);
+  CheckRun (n, false, "RestoreNode of an up node");
+  n.RestoreLink (2, 3);
+  CheckRun (n, true, "RestoreLink of a link failed while its node was down");
+}
+
+/**
+ * \ingroup bsdvr
+ * \brief BsdvrEngineNetwork queues pending replies and fires them when quiet
+ *
+ * On a ring of 5 nodes, node 3 reaches node 0 through node 4. An INACTIVE
+ * UPDATE about node 0 from node 2 has node 3 queue a pending reply rather
+ * than answer at once; a second one is not queued twice. The reply timer
+ * fires once the network is quiet and node 3 sends its UPDATE.
+ */
+class BsdvrEngineNetworkPendingReplyTestCase : public TestCase
+{
+public:
+  BsdvrEngineNetworkPendingReplyTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BsdvrEngineNetworkPendingReplyTestCase::BsdvrEngineNetworkPendingReplyTestCase ()
+  : TestCase ("BsdvrEngineNetwork queues pending replies and fires them when quiet")
+{
+}
+
+void
+BsdvrEngineNetworkPendingReplyTestCase::DoRun (void)
+{
+  BsdvrEngineNetwork n (5, bsdvr::constants::BSDVR_THRESHOLD);
+  BuildRing (n);
+  n.Start ();
+  NS_TEST_ASSERT_MSG_EQ (n.Run (MAX_EVENTS), true, "No convergence after Start");
+  NS_TEST_ASSERT_MSG_EQ (n.GetPendingReplies (), 0, "Pending replies without INACTIVE UPDATEs");
+  uint64_t checksum = n.GetChecksum ();
+  uint64_t events = n.GetEvents ();
+  uint64_t messages = n.GetMessages ();
+
+  n.InjectUpdate (2, 3, 0, bsdvr::UPDATE_STATE_INACTIVE);
+  n.InjectUpdate (2, 3, 0, bsdvr::UPDATE_STATE_INACTIVE);
+  NS_TEST_ASSERT_MSG_EQ (n.Run (MAX_EVENTS), true, "No convergence after the INACTIVE UPDATEs");
+  NS_TEST_EXPECT_MSG_EQ (n.GetPendingReplies (), 1, "One pending reply per neighbor and destination");
+  NS_TEST_EXPECT_MSG_EQ (n.GetStatistics ().m_pendingReplyExpirations, 1, "The pending reply timer did not fire");
+  // Both UPDATEs, the timer and the reply it sends
+  NS_TEST_EXPECT_MSG_EQ (n.GetEvents () - events, 4, "Events of the pending reply");
+  NS_TEST_EXPECT_MSG_EQ (n.GetMessages () - messages, 1, "The pending reply was not sent");
+  NS_TEST_EXPECT_MSG_EQ (n.GetChecksum (), checksum, "The pending reply changed the tables");
+
+  n.InjectUpdate (2, 3, 0, bsdvr::UPDATE_STATE_INACTIVE);
+  NS_TEST_ASSERT_MSG_EQ (n.Run (MAX_EVENTS), true, "No convergence after the INACTIVE UPDATE");
+  NS_TEST_EXPECT_MSG_EQ (n.GetPendingReplies (), 2, "A fired pending reply can be queued again");
+  n.FailLink (2, 3);
+  NS_TEST_ASSERT_MSG_EQ (n.Run (MAX_EVENTS), true, "No convergence after the link failure");
+  events = n.GetEvents ();
+  n.InjectUpdate (2, 3, 0, bsdvr::UPDATE_STATE_INACTIVE);
+  n.Run (MAX_EVENTS);
+  NS_TEST_EXPECT_MSG_EQ (n.GetEvents (), events, "An UPDATE was injected over a down link");
+}
+
+/**
+ * \ingroup bsdvr
+ * \brief Runs RoutingProtocol on static ad-hoc WiFi nodes and checks their forwarding tables
+ *
+ * Unlike the golden scenarios, the HELLOs and UPDATEs go over the air and
+ * through the whole protocol: neighbor table, split horizon, sequencing,
+ * pending reply queue, with the default attributes. A unit disk radio links
+ * the nodes within range of each other. Every node must end with an ACTIVE
+ * route to each of its neighbors, and every ACTIVE route must go through a
+ * neighbor and be no shorter than the shortest path.
+ */
+class BsdvrProtocolTestCase : public TestCase
+{
+public:
+  /**
+   * constructor
+   * \param name the topology name
+   * \param positions the node positions
+   * \param range the radio range, in meters
+   */
+  BsdvrProtocolTestCase (std::string name, std::vector<Vector> positions, double range);
+
+private:
+  virtual void DoRun (void);
+
+  std::vector<Vector> m_positions;  ///< node positions
+  double m_range;                   ///< radio range, in meters
+};
+
+BsdvrProtocolTestCase::BsdvrProtocolTestCase (std::string name, std::vector<Vector> positions, double range)
+  : TestCase ("RoutingProtocol forwarding tables: " + name),
+    m_positions (positions),
+    m_range (range)
 {
 }
 
-//
-// This method is the pure virtual method from class TestCase that every
-// TestCase must implement
-//
 void
-BsdvrTestCase1::DoRun (void)
+BsdvrProtocolTestCase::DoRun (void)
 {
-  // A wide variety of test macros are available in src/core/test.h
-  NS_TEST_ASSERT_MSG_EQ (true, true, "true doesn't equal true for some reason");
-  // Use this one for floating point comparisons
-  NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+  uint32_t size = m_positions.size ();
+  NodeContainer nodes;
+  nodes.Create (size);
+  Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator> ();
+  for (std::vector<Vector>::const_iterator p = m_positions.begin (); p != m_positions.end (); ++p)
+    {
+      positions->Add (*p);
+    }
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator (positions);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_STANDARD_80211a);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode", StringValue ("OfdmRate6Mbps"),
+                                "ControlMode", StringValue ("OfdmRate6Mbps"));
+  YansWifiChannelHelper channel;
+  channel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  channel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (m_range));
+  YansWifiPhyHelper phy;
+  phy.SetChannel (channel.Create ());
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+
+  BsdvrHelper bsdvr;
+  InternetStackHelper internet;
+  internet.SetRoutingHelper (bsdvr);
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  // Outside the 10.1.1.x range excluded from link failure handling
+  address.SetBase ("10.0.0.0", "255.255.0.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+  bsdvr.AssignStreams (nodes, 0);
+
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+
+  // Hop distances over the links of the unit disk
+  const uint32_t unreachable = std::numeric_limits<uint32_t>::max () / 2;
+  std::vector<std::vector<uint32_t> > distance (size, std::vector<uint32_t> (size, unreachable));
+  for (uint32_t i = 0; i < size; i++)
+    {
+      for (uint32_t j = 0; j < size; j++)
+        {
+          if (i == j)
+            {
+              distance[i][j] = 0;
+            }
+          else if (CalculateDistance (m_positions[i], m_positions[j]) <= m_range)
+            {
+              distance[i][j] = 1;
+            }
+        }
+    }
+  for (uint32_t k = 0; k < size; k++)
+    {
+      for (uint32_t i = 0; i < size; i++)
+        {
+          for (uint32_t j = 0; j < size; j++)
+            {
+              distance[i][j] = std::min (distance[i][j], distance[i][k] + distance[k][j]);
+            }
+        }
+    }
+  std::map<Ipv4Address, uint32_t> index;
+  for (uint32_t i = 0; i < size; i++)
+    {
+      index[interfaces.GetAddress (i)] = i;
+    }
+
+  for (uint32_t i = 0; i < size; i++)
+    {
+      std::map<Ipv4Address, bsdvr::RoutingTableEntry> const * ft =
+        BsdvrHelper::GetRoutingProtocol (nodes.Get (i))->GetRoutingTable ().GetForwardingTable ();
+      for (uint32_t j = 0; j < size; j++)
+        {
+          if (distance[i][j] != 1)
+            {
+              continue;
+            }
+          std::map<Ipv4Address, bsdvr::RoutingTableEntry>::const_iterator e = ft->find (interfaces.GetAddress (j));
+          NS_TEST_EXPECT_MSG_EQ ((e != ft->end () && e->second.GetRouteState () == bsdvr::ACTIVE), true,
+                                 "Node " << i << " has no ACTIVE route to its neighbor " << j);
+        }
+      for (std::map<Ipv4Address, bsdvr::RoutingTableEntry>::const_iterator e = ft->begin (); e != ft->end (); ++e)
+        {
+          std::map<Ipv4Address, uint32_t>::const_iterator dst = index.find (e->first);
+          if (dst == index.end () || dst->second == i || e->second.GetRouteState () != bsdvr::ACTIVE)
+            {
+              continue;
+            }
+          std::map<Ipv4Address, uint32_t>::const_iterator next = index.find (e->second.GetNextHop ());
+          NS_TEST_EXPECT_MSG_EQ ((next != index.end () && distance[i][next->second] == 1), true,
+                                 "Node " << i << " routes to " << dst->second << " through "
+                                         << e->second.GetNextHop () << ", not a neighbor");
+          NS_TEST_EXPECT_MSG_GT_OR_EQ (e->second.GetHop (), distance[i][dst->second],
+                                       "Node " << i << " has a route to " << dst->second
+                                               << " shorter than the shortest path");
+        }
+    }
+  Simulator::Destroy ();
 }
 
-// The TestSuite class names the TestSuite, identifies what type of TestSuite,
-// and enables the TestCases to be run.  Typically, only the constructor for
-// this class must be defined
-//
+/**
+ * \ingroup bsdvr
+ * \brief BSDVR test suite
+ */
 class BsdvrTestSuite : public TestSuite
 {
 public:
@@ -59,10 +796,21 @@ public:
 BsdvrTestSuite::BsdvrTestSuite ()
   : TestSuite ("bsdvr", UNIT)
 {
-  // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
-  AddTestCase (new BsdvrTestCase1, TestCase::QUICK);
+  AddTestCase (new BsdvrHelloHeaderTestCase, TestCase::QUICK);
+  AddTestCase (new BsdvrEngineNetworkLinkStateTestCase, TestCase::QUICK);
+  AddTestCase (new BsdvrEngineNetworkPendingReplyTestCase, TestCase::QUICK);
+  // Unit disk of 150 m: only the nodes 100 m apart are linked
+  AddTestCase (new BsdvrProtocolTestCase ("line", LinePositions (5, 100), 150), TestCase::QUICK);
+  AddTestCase (new BsdvrProtocolTestCase ("ring", RingPositions (6, 100), 150), TestCase::QUICK);
+  AddTestCase (new BsdvrGoldenTestCase ("line", &Line, LINE_GOLDEN), TestCase::QUICK);
+  AddTestCase (new BsdvrGoldenTestCase ("ring", &Ring, RING_GOLDEN), TestCase::QUICK);
+  AddTestCase (new BsdvrGoldenTestCase ("diamond", &Diamond, DIAMOND_GOLDEN), TestCase::QUICK);
+  AddTestCase (new BsdvrGoldenTestCase ("partitioned", &Partitioned, PARTITIONED_GOLDEN), TestCase::QUICK);
+  AddTestCase (new BsdvrGoldenTestCase ("split", &Split, SPLIT_GOLDEN), TestCase::QUICK);
+  AddTestCase (new BsdvrGoldenTestCase ("long line and ring", &LongLineAndRing, LONG_LINE_AND_RING_GOLDEN),
+               TestCase::EXTENSIVE);
+  AddTestCase (new BsdvrGoldenTestCase ("grid churn", &GridChurn, GRID_CHURN_GOLDEN), TestCase::QUICK);
+  AddTestCase (new BsdvrGoldenTestCase ("node churn", &NodeChurn, NODE_CHURN_GOLDEN), TestCase::QUICK);
 }
 
-// Do not forget to allocate an instance of this TestSuite
 static BsdvrTestSuite sbsdvrTestSuite;
-